@@ -0,0 +1,855 @@
+// ------------------------------------------------------------- Project Headers
+#include "Analysis.h"
+#include "IR.h"
+
+// ---------------------------------------------------------- C++ System Headers
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// struct Loop                                                                //
+////////////////////////////////////////////////////////////////////////////////
+
+// ----------------------------------------------------- Public Member Functions
+bool Loop::contains(const BasicBlock* bb) const
+{
+    return block_set.count(bb) != 0;
+}
+
+std::vector<BasicBlock*> Loop::get_exit_blocks() const
+{
+    std::vector<BasicBlock*> exits;
+    for (const BasicBlock* bb : blocks)
+    {
+        for (BasicBlock* successor : bb->get_successors())
+        {
+            if (!contains(successor) && std::find(exits.begin(), exits.end(), successor) == exits.end())
+                exits.push_back(successor);
+        }
+    }
+    return exits;
+}
+
+std::vector<BasicBlock*> Loop::get_path() const
+{
+    if (latches.size() != 1)
+        return {};
+    std::vector<BasicBlock*> path{header};
+    while (path.back() != latches.front())
+    {
+        const BasicBlock* bb = path.back();
+        if (bb->exit_false != nullptr || !contains(bb->exit_true) || path.size() == blocks.size())
+            return {};
+        path.push_back(bb->exit_true);
+    }
+    if (path.size() != blocks.size())
+        return {};
+    return path;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class LoopInfo                                                             //
+////////////////////////////////////////////////////////////////////////////////
+
+// ----------------------------------------------------------------- Constructor
+LoopInfo::LoopInfo(CFG* cfg)
+{
+    compute_reverse_post_order(cfg->get_entry_bb());
+    compute_dominators();
+    compute_loops();
+
+    // layout order is more convenient for the passes that copy loops
+    for (Loop &loop : loops)
+    {
+        for (BasicBlock* bb : cfg->get_bbs())
+        {
+            if (loop.contains(bb))
+                loop.blocks.push_back(bb);
+        }
+    }
+}
+
+// ----------------------------------------------------- Public Member Functions
+const std::vector<Loop>& LoopInfo::get_loops() const
+{
+    return loops;
+}
+
+const std::vector<BasicBlock*>& LoopInfo::get_predecessors(const BasicBlock* bb) const
+{
+    auto it = predecessors.find(bb);
+    return it != predecessors.end() ? it->second : no_predecessors;
+}
+
+const std::vector<BasicBlock*>& LoopInfo::get_reverse_post_order() const
+{
+    return reverse_post_order;
+}
+
+bool LoopInfo::is_reachable(const BasicBlock* bb) const
+{
+    return rpo_index.count(bb) != 0;
+}
+
+bool LoopInfo::dominates(const BasicBlock* a, const BasicBlock* b) const
+{
+    if (!is_reachable(a) || !is_reachable(b))
+        return false;
+    return dominators[rpo_index.at(b)][rpo_index.at(a)];
+}
+
+const Loop* LoopInfo::get_innermost_loop(const BasicBlock* bb) const
+{
+    for (const Loop &loop : loops)
+    {
+        if (loop.contains(bb))
+            return &loop;
+    }
+    return nullptr;
+}
+
+// ---------------------------------------------------- Private Member Functions
+void LoopInfo::compute_reverse_post_order(BasicBlock* entry)
+{
+    // iterative depth first search, to stay away from the native stack limits
+    std::vector<BasicBlock*> post_order;
+    std::set<const BasicBlock*> visited;
+    std::vector<std::pair<BasicBlock*, size_t>> stack;
+    stack.push_back(std::make_pair(entry, 0));
+    visited.insert(entry);
+    while (!stack.empty())
+    {
+        BasicBlock* bb = stack.back().first;
+        std::vector<BasicBlock*> successors = bb->get_successors();
+        if (stack.back().second < successors.size())
+        {
+            BasicBlock* successor = successors[stack.back().second++];
+            predecessors[successor].push_back(bb);
+            if (visited.insert(successor).second)
+                stack.push_back(std::make_pair(successor, 0));
+        }
+        else
+        {
+            post_order.push_back(bb);
+            stack.pop_back();
+        }
+    }
+    reverse_post_order.assign(post_order.rbegin(), post_order.rend());
+    for (size_t i=0; i<reverse_post_order.size(); ++i)
+    {
+        rpo_index[reverse_post_order[i]] = i;
+    }
+}
+
+void LoopInfo::compute_dominators()
+{
+    const size_t n = reverse_post_order.size();
+    dominators.assign(n, std::vector<bool>(n, true));
+    dominators[0].assign(n, false);
+    dominators[0][0] = true;
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (size_t i=1; i<n; ++i)
+        {
+            std::vector<bool> dom(n, true);
+            for (const BasicBlock* predecessor : get_predecessors(reverse_post_order[i]))
+            {
+                const std::vector<bool> &pred_dom = dominators[rpo_index.at(predecessor)];
+                for (size_t j=0; j<n; ++j)
+                    dom[j] = dom[j] && pred_dom[j];
+            }
+            dom[i] = true;
+            if (dom != dominators[i])
+            {
+                dominators[i] = dom;
+                changed = true;
+            }
+        }
+    }
+}
+
+void LoopInfo::compute_loops()
+{
+    std::map<BasicBlock*, size_t> loop_of_header;
+    for (BasicBlock* bb : reverse_post_order)
+    {
+        for (BasicBlock* successor : bb->get_successors())
+        {
+            if (!dominates(successor, bb))
+                continue;
+
+            // back edge bb -> successor
+            auto it = loop_of_header.find(successor);
+            if (it == loop_of_header.end())
+            {
+                it = loop_of_header.insert(std::make_pair(successor, loops.size())).first;
+                loops.push_back(Loop());
+                loops.back().header = successor;
+                loops.back().block_set.insert(successor);
+            }
+            Loop &loop = loops[it->second];
+            loop.latches.push_back(bb);
+
+            std::vector<BasicBlock*> worklist;
+            if (loop.block_set.insert(bb).second)
+                worklist.push_back(bb);
+            while (!worklist.empty())
+            {
+                BasicBlock* current = worklist.back();
+                worklist.pop_back();
+                for (BasicBlock* predecessor : get_predecessors(current))
+                {
+                    if (loop.block_set.insert(predecessor).second)
+                        worklist.push_back(predecessor);
+                }
+            }
+        }
+    }
+
+    std::stable_sort(loops.begin(), loops.end(), [](const Loop &a, const Loop &b) -> bool
+        {
+            return a.block_set.size() < b.block_set.size();
+        }
+    );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// struct AffineExpr                                                          //
+////////////////////////////////////////////////////////////////////////////////
+
+// ----------------------------------------------------------------- Constructor
+AffineExpr::AffineExpr(int64_t constant) :
+    constant(constant)
+{}
+
+// ----------------------------------------------------- Public Member Functions
+AffineExpr AffineExpr::variable(const std::string &name)
+{
+    AffineExpr expr;
+    expr.terms[name] = 1;
+    return expr;
+}
+
+bool AffineExpr::is_constant() const
+{
+    return terms.empty();
+}
+
+// -------------------------------------------------------- Overloaded Operators
+// the computations wrap around like the generated code, through unsigned integers
+AffineExpr& AffineExpr::operator+=(const AffineExpr &other)
+{
+    constant = static_cast<int64_t>(static_cast<uint64_t>(constant) + static_cast<uint64_t>(other.constant));
+    for (const auto &term : other.terms)
+    {
+        int64_t coefficient = static_cast<int64_t>(static_cast<uint64_t>(terms[term.first]) + static_cast<uint64_t>(term.second));
+        if (coefficient == 0)
+            terms.erase(term.first);
+        else
+            terms[term.first] = coefficient;
+    }
+    return *this;
+}
+
+AffineExpr& AffineExpr::operator-=(const AffineExpr &other)
+{
+    AffineExpr opposite(other);
+    opposite *= -1;
+    return *this += opposite;
+}
+
+AffineExpr& AffineExpr::operator*=(int64_t factor)
+{
+    constant = static_cast<int64_t>(static_cast<uint64_t>(constant) * static_cast<uint64_t>(factor));
+    for (auto it = terms.begin(); it != terms.end(); )
+    {
+        it->second = static_cast<int64_t>(static_cast<uint64_t>(it->second) * static_cast<uint64_t>(factor));
+        if (it->second == 0)
+            it = terms.erase(it);
+        else
+            ++it;
+    }
+    return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// struct LoopEvolution                                                       //
+////////////////////////////////////////////////////////////////////////////////
+
+// ----------------------------------------------------- Public Member Functions
+bool LoopEvolution::get_constant_trip_count(int64_t &count) const
+{
+    if (!has_trip_count || !distance.is_constant())
+        return false;
+    int64_t backedge_count = distance.constant;
+    if (clamped)
+        backedge_count = backedge_count > 0 ? (backedge_count + stride - 1) / stride : 0;
+    count = backedge_count + 1;
+    return true;
+}
+
+bool LoopEvolution::is_removable() const
+{
+    return has_trip_count && !has_side_effects && unknown_variables.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class ScalarEvolution                                                      //
+////////////////////////////////////////////////////////////////////////////////
+
+// ----------------------------------------------------------------- Constructor
+ScalarEvolution::ScalarEvolution(const LoopInfo &loop_info)
+{
+    for (const Loop &loop : loop_info.get_loops())
+    {
+        LoopEvolution evolution;
+        if (analyze(loop, evolution))
+            evolutions[loop.header] = evolution;
+    }
+}
+
+// ----------------------------------------------------- Public Member Functions
+const LoopEvolution* ScalarEvolution::get_evolution(const Loop &loop) const
+{
+    auto it = evolutions.find(loop.header);
+    return it != evolutions.end() ? &it->second : nullptr;
+}
+
+// ---------------------------------------------------- Private Member Functions
+bool ScalarEvolution::analyze(const Loop &loop, LoopEvolution &evolution)
+{
+    std::vector<BasicBlock*> path = loop.get_path();
+    if (path.empty() || !path.back()->is_conditional())
+        return false;
+    BasicBlock* latch = path.back();
+    const bool continue_if_true = latch->exit_true == loop.header;
+    evolution.exit = continue_if_true ? latch->exit_false : latch->exit_true;
+    if (loop.contains(evolution.exit))
+        return false;
+
+    // symbolic evaluation of one iteration
+    evolution.has_side_effects = false;
+    std::map<std::string, Value> values;
+    for (const BasicBlock* bb : path)
+    {
+        for (const IRInstr* instr : bb->instrs)
+        {
+            Value value;
+            value.kind = Value::AFFINE;
+            switch (instr->get_operation())
+            {
+                case IRInstr::Operation::ldconst:
+                    value.expr = AffineExpr(instr->get_operand(1).value);
+                break;
+                case IRInstr::Operation::add:
+                case IRInstr::Operation::sub:
+                {
+                    Value lhs = get_value(values, instr->get_param(1));
+                    Value rhs = get_value(values, instr->get_param(2));
+                    if (lhs.kind != Value::AFFINE || rhs.kind != Value::AFFINE)
+                    {
+                        value.kind = Value::UNKNOWN;
+                        break;
+                    }
+                    value.expr = lhs.expr;
+                    if (instr->get_operation() == IRInstr::Operation::add)
+                        value.expr += rhs.expr;
+                    else
+                        value.expr -= rhs.expr;
+                }
+                break;
+                case IRInstr::Operation::mul:
+                {
+                    Value lhs = get_value(values, instr->get_param(1));
+                    Value rhs = get_value(values, instr->get_param(2));
+                    if (lhs.kind != Value::AFFINE || rhs.kind != Value::AFFINE || (!lhs.expr.is_constant() && !rhs.expr.is_constant()))
+                    {
+                        value.kind = Value::UNKNOWN;
+                        break;
+                    }
+                    value.expr = lhs.expr.is_constant() ? rhs.expr : lhs.expr;
+                    value.expr *= lhs.expr.is_constant() ? lhs.expr.constant : rhs.expr.constant;
+                }
+                break;
+                case IRInstr::Operation::neg:
+                    value = get_value(values, instr->get_param(1));
+                    value.expr *= -1;
+                    if (value.kind != Value::AFFINE)
+                        value.kind = Value::UNKNOWN;
+                break;
+                case IRInstr::Operation::rmem:
+                case IRInstr::Operation::wmem:
+                    value = get_value(values, instr->get_param(1));
+                break;
+                case IRInstr::Operation::pre_pp:
+                case IRInstr::Operation::pre_mm:
+                    value = get_value(values, instr->get_param(0));
+                    value.expr += AffineExpr(instr->get_operation() == IRInstr::Operation::pre_pp ? 1 : -1);
+                    if (value.kind != Value::AFFINE)
+                        value.kind = Value::UNKNOWN;
+                break;
+                case IRInstr::Operation::cmp_eq:
+                case IRInstr::Operation::cmp_lt:
+                case IRInstr::Operation::cmp_le:
+                case IRInstr::Operation::cmp_gt:
+                case IRInstr::Operation::cmp_ge:
+                case IRInstr::Operation::cmp_ne:
+                {
+                    Value lhs = get_value(values, instr->get_param(1));
+                    Value rhs = get_value(values, instr->get_param(2));
+                    if (lhs.kind != Value::AFFINE || rhs.kind != Value::AFFINE)
+                    {
+                        value.kind = Value::UNKNOWN;
+                        break;
+                    }
+                    value.kind = Value::COMPARISON;
+                    value.comparison = instr->get_operation();
+                    value.expr = lhs.expr;
+                    value.expr -= rhs.expr;
+                }
+                break;
+                case IRInstr::Operation::ret:
+                    return false;
+                case IRInstr::Operation::call:
+                case IRInstr::Operation::counter_inc:
+                case IRInstr::Operation::div:
+                case IRInstr::Operation::mod:
+                    evolution.has_side_effects = true;
+                    value.kind = Value::UNKNOWN;
+                break;
+                default:
+                    value.kind = Value::UNKNOWN;
+                break;
+            }
+            for (const std::string &var : instr->get_written_vars())
+            {
+                values[var] = value;
+                if (!fits_in_type(value, bb->cfg->get_var_type(var), bb->cfg))
+                    values[var].kind = Value::UNKNOWN;
+            }
+        }
+    }
+
+    // temporaries die with the statement computing them, only the named variables matter
+    std::map<std::string, AffineExpr> updates;
+    for (const auto &entry : values)
+    {
+        if (entry.first[0] == '!')
+            continue;
+        if (entry.second.kind == Value::AFFINE)
+            updates[entry.first] = entry.second.expr;
+        else
+            evolution.unknown_variables.insert(entry.first);
+    }
+
+    // first order recurrences: var = var + c, var = var * 2^k
+    std::map<std::string, Recurrence> induction_variables;
+    for (const auto &update : updates)
+    {
+        const AffineExpr &expr = update.second;
+        auto self = expr.terms.find(update.first);
+        if (expr.terms.size() != 1 || self == expr.terms.end())
+            continue;
+        Recurrence recurrence;
+        recurrence.start = AffineExpr::variable(update.first);
+        recurrence.step2 = 0;
+        recurrence.shift = 0;
+        if (self->second == 1)
+        {
+            recurrence.kind = Recurrence::ADD;
+            recurrence.step = AffineExpr(expr.constant);
+            induction_variables[update.first] = recurrence;
+        }
+        else if (expr.constant == 0 && self->second > 1 && (self->second & (self->second - 1)) == 0)
+        {
+            recurrence.kind = Recurrence::MUL;
+            while ((int64_t(1) << recurrence.shift) != self->second)
+                ++recurrence.shift;
+            evolution.recurrences[update.first] = recurrence;
+        }
+    }
+    evolution.recurrences.insert(induction_variables.begin(), induction_variables.end());
+
+    // the others may depend on invariants and induction variables only
+    for (const auto &update : updates)
+    {
+        if (evolution.recurrences.count(update.first))
+            continue;
+        AffineExpr expr = update.second;
+        int64_t self = 0;
+        int64_t growth = 0; // of expr, from one iteration to the next
+        bool known = true;
+        for (const auto &term : expr.terms)
+        {
+            if (term.first == update.first)
+                self = term.second;
+            else if (induction_variables.count(term.first))
+                growth += term.second * induction_variables[term.first].step.constant;
+            else if (values.count(term.first))
+                known = false;
+        }
+        Recurrence recurrence;
+        recurrence.kind = Recurrence::ADD;
+        recurrence.shift = 0;
+        if (known && self == 1)
+        {
+            // accumulation: var = var + expr
+            recurrence.start = AffineExpr::variable(update.first);
+            expr -= recurrence.start;
+            recurrence.step = expr;
+            recurrence.step2 = growth;
+        }
+        else if (known && self == 0)
+        {
+            // computed again at each iteration: the value of the last one remains
+            recurrence.start = expr;
+            recurrence.start -= AffineExpr(growth);
+            recurrence.step = AffineExpr(growth);
+            recurrence.step2 = 0;
+        }
+        else
+        {
+            evolution.unknown_variables.insert(update.first);
+            continue;
+        }
+        evolution.recurrences[update.first] = recurrence;
+    }
+
+    const IRInstr* test = latch->instrs.back();
+    evolution.has_trip_count = compute_trip_count(get_value(values, test->get_param(0)), continue_if_true, induction_variables, evolution);
+    return true;
+}
+
+ScalarEvolution::Value ScalarEvolution::get_value(const std::map<std::string, Value> &values, const std::string &var)
+{
+    auto it = values.find(var);
+    if (it != values.end())
+        return it->second;
+    Value value;
+    // a temporary read before being written comes from another statement
+    value.kind = var[0] == '!' ? Value::UNKNOWN : Value::AFFINE;
+    value.expr = AffineExpr::variable(var);
+    return value;
+}
+
+bool ScalarEvolution::fits_in_type(const Value &value, Type type, const CFG* cfg)
+{
+    // c = c + 50 on a char wraps around, the affine expressions do not
+    if (type == Type::INT_64 || value.kind != Value::AFFINE)
+        return true;
+    const int64_t max = (int64_t(1) << (8 * types.at(type).size - 1)) - 1;
+    if (value.expr.is_constant())
+        return value.expr.constant >= -max - 1 && value.expr.constant <= max;
+    if (value.expr.constant != 0 || value.expr.terms.size() != 1 || value.expr.terms.begin()->second != 1)
+        return false;
+    return types.at(cfg->get_var_type(value.expr.terms.begin()->first)).size <= types.at(type).size;
+}
+
+bool ScalarEvolution::compute_trip_count(const Value &condition, bool continue_if_true, const std::map<std::string, Recurrence> &induction_variables, LoopEvolution &evolution)
+{
+    if (condition.kind == Value::UNKNOWN)
+        return false;
+
+    // the loop goes on while (difference + slope * k) compared to 0 holds, k counting the iterations done
+    IRInstr::Operation comparison = condition.kind == Value::AFFINE ? IRInstr::Operation::cmp_ne : condition.comparison;
+    AffineExpr difference = condition.expr;
+    int64_t slope = 0;
+    for (const auto &term : difference.terms)
+    {
+        auto it = induction_variables.find(term.first);
+        if (it != induction_variables.end())
+            slope += term.second * it->second.step.constant;
+        else if (evolution.recurrences.count(term.first) || evolution.unknown_variables.count(term.first))
+            return false;
+    }
+
+    if (!continue_if_true)
+    {
+        switch (comparison)
+        {
+            case IRInstr::Operation::cmp_eq: comparison = IRInstr::Operation::cmp_ne; break;
+            case IRInstr::Operation::cmp_ne: comparison = IRInstr::Operation::cmp_eq; break;
+            case IRInstr::Operation::cmp_lt: comparison = IRInstr::Operation::cmp_ge; break;
+            case IRInstr::Operation::cmp_le: comparison = IRInstr::Operation::cmp_gt; break;
+            case IRInstr::Operation::cmp_gt: comparison = IRInstr::Operation::cmp_le; break;
+            case IRInstr::Operation::cmp_ge: comparison = IRInstr::Operation::cmp_lt; break;
+            default: return false;
+        }
+    }
+
+    // everything is brought back to difference < 0, or difference != 0
+    switch (comparison)
+    {
+        case IRInstr::Operation::cmp_le:
+            difference -= AffineExpr(1);
+            comparison = IRInstr::Operation::cmp_lt;
+        break;
+        case IRInstr::Operation::cmp_gt:
+            difference *= -1;
+            slope = -slope;
+            comparison = IRInstr::Operation::cmp_lt;
+        break;
+        case IRInstr::Operation::cmp_ge:
+            difference *= -1;
+            difference -= AffineExpr(1);
+            slope = -slope;
+            comparison = IRInstr::Operation::cmp_lt;
+        break;
+        default:
+        break;
+    }
+
+    evolution.distance = difference;
+    if (comparison == IRInstr::Operation::cmp_lt && slope > 0)
+    {
+        evolution.distance *= -1;
+        evolution.stride = slope;
+        evolution.clamped = true;
+        return true;
+    }
+    if (comparison == IRInstr::Operation::cmp_ne && (slope == 1 || slope == -1))
+    {
+        evolution.distance *= -slope;
+        evolution.stride = 1;
+        evolution.clamped = false;
+        return true;
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class BlockFrequency                                                       //
+////////////////////////////////////////////////////////////////////////////////
+
+// probabilities of the heuristics, for the successor they favour
+static const double LOOP_BRANCH_PROBABILITY = 0.88;
+static const double LOOP_EXIT_PROBABILITY = 0.80;
+static const double LOOP_HEADER_PROBABILITY = 0.75;
+static const double OPCODE_PROBABILITY = 0.84;
+static const double CALL_PROBABILITY = 0.78;
+static const double RETURN_PROBABILITY = 0.72;
+
+// ----------------------------------------------------------------- Constructor
+BlockFrequency::BlockFrequency(CFG* cfg) :
+    loop_info(cfg)
+{
+    compute_probabilities();
+    compute_frequencies();
+}
+
+// ----------------------------------------------------- Public Member Functions
+double BlockFrequency::get_probability(const BasicBlock* from, const BasicBlock* to) const
+{
+    // nothing runs after a return, even if the block was given a successor
+    if (!to || (to != from->exit_true && to != from->exit_false) || has_operation(from, IRInstr::ret))
+        return 0;
+    auto it = true_probabilities.find(from);
+    if (it == true_probabilities.end())
+        return 1;
+    return to == from->exit_true ? it->second : 1 - it->second;
+}
+
+double BlockFrequency::get_frequency(const BasicBlock* bb) const
+{
+    auto it = frequencies.find(bb);
+    return it != frequencies.end() ? it->second : 0;
+}
+
+double BlockFrequency::get_edge_frequency(const BasicBlock* from, const BasicBlock* to) const
+{
+    return get_frequency(from) * get_probability(from, to);
+}
+
+// ---------------------------------------------------- Private Member Functions
+void BlockFrequency::compute_probabilities()
+{
+    for (const BasicBlock* bb : loop_info.get_reverse_post_order())
+    {
+        if (bb->get_successors().size() == 2)
+            true_probabilities[bb] = compute_branch_probability(bb);
+    }
+}
+
+double BlockFrequency::compute_branch_probability(const BasicBlock* bb) const
+{
+    // the programmer knows better
+    double expected;
+    if (bb->is_conditional() && bb->instrs.back()->get_expected_probability(expected))
+        return expected;
+
+    // each heuristic gives the probability of exit_true, 0.5 when it does not apply
+    const BasicBlock* successors[2] = {bb->exit_true, bb->exit_false};
+    auto favour = [](bool first, bool second, double probability) -> double
+        {
+            if (first == second)
+                return 0.5;
+            return first ? probability : 1 - probability;
+        };
+
+    const Loop* loop = loop_info.get_innermost_loop(bb);
+    bool back_edge[2], exits[2], enters[2], calls[2], returns[2];
+    for (int i=0; i<2; ++i)
+    {
+        const Loop* successor_loop = loop_info.get_innermost_loop(successors[i]);
+        back_edge[i] = loop_info.dominates(successors[i], bb);
+        exits[i] = loop && !loop->contains(successors[i]);
+        enters[i] = successor_loop && successor_loop->header == successors[i] && !successor_loop->contains(bb);
+        calls[i] = has_operation(successors[i], IRInstr::call);
+        returns[i] = has_operation(successors[i], IRInstr::ret) || successors[i]->get_successors().empty();
+    }
+
+    double probability = 0.5;
+    probability = combine(probability, favour(back_edge[0], back_edge[1], LOOP_BRANCH_PROBABILITY));
+    probability = combine(probability, favour(!exits[0], !exits[1], LOOP_EXIT_PROBABILITY));
+    probability = combine(probability, favour(enters[0], enters[1], LOOP_HEADER_PROBABILITY));
+    probability = combine(probability, get_opcode_probability(bb));
+    probability = combine(probability, favour(!calls[0], !calls[1], CALL_PROBABILITY));
+    probability = combine(probability, favour(!returns[0], !returns[1], RETURN_PROBABILITY));
+    return probability;
+}
+
+double BlockFrequency::get_opcode_probability(const BasicBlock* bb) const
+{
+    if (bb->instrs.empty())
+        return 0.5;
+
+    // the comparison deciding the branch, and the constants known in the block
+    const IRInstr* comparison = bb->instrs.back();
+    if (comparison->get_operation() == IRInstr::cmp_null)
+    {
+        const std::string &condition = comparison->get_param(0);
+        const IRInstr* definition = nullptr;
+        for (const IRInstr* instr : bb->instrs)
+        {
+            std::vector<std::string> written = instr->get_written_vars();
+            if (std::find(written.begin(), written.end(), condition) != written.end())
+                definition = instr;
+        }
+        if (!definition || definition->get_operation() < IRInstr::cmp_eq || definition->get_operation() > IRInstr::cmp_ne)
+        {
+            // if (x) is x != 0, if (!x) is x == 0
+            bool negated = definition && definition->get_operation() == IRInstr::lnot;
+            return negated ? 1 - OPCODE_PROBABILITY : OPCODE_PROBABILITY;
+        }
+        comparison = definition;
+    }
+    if (comparison->get_operation() < IRInstr::cmp_eq || comparison->get_operation() > IRInstr::cmp_ne)
+        return 0.5;
+
+    std::map<std::string, std::string> constants;
+    for (const IRInstr* instr : bb->instrs)
+    {
+        if (instr == comparison)
+            break;
+        for (const std::string &var : instr->get_written_vars())
+            constants.erase(var);
+        if (instr->get_operation() == IRInstr::ldconst)
+            constants[instr->get_param(0)] = instr->get_param(1);
+    }
+
+    // constant on the right hand side
+    IRInstr::Operation op = comparison->get_operation();
+    std::string rhs = comparison->get_param(2);
+    if (!constants.count(rhs))
+    {
+        rhs = comparison->get_param(1);
+        if (!constants.count(rhs))
+            return 0.5;
+        switch (op)
+        {
+            case IRInstr::cmp_lt: op = IRInstr::cmp_gt; break;
+            case IRInstr::cmp_le: op = IRInstr::cmp_ge; break;
+            case IRInstr::cmp_gt: op = IRInstr::cmp_lt; break;
+            case IRInstr::cmp_ge: op = IRInstr::cmp_le; break;
+            default: break;
+        }
+    }
+
+    const bool zero = constants[rhs] == "0";
+    switch (op)
+    {
+        case IRInstr::cmp_eq:
+            return 1 - OPCODE_PROBABILITY;
+        case IRInstr::cmp_ne:
+            return OPCODE_PROBABILITY;
+        case IRInstr::cmp_lt:
+        case IRInstr::cmp_le:
+            return zero ? 1 - OPCODE_PROBABILITY : 0.5;
+        case IRInstr::cmp_gt:
+        case IRInstr::cmp_ge:
+            return zero ? OPCODE_PROBABILITY : 0.5;
+        default:
+            return 0.5;
+    }
+}
+
+void BlockFrequency::compute_frequencies()
+{
+    // the innermost loops come first: the loops they contain already have their multiplier
+    const double max_cyclic_probability = 1 - 1.0 / MAX_LOOP_ITERATIONS;
+    for (const Loop &loop : loop_info.get_loops())
+    {
+        std::map<const BasicBlock*, double> local_frequencies;
+        propagate(loop.header, local_frequencies);
+        double cyclic_probability = 0;
+        for (const BasicBlock* latch : loop.latches)
+        {
+            cyclic_probability += local_frequencies[latch] * get_probability(latch, loop.header);
+        }
+        loop_multipliers[loop.header] = 1 / (1 - std::min(cyclic_probability, max_cyclic_probability));
+    }
+    propagate(nullptr, frequencies);
+}
+
+void BlockFrequency::propagate(const BasicBlock* header, std::map<const BasicBlock*, double> &result) const
+{
+    const Loop* loop = header ? loop_info.get_innermost_loop(header) : nullptr;
+    for (const BasicBlock* bb : loop_info.get_reverse_post_order())
+    {
+        if (loop && !loop->contains(bb))
+            continue;
+
+        double frequency = 0;
+        if (bb == header || bb == loop_info.get_reverse_post_order().front())
+            frequency = 1;
+        else
+        {
+            for (const BasicBlock* predecessor : loop_info.get_predecessors(bb))
+            {
+                // back edges are accounted for by the loop multipliers
+                if (!loop_info.dominates(bb, predecessor) && result.count(predecessor))
+                    frequency += result[predecessor] * get_probability(predecessor, bb);
+            }
+        }
+        if (bb != header)
+        {
+            auto it = loop_multipliers.find(bb);
+            if (it != loop_multipliers.end())
+                frequency *= it->second;
+        }
+        result[bb] = frequency;
+    }
+}
+
+double BlockFrequency::combine(double p1, double p2)
+{
+    return p1 * p2 / (p1 * p2 + (1 - p1) * (1 - p2));
+}
+
+bool BlockFrequency::has_operation(const BasicBlock* bb, IRInstr::Operation op)
+{
+    for (const IRInstr* instr : bb->instrs)
+    {
+        if (instr->get_operation() == op)
+            return true;
+    }
+    return false;
+}
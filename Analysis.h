@@ -0,0 +1,216 @@
+#pragma once
+
+// ---------------------------------------------------------- C++ System Headers
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------- Project Headers
+#include "IR.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// struct Loop                                                                //
+////////////////////////////////////////////////////////////////////////////////
+
+/** A natural loop of a CFG: the blocks of all the back edges towards its header */
+struct Loop {
+    // ------------------------------------------------- Public Member Functions
+    bool contains(const BasicBlock* bb) const;
+    std::vector<BasicBlock*> get_exit_blocks() const; /**< blocks outside the loop reached from inside */
+    std::vector<BasicBlock*> get_path() const; /**< blocks from the header to the only latch, empty if the loop has other branches */
+
+    // ------------------------------------------------------- Public Properties
+    BasicBlock* header;
+    std::vector<BasicBlock*> latches;  /**< sources of the back edges */
+    std::vector<BasicBlock*> blocks;   /**< all the blocks of the loop, in layout order */
+    std::set<const BasicBlock*> block_set;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// class LoopInfo                                                             //
+////////////////////////////////////////////////////////////////////////////////
+
+/* Dominators and natural loops of a CFG.
+     The analysis only considers the blocks reachable from the entry block and is
+     a snapshot: it must be computed again once a pass has modified the CFG.
+*/
+class LoopInfo {
+public:
+    // ------------------------------------------------------------- Constructor
+    LoopInfo(CFG* cfg);
+
+    // ------------------------------------------------- Public Member Functions
+    const std::vector<Loop>& get_loops() const; /**< innermost loops first */
+    const std::vector<BasicBlock*>& get_predecessors(const BasicBlock* bb) const;
+    const std::vector<BasicBlock*>& get_reverse_post_order() const;
+    bool is_reachable(const BasicBlock* bb) const;
+    bool dominates(const BasicBlock* a, const BasicBlock* b) const;
+    const Loop* get_innermost_loop(const BasicBlock* bb) const;
+private:
+    void compute_reverse_post_order(BasicBlock* entry);
+    void compute_dominators();
+    void compute_loops();
+
+    std::vector<BasicBlock*> reverse_post_order;
+    std::map<const BasicBlock*, size_t> rpo_index;
+    std::map<const BasicBlock*, std::vector<BasicBlock*>> predecessors;
+    std::vector<std::vector<bool>> dominators; /**< dominators[i][j] : rpo block j dominates rpo block i */
+    std::vector<Loop> loops;
+    std::vector<BasicBlock*> no_predecessors;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// struct AffineExpr                                                          //
+////////////////////////////////////////////////////////////////////////////////
+
+/** constant + sum of coefficient * variable */
+struct AffineExpr {
+    // ------------------------------------------------------------- Constructor
+    AffineExpr(int64_t constant = 0);
+
+    // ------------------------------------------------- Public Member Functions
+    static AffineExpr variable(const std::string &name);
+    bool is_constant() const;
+
+    // ---------------------------------------------------- Overloaded Operators
+    AffineExpr& operator+=(const AffineExpr &other);
+    AffineExpr& operator-=(const AffineExpr &other);
+    AffineExpr& operator*=(int64_t factor);
+
+    // ------------------------------------------------------- Public Properties
+    int64_t constant;
+    std::map<std::string, int64_t> terms; /**< variable -> coefficient, never 0 */
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// struct Recurrence                                                          //
+////////////////////////////////////////////////////////////////////////////////
+
+/** Value of a variable after n iterations of its loop, the expressions being
+      evaluated with the values of the variables on entry to the loop */
+struct Recurrence {
+    typedef enum {
+        ADD, /**< start + step * n + step2 * n*(n-1)/2 */
+        MUL  /**< start * 2^(shift * n) */
+    } Kind;
+
+    Kind kind;
+    AffineExpr start;
+    AffineExpr step;
+    int64_t step2;
+    int64_t shift;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// struct LoopEvolution                                                       //
+////////////////////////////////////////////////////////////////////////////////
+
+/** What one execution of a loop computes, from the values of the variables on entry */
+struct LoopEvolution {
+    // ------------------------------------------------- Public Member Functions
+    bool get_constant_trip_count(int64_t &count) const; /**< false if the trip count depends on the values on entry */
+    bool is_removable() const; /**< true if the loop only computes the final values of its recurrences */
+
+    // ------------------------------------------------------- Public Properties
+    /* the loop body runs backedge_count + 1 times, with
+         backedge_count = distance                                     if not clamped
+         backedge_count = (distance + stride - 1) / stride, or 0 if distance <= 0   if clamped
+    */
+    bool has_trip_count;
+    AffineExpr distance;
+    int64_t stride;
+    bool clamped;
+
+    std::map<std::string, Recurrence> recurrences; /**< named variables written by the loop */
+    std::set<std::string> unknown_variables;       /**< named variables written by the loop, without a recurrence */
+    bool has_side_effects;                         /**< calls, or instructions that may trap */
+    BasicBlock* exit;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// class ScalarEvolution                                                      //
+////////////////////////////////////////////////////////////////////////////////
+
+/* Evolution of the variables of the loops that are a chain of blocks from the
+     header to the latch, the latch being the only exiting block (the loops
+     rotated by LoopRotation). One iteration is evaluated symbolically:
+         s = s + i; i = i + 1;  while (i < n)
+     gives i = {i, +, 1}, s = {s, +, i, +, 1} and (n - i - 1) more iterations.
+     As in C, signed overflows of the induction variables are assumed not to happen,
+     but the variables narrower than int64_t wrap around like in C: the values
+     written into them are followed only if they are constants or copies.
+*/
+class ScalarEvolution {
+public:
+    // ------------------------------------------------------------- Constructor
+    ScalarEvolution(const LoopInfo &loop_info);
+
+    // ------------------------------------------------- Public Member Functions
+    const LoopEvolution* get_evolution(const Loop &loop) const; /**< nullptr if the loop does not have the expected shape */
+private:
+    /** value of a variable while an iteration is evaluated */
+    struct Value {
+        typedef enum {
+            AFFINE,     /**< expr, over the values at the start of the iteration */
+            COMPARISON, /**< expr compared to 0 by comparison */
+            UNKNOWN
+        } Kind;
+
+        Kind kind;
+        AffineExpr expr;
+        IRInstr::Operation comparison;
+    };
+
+    static bool analyze(const Loop &loop, LoopEvolution &evolution);
+    static Value get_value(const std::map<std::string, Value> &values, const std::string &var);
+    static bool fits_in_type(const Value &value, Type type, const CFG* cfg); /**< value written into a variable of type without being truncated */
+    static bool compute_trip_count(const Value &condition, bool continue_if_true, const std::map<std::string, Recurrence> &induction_variables, LoopEvolution &evolution);
+
+    std::map<const BasicBlock*, LoopEvolution> evolutions; /**< by loop header */
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// class BlockFrequency                                                       //
+////////////////////////////////////////////////////////////////////////////////
+
+/* Static estimation of the branch probabilities and of the block frequencies,
+     without profile. Each conditional branch combines the Ball-Larus heuristics
+     that apply to it (Wu-Larus), e.g. for a back edge and an early return:
+         loop branch:  the back edges are taken                          88%
+         loop exit:    the edges leaving a loop are not taken            80%
+         loop header:  the edges entering a loop are taken               75%
+         opcode:       x < 0, x <= 0 and x == constant are false         84%
+         call:         the successor with a call is not taken            78%
+         return:       the successor with a return is not taken          72%
+     The frequencies are relative to one call of the function: the entry block
+     runs once, and the blocks of a loop run 1 / (1 - p) times as often as the
+     loop is entered, p being the probability of going back to its header.
+     Edges closing an irreducible cycle are ignored.
+*/
+class BlockFrequency {
+public:
+    // ------------------------------------------------------------- Constructor
+    BlockFrequency(CFG* cfg);
+
+    // ------------------------------------------------- Public Member Functions
+    double get_probability(const BasicBlock* from, const BasicBlock* to) const; /**< 0 if to is not a successor of from */
+    double get_frequency(const BasicBlock* bb) const; /**< 0 for the unreachable blocks */
+    double get_edge_frequency(const BasicBlock* from, const BasicBlock* to) const;
+
+    static const size_t MAX_LOOP_ITERATIONS = 1024; /**< bound of the frequency of a loop relative to its entry */
+private:
+    void compute_probabilities();
+    double compute_branch_probability(const BasicBlock* bb) const; /**< probability of going to exit_true */
+    double get_opcode_probability(const BasicBlock* bb) const;
+    void compute_frequencies();
+    void propagate(const BasicBlock* header, std::map<const BasicBlock*, double> &result) const; /**< from the header, or from the entry block if nullptr, through the forward edges */
+    static double combine(double p1, double p2); /**< Dempster-Shafer combination of two probabilities of the same event */
+    static bool has_operation(const BasicBlock* bb, IRInstr::Operation op);
+
+    LoopInfo loop_info;
+    std::map<const BasicBlock*, double> true_probabilities; /**< of the blocks with two successors */
+    std::map<const BasicBlock*, double> loop_multipliers;   /**< by loop header */
+    std::map<const BasicBlock*, double> frequencies;
+};
@@ -0,0 +1,48 @@
+// ------------------------------------------------------------- Project Headers
+#include "Arena.h"
+
+// ---------------------------------------------------------- C++ System Headers
+#include <cstdint>
+
+////////////////////////////////////////////////////////////////////////////////
+// class Arena                                                                //
+////////////////////////////////////////////////////////////////////////////////
+
+// ---------------------------------------------------- Constructor / Destructor
+Arena::Arena(size_t chunk_size) :
+    chunk_size(chunk_size), current(nullptr), end(nullptr), allocated_bytes(0)
+{}
+
+Arena::~Arena()
+{
+    for (auto it = destructors.rbegin(); it != destructors.rend(); ++it)
+        it->destroy(it->object);
+    for (char* chunk : chunks)
+        delete[] chunk;
+}
+
+// ----------------------------------------------------- Public Member Functions
+void* Arena::allocate(size_t size, size_t alignment)
+{
+    uintptr_t address = reinterpret_cast<uintptr_t>(current);
+    size_t padding = (alignment - address % alignment) % alignment;
+    if (!current || padding + size > static_cast<size_t>(end - current))
+    {
+        // the objects larger than a chunk get one of their own
+        const size_t new_chunk_size = size + alignment > chunk_size ? size + alignment : chunk_size;
+        chunks.push_back(new char[new_chunk_size]);
+        allocated_bytes += new_chunk_size;
+        current = chunks.back();
+        end = current + new_chunk_size;
+        address = reinterpret_cast<uintptr_t>(current);
+        padding = (alignment - address % alignment) % alignment;
+    }
+    void* object = current + padding;
+    current += padding + size;
+    return object;
+}
+
+size_t Arena::get_allocated_bytes() const
+{
+    return allocated_bytes;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+// ---------------------------------------------------------- C++ System Headers
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// class Arena                                                                //
+////////////////////////////////////////////////////////////////////////////////
+
+/* Bump allocator: the objects are placed one after the other in large
+     chunks, and they are all destroyed and freed at once with the arena.
+     An object is never freed on its own: once it is no longer used, it is
+     simply left in its chunk until the end.
+         Arena arena;
+         BasicBlock* bb = arena.create<BasicBlock>(cfg, "bb3");
+     The destructors of the objects which have one run in the reverse order
+     of the creations.
+*/
+class Arena {
+public:
+    // ------------------------------------------------ Constructor / Destructor
+    Arena(size_t chunk_size = DEFAULT_CHUNK_SIZE);
+    Arena(const Arena& src) = delete;
+    ~Arena();
+
+    // ---------------------------------------------------- Overloaded Operators
+    Arena& operator=(const Arena& src) = delete;
+
+    // ------------------------------------------------- Public Member Functions
+    template <typename T, typename... Args>
+    T* create(Args&&... args);
+    void* allocate(size_t size, size_t alignment); /**< uninitialized memory, freed with the arena */
+    size_t get_allocated_bytes() const; /**< by the chunks */
+
+    static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+private:
+    struct Destructor {
+        void* object;
+        void (*destroy)(void*);
+    };
+
+    template <typename T>
+    static void destroy(void* object);
+
+    size_t chunk_size;
+    std::vector<char*> chunks;
+    char* current; /**< first free byte of the last chunk */
+    char* end;     /**< of the last chunk */
+    size_t allocated_bytes;
+    std::vector<Destructor> destructors;
+};
+
+// ----------------------------------------------------- Public Member Functions
+template <typename T, typename... Args>
+T* Arena::create(Args&&... args)
+{
+    T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    if (!std::is_trivially_destructible<T>::value)
+        destructors.push_back({object, &destroy<T>});
+    return object;
+}
+
+// ---------------------------------------------------- Private Member Functions
+template <typename T>
+void Arena::destroy(void* object)
+{
+    static_cast<T*>(object)->~T();
+}
@@ -39,6 +39,7 @@ assignment: IDENTIFIER OP_ASGN expr ;
 expr: PAR_OP='(' expr ')'
     | expr POSTFIX_OP=(OP_PP | OP_MM)
     | IDENTIFIER ARG_OP='(' arg_list? ')'
+    | EXPECT_OP=BUILTIN_EXPECT '(' expr ',' INT_LITERAL ')'
     |<assoc=right> PREFIX_OP=(OP_PP | OP_MM | OP_PLUS | OP_MINUS | OP_NOT | OP_BNOT) expr
     | expr (OP_MUL | OP_DIV | OP_MOD) expr
     | expr (OP_PLUS | OP_MINUS) expr
@@ -76,6 +77,7 @@ IF: 'if' ;
 ELSE: 'else' ;
 WHILE: 'while' ;
 FOR: 'for' ;
+BUILTIN_EXPECT: '__builtin_expect' ;
 OP_PP: '++';
 OP_MM: '--';
 OP_PLUS: '+' ;
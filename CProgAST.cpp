@@ -6,22 +6,14 @@
 // ------------------------------------------------------------- Project Headers
 #include "CProgAST.h"
 #include "IR.h"
+#include "Statistics.h"
+#include "TimeReport.h"
 #include "Writer.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgAST                                                             //
 ////////////////////////////////////////////////////////////////////////////////
 
-// ---------------------------------------------------- Constructor / Destructor
-
-CProgASTProgram::~CProgASTProgram()
-{
-    for(CProgASTFuncdef* funcdef : funcdefs)
-    {
-        delete funcdef;
-    }
-}
-
 // ----------------------------------------------------- Public Member Functions
 void CProgASTProgram::add_funcdef(CProgASTFuncdef* funcdef)
 {
@@ -36,23 +28,24 @@ void CProgASTProgram::build_ir(IR& ir) const
     }
 }
 
+void CProgASTProgram::print_debug_infos() const
+{
+    Writer::info() << "Affichage de l'AST : " << std::endl;
+    for(const CProgASTFuncdef* funcdef : funcdefs)
+    {
+        funcdef->print_debug_infos();
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTFuncdef                                                      //
 ////////////////////////////////////////////////////////////////////////////////
 
 // ---------------------------------------------------- Constructor / Destructor
 CProgASTFuncdef::CProgASTFuncdef(const std::string &id, Type type) :
-    identifier(id), return_type(type)
+    first_node(CProgASTStatement::get_nb_created()), nb_nodes(0), identifier(id), return_type(type)
 {}
 
-CProgASTFuncdef::~CProgASTFuncdef()
-{
-    for(CProgASTStatement* statement : statements)
-    {
-        delete statement;
-    }
-}
-
 // ----------------------------------------------------- Public Member Functions
 void CProgASTFuncdef::add_arg(std::string id, Type type)
 {
@@ -63,42 +56,102 @@ void CProgASTFuncdef::add_arg(std::string id, Type type)
 void CProgASTFuncdef::add_statement(CProgASTStatement* statement)
 {
     statements.push_back(statement);
+    nb_nodes = CProgASTStatement::get_nb_created() - first_node;
+}
+
+void CProgASTFuncdef::set_source_position(const SourcePosition &position)
+{
+    this->position = position;
+}
+
+void CProgASTFuncdef::print_debug_infos() const
+{
+    Writer::info() << "Fonction : " << identifier << ", Type : " << types.at(return_type).name
+                   << " (ligne " << position.line << ":" << position.column << ")" << std::endl;
+    for(size_t i=0; i<arg_names.size(); ++i)
+    {
+        Writer::info() << "  Argument : " << arg_names[i] << ", Type : " << types.at(arg_types[i]).name << std::endl;
+    }
+    for(const CProgASTStatement* statement : statements)
+    {
+        statement->print_debug_infos(1);
+    }
 }
 
 CFG* CProgASTFuncdef::build_ir(TableOfSymbols* global_symbols) const
 {
+    PhaseTimer timer("ast-to-ir", identifier);
+    Statistics::add(identifier, "ast-nodes", nb_nodes);
     global_symbols->add_symbol(identifier, return_type);
     SymbolProperties& fproperties = global_symbols->get_symbol(identifier);
     fproperties.callable = true;
     fproperties.arg_types = arg_types;
 
     CFG* cfg = new CFG(this, identifier, global_symbols);
+    cfg->definition_position = position;
     for(size_t i=0; i<arg_names.size(); ++i)
     {
         cfg->add_arg_to_symbol_table(arg_names[i], arg_types[i]);
     }
     for(CProgASTStatement* statement : statements)
     {
+        statement->enter_source_position(cfg);
         statement->build_ir(cfg);
     }
+    // the instructions added by the optimizations come from no statement
+    cfg->current_position = SourcePosition();
 
     cfg->check_for_unused_symbols();
     return cfg;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-// class CProgASTCompoundStatement : public CProgASTStatement                       //
+// class CProgASTStatement                                                    //
 ////////////////////////////////////////////////////////////////////////////////
 
+size_t CProgASTStatement::nb_created = 0;
+
 // ---------------------------------------------------- Constructor / Destructor
-CProgASTCompoundStatement::~CProgASTCompoundStatement()
+CProgASTStatement::CProgASTStatement()
 {
-    for(const CProgASTStatement* statement : statements)
-    {
-        delete statement;
-    }
+    ++nb_created;
 }
 
+// ----------------------------------------------------- Public Member Functions
+size_t CProgASTStatement::get_nb_created()
+{
+    return nb_created;
+}
+
+void CProgASTStatement::set_source_position(const SourcePosition &position)
+{
+    this->position = position;
+}
+
+void CProgASTStatement::enter_source_position(CFG* cfg) const
+{
+    if (position.line != 0)
+        cfg->current_position = position;
+}
+
+// -------------------------------------------------- Protected Member Functions
+void CProgASTStatement::print_debug_line(size_t depth, const std::string &node) const
+{
+    Writer::info() << std::string(2 * depth, ' ') << node << " (ligne " << position.line << ":" << position.column << ")" << std::endl;
+}
+
+void CProgASTStatement::print_optional(const CProgASTStatement* statement, size_t depth)
+{
+    if (statement)
+        statement->print_debug_infos(depth);
+    else
+        Writer::info() << std::string(2 * depth, ' ') << "vide" << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class CProgASTCompoundStatement : public CProgASTStatement                       //
+////////////////////////////////////////////////////////////////////////////////
+
 // ----------------------------------------------------- Public Member Functions
 
 void CProgASTCompoundStatement::add_statement(CProgASTStatement* statement)
@@ -108,13 +161,25 @@ void CProgASTCompoundStatement::add_statement(CProgASTStatement* statement)
 
 std::string CProgASTCompoundStatement::build_ir(CFG* cfg) const
 {
+    cfg->enter_scope();
     for(const CProgASTStatement* statement : statements)
     {
+        statement->enter_source_position(cfg);
         statement->build_ir(cfg);
     }
+    cfg->exit_scope();
     return ""; // ??
 }
 
+void CProgASTCompoundStatement::print_debug_infos(size_t depth) const
+{
+    print_debug_line(depth, "CompoundStatement");
+    for(const CProgASTStatement* statement : statements)
+    {
+        statement->print_debug_infos(depth + 1);
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTReturn : public CProgASTStatement                            //
 ////////////////////////////////////////////////////////////////////////////////
@@ -124,11 +189,6 @@ CProgASTReturn::CProgASTReturn(CProgASTExpression* expression) :
     return_expression(expression)
 {}
 
-CProgASTReturn::~CProgASTReturn()
-{
-    delete return_expression;
-}
-
 // ----------------------------------------------------- Public Member Functions
 std::string CProgASTReturn::build_ir(CFG* cfg) const
 {
@@ -137,6 +197,12 @@ std::string CProgASTReturn::build_ir(CFG* cfg) const
     return ""; // ??
 }
 
+void CProgASTReturn::print_debug_infos(size_t depth) const
+{
+    print_debug_line(depth, "Return");
+    return_expression->print_debug_infos(depth + 1);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTDeclaration : public CProgASTStatement                       //
 ////////////////////////////////////////////////////////////////////////////////
@@ -146,14 +212,6 @@ CProgASTDeclaration::CProgASTDeclaration(Type type) :
     type_specifier(type)
 {}
 
-CProgASTDeclaration::~CProgASTDeclaration()
-{
-    for(const CProgASTDeclarator* declarator : declarators)
-    {
-        delete declarator;
-    }
-}
-
 // ----------------------------------------------------- Public Member Functions
 
 void CProgASTDeclaration::add_declarator(CProgASTDeclarator* declarator)
@@ -171,6 +229,15 @@ std::string CProgASTDeclaration::build_ir(CFG* cfg) const
     return ""; // ??
 }
 
+void CProgASTDeclaration::print_debug_infos(size_t depth) const
+{
+    print_debug_line(depth, "Declaration : " + types.at(type_specifier).name);
+    for(const CProgASTDeclarator* declarator : declarators)
+    {
+        declarator->print_debug_infos(depth + 1);
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTDeclarator                                                   //
 ////////////////////////////////////////////////////////////////////////////////
@@ -180,14 +247,6 @@ CProgASTDeclarator::CProgASTDeclarator(CProgASTIdentifier* id, CProgASTAssignmen
     identifier(id), initializer(init)
 {}
 
-CProgASTDeclarator::~CProgASTDeclarator()
-{
-    if(identifier)
-        delete identifier;
-    if(initializer)
-        delete initializer;
-}
-
 // ----------------------------------------------------- Public Member Functions
 void CProgASTDeclarator::set_type(Type type)
 {
@@ -197,7 +256,7 @@ void CProgASTDeclarator::set_type(Type type)
 std::string CProgASTDeclarator::build_ir(CFG* cfg) const
 {
     std::string name = identifier->getText();
-    if(!cfg->is_declared(name))
+    if(!cfg->is_declared_in_scope(name))
     {
         cfg->add_to_symbol_table(name, type_specifier);
     }
@@ -212,6 +271,13 @@ std::string CProgASTDeclarator::build_ir(CFG* cfg) const
     return ""; // ??
 }
 
+void CProgASTDeclarator::print_debug_infos(size_t depth) const
+{
+    Writer::info() << std::string(2 * depth, ' ') << "Declarator : " << identifier->getText() << std::endl;
+    if(initializer)
+        initializer->print_debug_infos(depth + 1);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTIfStatement : public CProgASTStatement                       //
 ////////////////////////////////////////////////////////////////////////////////
@@ -221,23 +287,16 @@ CProgASTIfStatement::CProgASTIfStatement(CProgASTExpression* condition, CProgAST
     condition(condition), if_statement(if_statement), else_statement(else_statement)
 {}
 
-CProgASTIfStatement::~CProgASTIfStatement()
-{
-    delete condition;
-    delete if_statement;
-    delete else_statement;
-}
-
 // ----------------------------------------------------- Public Member Functions
 std::string CProgASTIfStatement::build_ir(CFG* cfg) const
 {
-    std::string test_result = condition->build_ir(cfg);
-    cfg->current_bb->add_IRInstr(IRInstr::cmp_null, cfg->get_var_type(test_result), {test_result});
+    condition->enter_source_position(cfg);
+    condition->build_condition_ir(cfg);
 
     BasicBlock* test_bb = cfg->current_bb;
-    BasicBlock* then_bb = new BasicBlock(cfg, cfg->new_BB_name());
-    BasicBlock* after_if_bb = new BasicBlock(cfg, cfg->new_BB_name());
-    BasicBlock* else_bb = else_statement ? new BasicBlock(cfg, cfg->new_BB_name()) : nullptr;
+    BasicBlock* then_bb = cfg->create_bb();
+    BasicBlock* after_if_bb = cfg->create_bb();
+    BasicBlock* else_bb = else_statement ? cfg->create_bb() : nullptr;
 
     after_if_bb->exit_true = test_bb->exit_true;
     after_if_bb->exit_false = test_bb->exit_false;
@@ -247,6 +306,7 @@ std::string CProgASTIfStatement::build_ir(CFG* cfg) const
     test_bb->exit_false = else_bb ? else_bb : after_if_bb;
 
     cfg->current_bb = then_bb;
+    if_statement->enter_source_position(cfg);
     if_statement->build_ir(cfg);
     cfg->add_bb(then_bb);
 
@@ -255,6 +315,7 @@ std::string CProgASTIfStatement::build_ir(CFG* cfg) const
         cfg->current_bb = else_bb;
         else_bb->exit_true = after_if_bb;
         else_bb->exit_false = nullptr;
+        else_statement->enter_source_position(cfg);
         else_statement->build_ir(cfg);
         cfg->add_bb(else_bb);
     }
@@ -264,6 +325,14 @@ std::string CProgASTIfStatement::build_ir(CFG* cfg) const
     return ""; // ??
 }
 
+void CProgASTIfStatement::print_debug_infos(size_t depth) const
+{
+    print_debug_line(depth, "IfStatement");
+    condition->print_debug_infos(depth + 1);
+    if_statement->print_debug_infos(depth + 1);
+    print_optional(else_statement, depth + 1);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTWhileStatement : public CProgASTStatement                    //
 ////////////////////////////////////////////////////////////////////////////////
@@ -273,20 +342,14 @@ CProgASTWhileStatement::CProgASTWhileStatement(CProgASTExpression* condition, CP
     condition(condition), body(body)
 {}
 
-CProgASTWhileStatement::~CProgASTWhileStatement()
-{
-    delete condition;
-    delete body;
-}
-
 // ----------------------------------------------------- Public Member Functions
 std::string CProgASTWhileStatement::build_ir(CFG* cfg) const
 {
     BasicBlock* before_while_bb = cfg->current_bb;
 
-    BasicBlock* body_bb = new BasicBlock(cfg, cfg->new_BB_name());
-    BasicBlock* test_bb = new BasicBlock(cfg, cfg->new_BB_name());
-    BasicBlock* after_while_bb = new BasicBlock(cfg, cfg->new_BB_name());
+    BasicBlock* body_bb = cfg->create_bb();
+    BasicBlock* test_bb = cfg->create_bb();
+    BasicBlock* after_while_bb = cfg->create_bb();
 
     after_while_bb->exit_true = before_while_bb->exit_true;
     after_while_bb->exit_false = before_while_bb->exit_false;
@@ -298,11 +361,12 @@ std::string CProgASTWhileStatement::build_ir(CFG* cfg) const
     body_bb->exit_false = nullptr;
 
     cfg->current_bb = test_bb;
-    std::string test_result = condition->build_ir(cfg);
-    cfg->current_bb->add_IRInstr(IRInstr::cmp_null, cfg->get_var_type(test_result), {test_result});
+    condition->enter_source_position(cfg);
+    condition->build_condition_ir(cfg);
     cfg->add_bb(test_bb);
 
     cfg->current_bb = body_bb;
+    body->enter_source_position(cfg);
     body->build_ir(cfg);
     cfg->add_bb(body_bb);
 
@@ -311,6 +375,13 @@ std::string CProgASTWhileStatement::build_ir(CFG* cfg) const
     return ""; // ??
 }
 
+void CProgASTWhileStatement::print_debug_infos(size_t depth) const
+{
+    print_debug_line(depth, "WhileStatement");
+    condition->print_debug_infos(depth + 1);
+    body->print_debug_infos(depth + 1);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTForStatement : public CProgASTStatement                      //
 ////////////////////////////////////////////////////////////////////////////////
@@ -320,24 +391,16 @@ CProgASTForStatement::CProgASTForStatement(CProgASTExpression* initialization, C
     initialization(initialization), condition(condition), increment(increment), body(body)
 {}
 
-CProgASTForStatement::~CProgASTForStatement()
-{
-    delete initialization;
-    delete condition;
-    delete increment;
-    delete body;
-}
-
 // ----------------------------------------------------- Public Member Functions
 std::string CProgASTForStatement::build_ir(CFG* cfg) const
 {
     BasicBlock* before_for_bb = cfg->current_bb;
 
-    BasicBlock* body_bb = new BasicBlock(cfg, cfg->new_BB_name());
-    BasicBlock* init_bb = new BasicBlock(cfg, cfg->new_BB_name());
-    BasicBlock* test_bb = new BasicBlock(cfg, cfg->new_BB_name());
-    BasicBlock* incr_bb = new BasicBlock(cfg, cfg->new_BB_name());
-    BasicBlock* after_for_bb = new BasicBlock(cfg, cfg->new_BB_name());
+    BasicBlock* body_bb = cfg->create_bb();
+    BasicBlock* init_bb = cfg->create_bb();
+    BasicBlock* test_bb = cfg->create_bb();
+    BasicBlock* incr_bb = cfg->create_bb();
+    BasicBlock* after_for_bb = cfg->create_bb();
 
     after_for_bb->exit_true = before_for_bb->exit_true;
     after_for_bb->exit_false = before_for_bb->exit_false;
@@ -352,21 +415,39 @@ std::string CProgASTForStatement::build_ir(CFG* cfg) const
     incr_bb->exit_true = test_bb;
     incr_bb->exit_false = nullptr;
 
+    // each expression may be left out, without condition the loop only ends
+    // by a return
     cfg->current_bb = init_bb;
-    initialization->build_ir(cfg);
+    if (initialization)
+    {
+        initialization->enter_source_position(cfg);
+        initialization->build_ir(cfg);
+    }
     cfg->add_bb(init_bb);
 
     cfg->current_bb = test_bb;
-    std::string test_result = condition->build_ir(cfg);
-    cfg->current_bb->add_IRInstr(IRInstr::cmp_null, cfg->get_var_type(test_result), {test_result});
+    if (condition)
+    {
+        condition->enter_source_position(cfg);
+        condition->build_condition_ir(cfg);
+    }
+    else
+    {
+        test_bb->exit_false = nullptr;
+    }
     cfg->add_bb(test_bb);
 
     cfg->current_bb = body_bb;
+    body->enter_source_position(cfg);
     body->build_ir(cfg);
     cfg->add_bb(body_bb);
 
     cfg->current_bb = incr_bb;
-    increment->build_ir(cfg);
+    if (increment)
+    {
+        increment->enter_source_position(cfg);
+        increment->build_ir(cfg);
+    }
     cfg->add_bb(incr_bb);
 
     cfg->current_bb = after_for_bb;
@@ -374,6 +455,55 @@ std::string CProgASTForStatement::build_ir(CFG* cfg) const
     return ""; // ??
 }
 
+void CProgASTForStatement::print_debug_infos(size_t depth) const
+{
+    print_debug_line(depth, "ForStatement");
+    print_optional(initialization, depth + 1);
+    print_optional(condition, depth + 1);
+    print_optional(increment, depth + 1);
+    body->print_debug_infos(depth + 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class CProgASTExpression : public CProgASTStatement                        //
+////////////////////////////////////////////////////////////////////////////////
+
+// ----------------------------------------------------- Public Member Functions
+bool CProgASTExpression::get_expected_value(bool &) const
+{
+    return false;
+}
+
+std::string CProgASTExpression::build_test_ir(CFG* cfg) const
+{
+    return build_ir(cfg);
+}
+
+std::string CProgASTExpression::build_condition_ir(CFG* cfg) const
+{
+    std::string test_result = build_test_ir(cfg);
+    std::vector<std::string> params = {test_result};
+    bool expected;
+    if (get_expected_value(expected))
+    {
+        // cmp_null {var, probability of a non zero value in percent}
+        params.push_back(std::to_string(expected ? IRInstr::EXPECTED_PERCENT : 100 - IRInstr::EXPECTED_PERCENT));
+    }
+    cfg->current_bb->add_IRInstr(IRInstr::cmp_null, cfg->get_var_type(test_result), params);
+    return test_result;
+}
+
+void CProgASTExpression::set_shared()
+{
+    shared = true;
+}
+
+// -------------------------------------------------- Protected Member Functions
+void CProgASTExpression::print_debug_line(size_t depth, const std::string &node) const
+{
+    CProgASTStatement::print_debug_line(depth, shared ? node + ", partagé" : node);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTAssignment                                                   //
 ////////////////////////////////////////////////////////////////////////////////
@@ -386,28 +516,30 @@ CProgASTAssignment::CProgASTAssignment(
     rhs_expression(expression)
 {}
 
-CProgASTAssignment::~CProgASTAssignment()
-{
-    delete lhs_identifier;
-    delete rhs_expression;
-}
-
 // ----------------------------------------------------- Public Member Functions
 std::string CProgASTAssignment::build_ir(CFG* cfg) const
 {
-    std::string name = lhs_identifier->getText();
+    std::string name = cfg->lookup(lhs_identifier->getText());
     std::string init = rhs_expression->build_ir(cfg);
-    if(!cfg->is_declared(name))
+    if(name.empty())
     {
+        name = lhs_identifier->getText();
         Writer::error() << "use of undeclercqed identifier '" << name << "'" << std::endl;
     }
 
     cfg->initialize(name);
     cfg->current_bb->add_IRInstr(IRInstr::wmem, cfg->get_var_type(name), {name, init});
+    cfg->invalidate_cached_values(name);
 
     return name;
 }
 
+void CProgASTAssignment::print_debug_infos(size_t depth) const
+{
+    print_debug_line(depth, "Assignment : " + lhs_identifier->getText());
+    rhs_expression->print_debug_infos(depth + 1);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTPrePP : public CProgASTExpression                            //
 ////////////////////////////////////////////////////////////////////////////////
@@ -417,19 +549,21 @@ CProgASTPrePP::CProgASTPrePP(CProgASTExpression* expression) :
     inner_expression(expression)
 {}
 
-CProgASTPrePP::~CProgASTPrePP()
-{
-    delete inner_expression;
-}
-
 // ----------------------------------------------------- Public Member Functions
 std::string CProgASTPrePP::build_ir(CFG* cfg) const
 {
     std::string exp_name = inner_expression->build_ir(cfg);
     cfg->current_bb->add_IRInstr(IRInstr::pre_pp, cfg->get_var_type(exp_name), {exp_name});
+    cfg->invalidate_cached_values(exp_name);
     return exp_name;
 }
 
+void CProgASTPrePP::print_debug_infos(size_t depth) const
+{
+    print_debug_line(depth, "PrePP");
+    inner_expression->print_debug_infos(depth + 1);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTPreMM : public CProgASTExpression                            //
 ////////////////////////////////////////////////////////////////////////////////
@@ -439,19 +573,21 @@ CProgASTPreMM::CProgASTPreMM(CProgASTExpression* expression) :
     inner_expression(expression)
 {}
 
-CProgASTPreMM::~CProgASTPreMM()
-{
-    delete inner_expression;
-}
-
 // ----------------------------------------------------- Public Member Functions
 std::string CProgASTPreMM::build_ir(CFG* cfg) const
 {
     std::string exp_name = inner_expression->build_ir(cfg);
     cfg->current_bb->add_IRInstr(IRInstr::pre_mm, cfg->get_var_type(exp_name), {exp_name});
+    cfg->invalidate_cached_values(exp_name);
     return exp_name;
 }
 
+void CProgASTPreMM::print_debug_infos(size_t depth) const
+{
+    print_debug_line(depth, "PreMM");
+    inner_expression->print_debug_infos(depth + 1);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTPostPP : public CProgASTExpression                            //
 ////////////////////////////////////////////////////////////////////////////////
@@ -461,11 +597,6 @@ CProgASTPostPP::CProgASTPostPP(CProgASTExpression* expression) :
     inner_expression(expression)
 {}
 
-CProgASTPostPP::~CProgASTPostPP()
-{
-    delete inner_expression;
-}
-
 // ----------------------------------------------------- Public Member Functions
 std::string CProgASTPostPP::build_ir(CFG* cfg) const
 {
@@ -473,9 +604,16 @@ std::string CProgASTPostPP::build_ir(CFG* cfg) const
     Type result_type = cfg->get_var_type(exp_name);
     std::string tmp_name = cfg->create_new_tempvar(result_type);
     cfg->current_bb->add_IRInstr(IRInstr::post_pp, result_type, {tmp_name, exp_name});
+    cfg->invalidate_cached_values(exp_name);
     return tmp_name;
 }
 
+void CProgASTPostPP::print_debug_infos(size_t depth) const
+{
+    print_debug_line(depth, "PostPP");
+    inner_expression->print_debug_infos(depth + 1);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTPostMM : public CProgASTExpression                            //
 ////////////////////////////////////////////////////////////////////////////////
@@ -485,11 +623,6 @@ CProgASTPostMM::CProgASTPostMM(CProgASTExpression* expression) :
     inner_expression(expression)
 {}
 
-CProgASTPostMM::~CProgASTPostMM()
-{
-    delete inner_expression;
-}
-
 // ----------------------------------------------------- Public Member Functions
 std::string CProgASTPostMM::build_ir(CFG* cfg) const
 {
@@ -497,85 +630,14 @@ std::string CProgASTPostMM::build_ir(CFG* cfg) const
     Type result_type = cfg->get_var_type(exp_name);
     std::string tmp_name = cfg->create_new_tempvar(result_type);
     cfg->current_bb->add_IRInstr(IRInstr::post_mm, result_type, {tmp_name, exp_name});
+    cfg->invalidate_cached_values(exp_name);
     return tmp_name;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTBAnd : public CProgASTExpression                         //
-////////////////////////////////////////////////////////////////////////////////
-
-// ---------------------------------------------------- Constructor / Destructor
-CProgASTBAnd::CProgASTBAnd(CProgASTExpression* lhs, CProgASTExpression* rhs) :
-    lhs_operand(lhs), rhs_operand(rhs)
-{}
-
-CProgASTBAnd::~CProgASTBAnd()
-{
-    delete lhs_operand;
-    delete rhs_operand;
-}
-
-// ----------------------------------------------------- Public Member Functions
-std::string CProgASTBAnd::build_ir(CFG* cfg) const
-{
-    std::string lhs_name = lhs_operand->build_ir(cfg);
-    std::string rhs_name = rhs_operand->build_ir(cfg);
-    Type result_type = cfg->get_max_type(lhs_name, rhs_name);
-    std::string tmp_name = cfg->create_new_tempvar(result_type);
-    cfg->current_bb->add_IRInstr(IRInstr::band, result_type, {tmp_name, lhs_name, rhs_name});
-    return tmp_name;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTBOr : public CProgASTExpression                         //
-////////////////////////////////////////////////////////////////////////////////
-
-// ---------------------------------------------------- Constructor / Destructor
-CProgASTBOr::CProgASTBOr(CProgASTExpression* lhs, CProgASTExpression* rhs) :
-    lhs_operand(lhs), rhs_operand(rhs)
-{}
-
-CProgASTBOr::~CProgASTBOr()
+void CProgASTPostMM::print_debug_infos(size_t depth) const
 {
-    delete lhs_operand;
-    delete rhs_operand;
-}
-
-// ----------------------------------------------------- Public Member Functions
-std::string CProgASTBOr::build_ir(CFG* cfg) const
-{
-    std::string lhs_name = lhs_operand->build_ir(cfg);
-    std::string rhs_name = rhs_operand->build_ir(cfg);
-    Type result_type = cfg->get_max_type(lhs_name, rhs_name);
-    std::string tmp_name = cfg->create_new_tempvar(result_type);
-    cfg->current_bb->add_IRInstr(IRInstr::bor, result_type, {tmp_name, lhs_name, rhs_name});
-    return tmp_name;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTBXor : public CProgASTExpression                         //
-////////////////////////////////////////////////////////////////////////////////
-
-// ---------------------------------------------------- Constructor / Destructor
-CProgASTBXor::CProgASTBXor(CProgASTExpression* lhs, CProgASTExpression* rhs) :
-    lhs_operand(lhs), rhs_operand(rhs)
-{}
-
-CProgASTBXor::~CProgASTBXor()
-{
-    delete lhs_operand;
-    delete rhs_operand;
-}
-
-// ----------------------------------------------------- Public Member Functions
-std::string CProgASTBXor::build_ir(CFG* cfg) const
-{
-    std::string lhs_name = lhs_operand->build_ir(cfg);
-    std::string rhs_name = rhs_operand->build_ir(cfg);
-    Type result_type = cfg->get_max_type(lhs_name, rhs_name);
-    std::string tmp_name = cfg->create_new_tempvar(result_type);
-    cfg->current_bb->add_IRInstr(IRInstr::bxor, result_type, {tmp_name, lhs_name, rhs_name});
-    return tmp_name;
+    print_debug_line(depth, "PostMM");
+    inner_expression->print_debug_infos(depth + 1);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -587,21 +649,28 @@ CProgASTBNot::CProgASTBNot(CProgASTExpression* expression) :
     inner_expression(expression)
 {}
 
-CProgASTBNot::~CProgASTBNot()
-{
-    delete inner_expression;
-}
-
 // ----------------------------------------------------- Public Member Functions
 std::string CProgASTBNot::build_ir(CFG* cfg) const
 {
+    std::string cached_name;
+    if (shared && cfg->find_cached_value(this, cached_name))
+        return cached_name;
+    size_t first_read = cfg->get_nb_reads();
     std::string exp_name = inner_expression->build_ir(cfg);
     Type result_type = cfg->get_var_type(exp_name);
     std::string tmp_name = cfg->create_new_tempvar(result_type);
     cfg->current_bb->add_IRInstr(IRInstr::bnot, result_type, {tmp_name, exp_name});
+    if (shared)
+        cfg->cache_value(this, tmp_name, first_read);
     return tmp_name;
 }
 
+void CProgASTBNot::print_debug_infos(size_t depth) const
+{
+    print_debug_line(depth, "BNot");
+    inner_expression->print_debug_infos(depth + 1);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTAnd : public CProgASTExpression                              //
 ////////////////////////////////////////////////////////////////////////////////
@@ -611,12 +680,6 @@ CProgASTAnd::CProgASTAnd(CProgASTExpression* lhs, CProgASTExpression* rhs) :
     lhs_operand(lhs), rhs_operand(rhs)
 {}
 
-CProgASTAnd::~CProgASTAnd()
-{
-    delete lhs_operand;
-    delete rhs_operand;
-}
-
 // ----------------------------------------------------- Public Member Functions
 std::string CProgASTAnd::build_ir(CFG* cfg) const
 {
@@ -626,9 +689,9 @@ std::string CProgASTAnd::build_ir(CFG* cfg) const
     std::string tmp_name = cfg->create_new_tempvar(Type::INT_64);
 
     BasicBlock* test1_bb = cfg->current_bb;
-    BasicBlock* then1_bb = new BasicBlock(cfg, cfg->new_BB_name());
-    BasicBlock* after_if1_bb = new BasicBlock(cfg, cfg->new_BB_name());
-    BasicBlock* else1_bb = new BasicBlock(cfg, cfg->new_BB_name());
+    BasicBlock* then1_bb = cfg->create_bb();
+    BasicBlock* after_if1_bb = cfg->create_bb();
+    BasicBlock* else1_bb = cfg->create_bb();
 
     after_if1_bb->exit_true = test1_bb->exit_true;
     after_if1_bb->exit_false = test1_bb->exit_false;
@@ -644,9 +707,9 @@ std::string CProgASTAnd::build_ir(CFG* cfg) const
         cfg->current_bb->add_IRInstr(IRInstr::cmp_null, cfg->get_var_type(rhs_name), {rhs_name});
 
         BasicBlock* test2_bb = cfg->current_bb;
-        BasicBlock* then2_bb = new BasicBlock(cfg, cfg->new_BB_name());
-        BasicBlock* after_if2_bb = new BasicBlock(cfg, cfg->new_BB_name());
-        BasicBlock* else2_bb = new BasicBlock(cfg, cfg->new_BB_name());
+        BasicBlock* then2_bb = cfg->create_bb();
+        BasicBlock* after_if2_bb = cfg->create_bb();
+        BasicBlock* else2_bb = cfg->create_bb();
 
         after_if2_bb->exit_true = test2_bb->exit_true;
         after_if2_bb->exit_false = test2_bb->exit_false;
@@ -695,6 +758,13 @@ std::string CProgASTAnd::build_ir(CFG* cfg) const
     return tmp_name;
 }
 
+void CProgASTAnd::print_debug_infos(size_t depth) const
+{
+    print_debug_line(depth, "And");
+    lhs_operand->print_debug_infos(depth + 1);
+    rhs_operand->print_debug_infos(depth + 1);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTOr : public CProgASTExpression                               //
 ////////////////////////////////////////////////////////////////////////////////
@@ -704,12 +774,6 @@ CProgASTOr::CProgASTOr(CProgASTExpression* lhs, CProgASTExpression* rhs) :
     lhs_operand(lhs), rhs_operand(rhs)
 {}
 
-CProgASTOr::~CProgASTOr()
-{
-    delete lhs_operand;
-    delete rhs_operand;
-}
-
 // ----------------------------------------------------- Public Member Functions
 std::string CProgASTOr::build_ir(CFG* cfg) const
 {
@@ -719,9 +783,9 @@ std::string CProgASTOr::build_ir(CFG* cfg) const
     std::string tmp_name = cfg->create_new_tempvar(Type::INT_64);
 
     BasicBlock* test1_bb = cfg->current_bb;
-    BasicBlock* then1_bb = new BasicBlock(cfg, cfg->new_BB_name());
-    BasicBlock* after_if1_bb = new BasicBlock(cfg, cfg->new_BB_name());
-    BasicBlock* else1_bb = new BasicBlock(cfg, cfg->new_BB_name());
+    BasicBlock* then1_bb = cfg->create_bb();
+    BasicBlock* after_if1_bb = cfg->create_bb();
+    BasicBlock* else1_bb = cfg->create_bb();
 
     after_if1_bb->exit_true = test1_bb->exit_true;
     after_if1_bb->exit_false = test1_bb->exit_false;
@@ -748,9 +812,9 @@ std::string CProgASTOr::build_ir(CFG* cfg) const
             cfg->current_bb->add_IRInstr(IRInstr::cmp_null, cfg->get_var_type(rhs_name), {rhs_name});
 
             BasicBlock* test2_bb = cfg->current_bb;
-            BasicBlock* then2_bb = new BasicBlock(cfg, cfg->new_BB_name());
-            BasicBlock* after_if2_bb = new BasicBlock(cfg, cfg->new_BB_name());
-            BasicBlock* else2_bb = new BasicBlock(cfg, cfg->new_BB_name());
+            BasicBlock* then2_bb = cfg->create_bb();
+            BasicBlock* after_if2_bb = cfg->create_bb();
+            BasicBlock* else2_bb = cfg->create_bb();
 
             after_if2_bb->exit_true = test2_bb->exit_true;
             after_if2_bb->exit_false = test2_bb->exit_false;
@@ -790,6 +854,13 @@ std::string CProgASTOr::build_ir(CFG* cfg) const
     return tmp_name;
 }
 
+void CProgASTOr::print_debug_infos(size_t depth) const
+{
+    print_debug_line(depth, "Or");
+    lhs_operand->print_debug_infos(depth + 1);
+    rhs_operand->print_debug_infos(depth + 1);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTNot : public CProgASTExpression                              //
 ////////////////////////////////////////////////////////////////////////////////
@@ -799,324 +870,178 @@ CProgASTNot::CProgASTNot(CProgASTExpression* expression) :
     inner_expression(expression)
 {}
 
-CProgASTNot::~CProgASTNot()
-{
-    delete inner_expression;
-}
-
 // ----------------------------------------------------- Public Member Functions
 std::string CProgASTNot::build_ir(CFG* cfg) const
 {
+    std::string cached_name;
+    if (shared && cfg->find_cached_value(this, cached_name))
+        return cached_name;
+    size_t first_read = cfg->get_nb_reads();
     std::string exp_name = inner_expression->build_ir(cfg);
     Type result_type = cfg->get_var_type(exp_name);
     std::string tmp_name = cfg->create_new_tempvar(result_type);
     cfg->current_bb->add_IRInstr(IRInstr::lnot, result_type, {tmp_name, exp_name});
+    if (shared)
+        cfg->cache_value(this, tmp_name, first_read);
     return tmp_name;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTLessThan : public CProgASTExpression                         //
-////////////////////////////////////////////////////////////////////////////////
-
-// ---------------------------------------------------- Constructor / Destructor
-CProgASTLessThan::CProgASTLessThan(CProgASTExpression* lhs, CProgASTExpression* rhs) :
-    lhs_operand(lhs), rhs_operand(rhs)
-{}
-
-CProgASTLessThan::~CProgASTLessThan()
-{
-    delete lhs_operand;
-    delete rhs_operand;
-}
-
-// ----------------------------------------------------- Public Member Functions
-std::string CProgASTLessThan::build_ir(CFG* cfg) const
-{
-    std::string lhs_name = lhs_operand->build_ir(cfg);
-    std::string rhs_name = rhs_operand->build_ir(cfg);
-    std::string tmp_name = cfg->create_new_tempvar(Type::INT_64);
-    cfg->current_bb->add_IRInstr(IRInstr::cmp_lt, Type::INT_64, {tmp_name, lhs_name, rhs_name});
-    return tmp_name;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTLessThanOrEqual : public CProgASTExpression                  //
-////////////////////////////////////////////////////////////////////////////////
-
-// ---------------------------------------------------- Constructor / Destructor
-CProgASTLessThanOrEqual::CProgASTLessThanOrEqual(CProgASTExpression* lhs, CProgASTExpression* rhs) :
-    lhs_operand(lhs), rhs_operand(rhs)
-{}
-
-CProgASTLessThanOrEqual::~CProgASTLessThanOrEqual()
-{
-    delete lhs_operand;
-    delete rhs_operand;
-}
-
-// ----------------------------------------------------- Public Member Functions
-std::string CProgASTLessThanOrEqual::build_ir(CFG* cfg) const
-{
-    std::string lhs_name = lhs_operand->build_ir(cfg);
-    std::string rhs_name = rhs_operand->build_ir(cfg);
-    std::string tmp_name = cfg->create_new_tempvar(Type::INT_64);
-    cfg->current_bb->add_IRInstr(IRInstr::cmp_le, Type::INT_64, {tmp_name, lhs_name, rhs_name});
-    return tmp_name;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTGreaterThan : public CProgASTExpression                      //
-////////////////////////////////////////////////////////////////////////////////
-
-// ---------------------------------------------------- Constructor / Destructor
-CProgASTGreaterThan::CProgASTGreaterThan(CProgASTExpression* lhs, CProgASTExpression* rhs) :
-    lhs_operand(lhs), rhs_operand(rhs)
-{}
-
-CProgASTGreaterThan::~CProgASTGreaterThan()
-{
-    delete lhs_operand;
-    delete rhs_operand;
-}
-
-// ----------------------------------------------------- Public Member Functions
-std::string CProgASTGreaterThan::build_ir(CFG* cfg) const
-{
-    std::string lhs_name = lhs_operand->build_ir(cfg);
-    std::string rhs_name = rhs_operand->build_ir(cfg);
-    std::string tmp_name = cfg->create_new_tempvar(Type::INT_64);
-    cfg->current_bb->add_IRInstr(IRInstr::cmp_gt, Type::INT_64, {tmp_name, lhs_name, rhs_name});
-    return tmp_name;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTGreaterThanOrEqual : public CProgASTExpression               //
-////////////////////////////////////////////////////////////////////////////////
-
-// ---------------------------------------------------- Constructor / Destructor
-CProgASTGreaterThanOrEqual::CProgASTGreaterThanOrEqual(CProgASTExpression* lhs, CProgASTExpression* rhs) :
-    lhs_operand(lhs), rhs_operand(rhs)
-{}
-
-CProgASTGreaterThanOrEqual::~CProgASTGreaterThanOrEqual()
-{
-    delete lhs_operand;
-    delete rhs_operand;
-}
-
-// ----------------------------------------------------- Public Member Functions
-std::string CProgASTGreaterThanOrEqual::build_ir(CFG* cfg) const
+void CProgASTNot::print_debug_infos(size_t depth) const
 {
-    std::string lhs_name = lhs_operand->build_ir(cfg);
-    std::string rhs_name = rhs_operand->build_ir(cfg);
-    std::string tmp_name = cfg->create_new_tempvar(Type::INT_64);
-    cfg->current_bb->add_IRInstr(IRInstr::cmp_ge, Type::INT_64, {tmp_name, lhs_name, rhs_name});
-    return tmp_name;
+    print_debug_line(depth, "Not");
+    inner_expression->print_debug_infos(depth + 1);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-// class CProgASTEqual : public CProgASTExpression                            //
+// class CProgASTFlatExpression : public CProgASTExpression                   //
 ////////////////////////////////////////////////////////////////////////////////
 
-// ---------------------------------------------------- Constructor / Destructor
-CProgASTEqual::CProgASTEqual(CProgASTExpression* lhs, CProgASTExpression* rhs) :
-    lhs_operand(lhs), rhs_operand(rhs)
-{}
-
-CProgASTEqual::~CProgASTEqual()
-{
-    delete lhs_operand;
-    delete rhs_operand;
-}
-
 // ----------------------------------------------------- Public Member Functions
-std::string CProgASTEqual::build_ir(CFG* cfg) const
+uint32_t CProgASTFlatExpression::add_leaf(const CProgASTExpression* leaf)
 {
-    std::string lhs_name = lhs_operand->build_ir(cfg);
-    std::string rhs_name = rhs_operand->build_ir(cfg);
-    std::string tmp_name = cfg->create_new_tempvar(Type::INT_64);
-    cfg->current_bb->add_IRInstr(IRInstr::cmp_eq, Type::INT_64, {tmp_name, lhs_name, rhs_name});
-    return tmp_name;
+    nodes.push_back({IRInstr::Operation(), 0, 0, leaf});
+    return nodes.size() - 1;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTNotEqual : public CProgASTExpression                         //
-////////////////////////////////////////////////////////////////////////////////
-
-// ---------------------------------------------------- Constructor / Destructor
-CProgASTNotEqual::CProgASTNotEqual(CProgASTExpression* lhs, CProgASTExpression* rhs) :
-    lhs_operand(lhs), rhs_operand(rhs)
-{}
-
-CProgASTNotEqual::~CProgASTNotEqual()
+uint32_t CProgASTFlatExpression::add_operation(IRInstr::Operation operation, uint32_t lhs, uint32_t rhs)
 {
-    delete lhs_operand;
-    delete rhs_operand;
+    nodes.push_back({operation, lhs, rhs, nullptr});
+    return nodes.size() - 1;
 }
 
-// ----------------------------------------------------- Public Member Functions
-std::string CProgASTNotEqual::build_ir(CFG* cfg) const
-{
-    std::string lhs_name = lhs_operand->build_ir(cfg);
-    std::string rhs_name = rhs_operand->build_ir(cfg);
-    std::string tmp_name = cfg->create_new_tempvar(Type::INT_64);
-    cfg->current_bb->add_IRInstr(IRInstr::cmp_ne, Type::INT_64, {tmp_name, lhs_name, rhs_name});
-    return tmp_name;
-}
-
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTAddition : public CProgASTExpression                         //
-////////////////////////////////////////////////////////////////////////////////
-
-// ---------------------------------------------------- Constructor / Destructor
-CProgASTAddition::CProgASTAddition(CProgASTExpression* lhs, CProgASTExpression* rhs) :
-    lhs_operand(lhs), rhs_operand(rhs)
-{}
-
-CProgASTAddition::~CProgASTAddition()
+std::string CProgASTFlatExpression::build_ir(CFG* cfg) const
 {
-    delete lhs_operand;
-    delete rhs_operand;
+    std::string cached_name;
+    if (shared && cfg->find_cached_value(this, cached_name))
+        return cached_name;
+    size_t first_read = cfg->get_nb_reads();
+    // the operands of a node are always lowered before it, in the same
+    // order as the recursive build_ir of the binary expressions
+    std::vector<std::string> names(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        const Node &node = nodes[i];
+        if (node.leaf)
+        {
+            names[i] = node.leaf->build_ir(cfg);
+            continue;
+        }
+        const std::string &lhs_name = names[node.lhs];
+        const std::string &rhs_name = names[node.rhs];
+        Type result_type = Type::INT_64;
+        switch (node.operation)
+        {
+            case IRInstr::cmp_lt:
+            case IRInstr::cmp_le:
+            case IRInstr::cmp_gt:
+            case IRInstr::cmp_ge:
+            case IRInstr::cmp_eq:
+            case IRInstr::cmp_ne:
+                break;
+            default:
+                result_type = cfg->get_max_type(lhs_name, rhs_name);
+                break;
+        }
+        names[i] = cfg->create_new_tempvar(result_type);
+        cfg->current_bb->add_IRInstr(node.operation, result_type, {names[i], lhs_name, rhs_name});
+    }
+    if (shared)
+        cfg->cache_value(this, names.back(), first_read);
+    return names.back();
 }
 
-// ----------------------------------------------------- Public Member Functions
-std::string CProgASTAddition::build_ir(CFG* cfg) const
+void CProgASTFlatExpression::print_debug_infos(size_t depth) const
 {
-    std::string lhs_name = lhs_operand->build_ir(cfg);
-    std::string rhs_name = rhs_operand->build_ir(cfg);
-    Type result_type = cfg->get_max_type(lhs_name, rhs_name);
-    std::string tmp_name = cfg->create_new_tempvar(result_type);
-    cfg->current_bb->add_IRInstr(IRInstr::add, result_type, {tmp_name, lhs_name, rhs_name});
-    return tmp_name;
+    // a loop over the nodes, as build_ir()
+    print_debug_line(depth, "FlatExpression");
+    const std::string indent(2 * (depth + 1), ' ');
+    for(size_t i=0; i<nodes.size(); ++i)
+    {
+        std::ostream& os = Writer::info() << indent << "[" << i << "]";
+        if(nodes[i].leaf)
+        {
+            os << std::endl;
+            nodes[i].leaf->print_debug_infos(depth + 2);
+        }
+        else
+        {
+            os << " " << nodes[i].operation << " [" << nodes[i].lhs << "], [" << nodes[i].rhs << "]" << std::endl;
+        }
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-// class CProgASTSubtraction : public CProgASTExpression                      //
+// class CProgASTUnaryMinus : public CProgASTExpression                       //
 ////////////////////////////////////////////////////////////////////////////////
 
 // ---------------------------------------------------- Constructor / Destructor
-CProgASTSubtraction::CProgASTSubtraction(CProgASTExpression* lhs, CProgASTExpression* rhs) :
-    lhs_operand(lhs), rhs_operand(rhs)
+CProgASTUnaryMinus::CProgASTUnaryMinus(CProgASTExpression* expression) :
+    inner_expression(expression)
 {}
 
-CProgASTSubtraction::~CProgASTSubtraction()
-{
-    delete lhs_operand;
-    delete rhs_operand;
-}
-
 // ----------------------------------------------------- Public Member Functions
-std::string CProgASTSubtraction::build_ir(CFG* cfg) const
+std::string CProgASTUnaryMinus::build_ir(CFG* cfg) const
 {
-    std::string lhs_name = lhs_operand->build_ir(cfg);
-    std::string rhs_name = rhs_operand->build_ir(cfg);
-    Type result_type = cfg->get_max_type(lhs_name, rhs_name);
+    std::string cached_name;
+    if (shared && cfg->find_cached_value(this, cached_name))
+        return cached_name;
+    size_t first_read = cfg->get_nb_reads();
+    std::string exp_name = inner_expression->build_ir(cfg);
+    Type result_type = cfg->get_var_type(exp_name);
     std::string tmp_name = cfg->create_new_tempvar(result_type);
-    cfg->current_bb->add_IRInstr(IRInstr::sub, result_type, {tmp_name, lhs_name, rhs_name});
+    cfg->current_bb->add_IRInstr(IRInstr::neg, result_type, {tmp_name, exp_name});
+    if (shared)
+        cfg->cache_value(this, tmp_name, first_read);
     return tmp_name;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTMultiplication : public CProgASTExpression                   //
-////////////////////////////////////////////////////////////////////////////////
-
-// ---------------------------------------------------- Constructor / Destructor
-CProgASTMultiplication::CProgASTMultiplication(CProgASTExpression* lhs, CProgASTExpression* rhs) :
-    lhs_operand(lhs), rhs_operand(rhs)
-{}
-
-CProgASTMultiplication::~CProgASTMultiplication()
+void CProgASTUnaryMinus::print_debug_infos(size_t depth) const
 {
-    delete lhs_operand;
-    delete rhs_operand;
-}
-
-// ----------------------------------------------------- Public Member Functions
-std::string CProgASTMultiplication::build_ir(CFG* cfg) const
-{
-    std::string lhs_name = lhs_operand->build_ir(cfg);
-    std::string rhs_name = rhs_operand->build_ir(cfg);
-    Type result_type = cfg->get_max_type(lhs_name, rhs_name);
-    std::string tmp_name = cfg->create_new_tempvar(result_type);
-    cfg->current_bb->add_IRInstr(IRInstr::mul, result_type, {tmp_name, lhs_name, rhs_name});
-    return tmp_name;
+    print_debug_line(depth, "UnaryMinus");
+    inner_expression->print_debug_infos(depth + 1);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-// class CProgASTDivision : public CProgASTExpression                         //
+// class CProgASTExpect : public CProgASTExpression                           //
 ////////////////////////////////////////////////////////////////////////////////
 
 // ---------------------------------------------------- Constructor / Destructor
-CProgASTDivision::CProgASTDivision(CProgASTExpression* lhs, CProgASTExpression* rhs) :
-    lhs_operand(lhs), rhs_operand(rhs)
+CProgASTExpect::CProgASTExpect(CProgASTExpression* expression, bool expected, bool normalized) :
+    inner_expression(expression), expected_value(expected), normalized_value(normalized)
 {}
 
-CProgASTDivision::~CProgASTDivision()
-{
-    delete lhs_operand;
-    delete rhs_operand;
-}
-
 // ----------------------------------------------------- Public Member Functions
-std::string CProgASTDivision::build_ir(CFG* cfg) const
-{
-    std::string lhs_name = lhs_operand->build_ir(cfg);
-    std::string rhs_name = rhs_operand->build_ir(cfg);
-    Type result_type = cfg->get_max_type(lhs_name, rhs_name);
-    std::string tmp_name = cfg->create_new_tempvar(result_type);
-    cfg->current_bb->add_IRInstr(IRInstr::div, result_type, {tmp_name, lhs_name, rhs_name});
-    return tmp_name;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTModulo : public CProgASTExpression                           //
-////////////////////////////////////////////////////////////////////////////////
-
-// ---------------------------------------------------- Constructor / Destructor
-CProgASTModulo::CProgASTModulo(CProgASTExpression* lhs, CProgASTExpression* rhs) :
-    lhs_operand(lhs), rhs_operand(rhs)
-{}
-
-CProgASTModulo::~CProgASTModulo()
+std::string CProgASTExpect::build_ir(CFG* cfg) const
 {
-    delete lhs_operand;
-    delete rhs_operand;
+    std::string exp_name = inner_expression->build_ir(cfg);
+    if (!normalized_value)
+        return exp_name;
+    Type result_type = cfg->get_var_type(exp_name);
+    for (int i=0; i<2; ++i)
+    {
+        std::string tmp_name = cfg->create_new_tempvar(result_type);
+        cfg->current_bb->add_IRInstr(IRInstr::lnot, result_type, {tmp_name, exp_name});
+        exp_name = tmp_name;
+    }
+    return exp_name;
 }
 
-// ----------------------------------------------------- Public Member Functions
-std::string CProgASTModulo::build_ir(CFG* cfg) const
+void CProgASTExpect::print_debug_infos(size_t depth) const
 {
-    std::string lhs_name = lhs_operand->build_ir(cfg);
-    std::string rhs_name = rhs_operand->build_ir(cfg);
-    Type result_type = cfg->get_max_type(lhs_name, rhs_name);
-    std::string tmp_name = cfg->create_new_tempvar(result_type);
-    cfg->current_bb->add_IRInstr(IRInstr::mod, result_type, {tmp_name, lhs_name, rhs_name});
-    return tmp_name;
+    print_debug_line(depth, std::string("Expect : ") + (expected_value ? "1" : "0") + (normalized_value ? ", !!" : ""));
+    inner_expression->print_debug_infos(depth + 1);
 }
 
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTUnaryMinus : public CProgASTExpression                       //
-////////////////////////////////////////////////////////////////////////////////
-
-// ---------------------------------------------------- Constructor / Destructor
-CProgASTUnaryMinus::CProgASTUnaryMinus(CProgASTExpression* expression) :
-    inner_expression(expression)
-{}
-
-CProgASTUnaryMinus::~CProgASTUnaryMinus()
+std::string CProgASTExpect::build_test_ir(CFG* cfg) const
 {
-    delete inner_expression;
+    // !!expression is non zero when expression is, the branch tests the latter
+    return inner_expression->build_ir(cfg);
 }
 
-// ----------------------------------------------------- Public Member Functions
-std::string CProgASTUnaryMinus::build_ir(CFG* cfg) const
+bool CProgASTExpect::get_expected_value(bool &expected) const
 {
-    std::string exp_name = inner_expression->build_ir(cfg);
-    Type result_type = cfg->get_var_type(exp_name);
-    std::string tmp_name = cfg->create_new_tempvar(result_type);
-    cfg->current_bb->add_IRInstr(IRInstr::neg, result_type, {tmp_name, exp_name});
-    return tmp_name;
+    expected = expected_value;
+    return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1128,15 +1053,6 @@ CProgASTFunccall::CProgASTFunccall(CProgASTIdentifier* identifier) :
     func_name(identifier)
 {}
 
-CProgASTFunccall::~CProgASTFunccall()
-{
-    delete func_name;
-    for(CProgASTExpression* arg : args)
-    {
-        delete arg;
-    }
-}
-
 // ----------------------------------------------------- Public Member Functions
 void CProgASTFunccall::add_arg(CProgASTExpression* arg)
 {
@@ -1180,6 +1096,15 @@ std::string CProgASTFunccall::build_ir(CFG* cfg) const
     return tmp_name;
 }
 
+void CProgASTFunccall::print_debug_infos(size_t depth) const
+{
+    print_debug_line(depth, "Funccall : " + func_name->getText());
+    for(const CProgASTExpression* arg : args)
+    {
+        arg->print_debug_infos(depth + 1);
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTIntLiteral : public CProgASTExpression                       //
 ////////////////////////////////////////////////////////////////////////////////
@@ -1192,13 +1117,24 @@ CProgASTIntLiteral::CProgASTIntLiteral(int64_t val)
 // ----------------------------------------------------- Public Member Functions
 std::string CProgASTIntLiteral::build_ir(CFG* cfg) const
 {
+    std::string cached_name;
+    if (shared && cfg->find_cached_value(this, cached_name))
+        return cached_name;
+    size_t first_read = cfg->get_nb_reads();
     std::string tmp_name = cfg->create_new_tempvar(Type::INT_64);
     cfg->get_symbol_properties(tmp_name).initialized = true;
     std::string literal_str = std::to_string(value);
     cfg->current_bb->add_IRInstr(IRInstr::ldconst, Type::INT_64, {tmp_name, literal_str});
+    if (shared)
+        cfg->cache_value(this, tmp_name, first_read);
     return tmp_name;
 }
 
+void CProgASTIntLiteral::print_debug_infos(size_t depth) const
+{
+    print_debug_line(depth, "IntLiteral : " + std::to_string(value));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTCharLiteral : public CProgASTExpression                      //
 ////////////////////////////////////////////////////////////////////////////////
@@ -1211,6 +1147,10 @@ CProgASTCharLiteral::CProgASTCharLiteral(const std::string &val)
 // ----------------------------------------------------- Public Member Functions
 std::string CProgASTCharLiteral::build_ir(CFG* cfg) const
 {
+    std::string cached_name;
+    if (shared && cfg->find_cached_value(this, cached_name))
+        return cached_name;
+    size_t first_read = cfg->get_nb_reads();
     std::string tmp_name = cfg->create_new_tempvar(Type::CHAR);
     std::string literal_str;
     if (value.at(0) != '\\')
@@ -1255,9 +1195,16 @@ std::string CProgASTCharLiteral::build_ir(CFG* cfg) const
         }
     }
     cfg->current_bb->add_IRInstr(IRInstr::ldconst, Type::CHAR, {tmp_name, literal_str});
+    if (shared)
+        cfg->cache_value(this, tmp_name, first_read);
     return tmp_name;
 }
 
+void CProgASTCharLiteral::print_debug_infos(size_t depth) const
+{
+    print_debug_line(depth, "CharLiteral : '" + value + "'");
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTIdentifier                                                   //
 ////////////////////////////////////////////////////////////////////////////////
@@ -1275,18 +1222,23 @@ std::string CProgASTIdentifier::getText() const
 
 std::string CProgASTIdentifier::build_ir(CFG* cfg) const
 {
-    if(!cfg->is_declared(name))
+    const std::string var = cfg->lookup(name);
+    if(var.empty())
     {
         Writer::error() << "use of undeclercqed identifier '" << name << "'" << std::endl;
+        return name;
     }
-    else
+    if (!cfg->is_initialized(var))
     {
-        if (!cfg->is_initialized(name))
-        {
-            Writer::warning() << "use of uninitialized variable '" << name << "'" << std::endl;
-        }
-
-        cfg->set_used(name);
+        Writer::warning() << "use of uninitialized variable '" << name << "'" << std::endl;
     }
-    return name;
+
+    cfg->set_used(var);
+    cfg->log_read(var);
+    return var;
+}
+
+void CProgASTIdentifier::print_debug_infos(size_t depth) const
+{
+    print_debug_line(depth, "Identifier : " + name);
 }
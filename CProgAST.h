@@ -1,11 +1,13 @@
 #pragma once
 
 // ---------------------------------------------------------- C++ System Headers
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <vector>
 
 // ------------------------------------------------------------- Project Headers
+#include "Arena.h"
 #include "IR.h"
 #include "Writer.h"
 
@@ -25,23 +27,37 @@ class CProgASTAssignment;
 // class CProgAST                                                             //
 ////////////////////////////////////////////////////////////////////////////////
 
+/* The root of the AST. All the nodes of a program are created by create(),
+     from an arena that frees them at once with the program, instead of one
+     by one by the nodes owning them:
+         CProgASTIdentifier* identifier = program->create<CProgASTIdentifier>("x");
+*/
 class CProgASTProgram {
 public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTProgram() = default;
     CProgASTProgram(const CProgASTProgram& src) = delete;
-    virtual ~CProgASTProgram();
 
     // ------------------------------------------------- Public Member Functions
+    template <typename T, typename... Args>
+    T* create(Args&&... args); /**< node of this program */
     void add_funcdef(CProgASTFuncdef* funcdef);
     void build_ir(IR& ir) const;
+    void print_debug_infos() const; /**< -print-ast */
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTProgram& operator=(const CProgASTProgram& src) = delete;
 private:
+    Arena arena; /**< of the nodes, declared first to be destroyed last */
     std::vector<CProgASTFuncdef*> funcdefs;
 };
 
+template <typename T, typename... Args>
+T* CProgASTProgram::create(Args&&... args)
+{
+    return arena.create<T>(std::forward<Args>(args)...);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTFuncdef                                                      //
 ////////////////////////////////////////////////////////////////////////////////
@@ -51,16 +67,20 @@ public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTFuncdef(const std::string &id, Type type);
     CProgASTFuncdef(const CProgASTFuncdef& src) = delete;
-    virtual ~CProgASTFuncdef();
 
     // ------------------------------------------------- Public Member Functions
     void add_statement(CProgASTStatement* statement);
     void add_arg(std::string id, Type type);
+    void set_source_position(const SourcePosition &position);
     CFG* build_ir(TableOfSymbols* global_symbols) const;
+    void print_debug_infos() const;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTFuncdef& operator=(const CProgASTFuncdef& src) = delete;
 private:
+    SourcePosition position;
+    size_t first_node; /**< number of nodes created before this function, its nodes are created after it */
+    size_t nb_nodes;
     std::string identifier;
     Type return_type;
     std::vector<CProgASTStatement*> statements;
@@ -75,15 +95,26 @@ private:
 class CProgASTStatement {
 public:
     // ------------------------------------------------ Constructor / Destructor
-    CProgASTStatement() = default;
+    CProgASTStatement();
     CProgASTStatement(const CProgASTStatement& src) = delete;
     virtual ~CProgASTStatement() = default;
 
     // ------------------------------------------------- Public Member Functions
     virtual std::string build_ir(CFG* cfg) const = 0;
+    static size_t get_nb_created(); /**< statements and expressions, since the start of the compiler */
+    void set_source_position(const SourcePosition &position);
+    void enter_source_position(CFG* cfg) const; /**< the next instructions of cfg come from this statement, if its position is known */
+    virtual void print_debug_infos(size_t depth) const = 0; /**< the node, then its children one level deeper */
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTStatement& operator=(const CProgASTStatement& src) = delete;
+protected:
+    void print_debug_line(size_t depth, const std::string &node) const; /**< indented by depth, with the position */
+    static void print_optional(const CProgASTStatement* statement, size_t depth); /**< "vide" if nullptr */
+
+    SourcePosition position;
+private:
+    static size_t nb_created;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -95,11 +126,11 @@ public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTCompoundStatement() = default;
     CProgASTCompoundStatement(const CProgASTCompoundStatement& src) = delete;
-    virtual ~CProgASTCompoundStatement();
 
     // ------------------------------------------------- Public Member Functions
     void add_statement(CProgASTStatement* statement);
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTCompoundStatement& operator=(const CProgASTCompoundStatement& src) = delete;
@@ -116,10 +147,10 @@ public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTReturn(CProgASTExpression* expression);
     CProgASTReturn(const CProgASTReturn& src) = delete;
-    virtual ~CProgASTReturn();
 
     // ------------------------------------------------- Public Member Functions
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTReturn& operator=(const CProgASTReturn& src) = delete;
@@ -136,11 +167,11 @@ public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTDeclaration(Type type);
     CProgASTDeclaration(const CProgASTDeclaration& src) = delete;
-    virtual ~CProgASTDeclaration();
 
     // ------------------------------------------------- Public Member Functions
     void add_declarator(CProgASTDeclarator* declarator);
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTDeclaration& operator=(const CProgASTDeclaration& src) = delete;
@@ -158,11 +189,11 @@ public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTDeclarator(CProgASTIdentifier* id, CProgASTAssignment* init);
     CProgASTDeclarator(const CProgASTDeclarator& src) = delete;
-    virtual ~CProgASTDeclarator();
 
     // ------------------------------------------------- Public Member Functions
     void set_type(Type type);
     virtual std::string build_ir(CFG* cfg) const;
+    virtual void print_debug_infos(size_t depth) const;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTDeclarator& operator=(const CProgASTDeclarator& src) = delete;
@@ -181,10 +212,10 @@ public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTIfStatement(CProgASTExpression* condition, CProgASTStatement* if_statement, CProgASTStatement* else_statement);
     CProgASTIfStatement(const CProgASTIfStatement& src) = delete;
-    virtual ~CProgASTIfStatement();
 
     // ------------------------------------------------- Public Member Functions
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 private:
     const CProgASTExpression* condition;
     const CProgASTStatement* if_statement;
@@ -200,10 +231,10 @@ public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTWhileStatement(CProgASTExpression* condition, CProgASTStatement* body);
     CProgASTWhileStatement(const CProgASTWhileStatement& src) = delete;
-    virtual ~CProgASTWhileStatement();
 
     // ------------------------------------------------- Public Member Functions
     std::string build_ir(CFG* cfg) const;
+    void print_debug_infos(size_t depth) const;
 private:
     const CProgASTExpression* condition;
     const CProgASTStatement* body;
@@ -216,12 +247,12 @@ private:
 class CProgASTForStatement : public CProgASTStatement {
 public:
     // ------------------------------------------------ Constructor / Destructor
-    CProgASTForStatement(CProgASTExpression* initialization, CProgASTExpression* condition, CProgASTExpression* increment, CProgASTStatement* body);
+    CProgASTForStatement(CProgASTExpression* initialization, CProgASTExpression* condition, CProgASTExpression* increment, CProgASTStatement* body); /**< the expressions left out are nullptr */
     CProgASTForStatement(const CProgASTForStatement& src) = delete;
-    virtual ~CProgASTForStatement();
 
     // ------------------------------------------------- Public Member Functions
     std::string build_ir(CFG* cfg) const;
+    void print_debug_infos(size_t depth) const;
 private:
     const CProgASTExpression* initialization;
     const CProgASTExpression* condition;
@@ -242,9 +273,17 @@ public:
 
     // ------------------------------------------------- Public Member Functions
     virtual std::string build_ir(CFG* cfg) const = 0;
+    virtual bool get_expected_value(bool &expected) const; /**< true if __builtin_expect tells whether the value should be non zero */
+    virtual std::string build_test_ir(CFG* cfg) const; /**< value non zero when the expression is, by default the value of the expression */
+    std::string build_condition_ir(CFG* cfg) const; /**< value of build_test_ir(), then the cmp_null of the branch testing it */
+    void set_shared(); /**< the node has several parents, see -fhash-cons */
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTExpression& operator=(const CProgASTExpression& src) = delete;
+protected:
+    void print_debug_line(size_t depth, const std::string &node) const; /**< with ", partagé" for the shared nodes */
+
+    bool shared = false; /**< build_ir() reuses the temporary it computed before in the same block */
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -256,10 +295,10 @@ public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTAssignment(CProgASTIdentifier* identifier, CProgASTExpression* expression);
     CProgASTAssignment(const CProgASTAssignment& src) = delete;
-    virtual ~CProgASTAssignment();
 
     // ------------------------------------------------- Public Member Functions
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTAssignment& operator=(const CProgASTAssignment& src) = delete;
@@ -277,10 +316,10 @@ public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTPrePP(CProgASTExpression* expression);
     CProgASTPrePP(const CProgASTPrePP& src) = delete;
-    virtual ~CProgASTPrePP();
 
     // ------------------------------------------------- Public Member Functions
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTPrePP& operator=(const CProgASTPrePP& src) = delete;
@@ -297,10 +336,10 @@ public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTPreMM(CProgASTExpression* expression);
     CProgASTPreMM(const CProgASTPreMM& src) = delete;
-    virtual ~CProgASTPreMM();
 
     // ------------------------------------------------- Public Member Functions
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTPreMM& operator=(const CProgASTPreMM& src) = delete;
@@ -317,10 +356,10 @@ public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTPostPP(CProgASTExpression* expression);
     CProgASTPostPP(const CProgASTPostPP& src) = delete;
-    virtual ~CProgASTPostPP();
 
     // ------------------------------------------------- Public Member Functions
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTPostPP& operator=(const CProgASTPostPP& src) = delete;
@@ -337,10 +376,10 @@ public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTPostMM(CProgASTExpression* expression);
     CProgASTPostMM(const CProgASTPostMM& src) = delete;
-    virtual ~CProgASTPostMM();
 
     // ------------------------------------------------- Public Member Functions
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTPostMM& operator=(const CProgASTPostMM& src) = delete;
@@ -348,69 +387,6 @@ private:
     const CProgASTExpression* inner_expression;
 };
 
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTBAnd : public CProgASTExpression                         //
-////////////////////////////////////////////////////////////////////////////////
-
-class CProgASTBAnd : public CProgASTExpression {
-public:
-    // ------------------------------------------------ Constructor / Destructor
-    CProgASTBAnd(CProgASTExpression* lhs, CProgASTExpression* rhs);
-    CProgASTBAnd(const CProgASTBAnd& src) = delete;
-    virtual ~CProgASTBAnd();
-
-    // ------------------------------------------------- Public Member Functions
-    virtual std::string build_ir(CFG* cfg) const override;
-
-    // ---------------------------------------------------- Overloaded Operators
-    CProgASTBAnd& operator=(const CProgASTBAnd& src) = delete;
-private:
-    const CProgASTExpression* lhs_operand;
-    const CProgASTExpression* rhs_operand;
-};
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTBOr : public CProgASTExpression                         //
-////////////////////////////////////////////////////////////////////////////////
-
-class CProgASTBOr : public CProgASTExpression {
-public:
-    // ------------------------------------------------ Constructor / Destructor
-    CProgASTBOr(CProgASTExpression* lhs, CProgASTExpression* rhs);
-    CProgASTBOr(const CProgASTBOr& src) = delete;
-    virtual ~CProgASTBOr();
-
-    // ------------------------------------------------- Public Member Functions
-    virtual std::string build_ir(CFG* cfg) const override;
-
-    // ---------------------------------------------------- Overloaded Operators
-    CProgASTBOr& operator=(const CProgASTBOr& src) = delete;
-private:
-    const CProgASTExpression* lhs_operand;
-    const CProgASTExpression* rhs_operand;
-};
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTBXor : public CProgASTExpression                         //
-////////////////////////////////////////////////////////////////////////////////
-
-class CProgASTBXor : public CProgASTExpression {
-public:
-    // ------------------------------------------------ Constructor / Destructor
-    CProgASTBXor(CProgASTExpression* lhs, CProgASTExpression* rhs);
-    CProgASTBXor(const CProgASTBXor& src) = delete;
-    virtual ~CProgASTBXor();
-
-    // ------------------------------------------------- Public Member Functions
-    virtual std::string build_ir(CFG* cfg) const override;
-
-    // ---------------------------------------------------- Overloaded Operators
-    CProgASTBXor& operator=(const CProgASTBXor& src) = delete;
-private:
-    const CProgASTExpression* lhs_operand;
-    const CProgASTExpression* rhs_operand;
-};
-
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgASTBNot : public CProgASTExpression                         //
 ////////////////////////////////////////////////////////////////////////////////
@@ -420,10 +396,10 @@ public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTBNot(CProgASTExpression* expression);
     CProgASTBNot(const CProgASTBNot& src) = delete;
-    virtual ~CProgASTBNot();
 
     // ------------------------------------------------- Public Member Functions
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTBNot& operator=(const CProgASTBNot& src) = delete;
@@ -440,10 +416,10 @@ public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTAnd(CProgASTExpression* lhs, CProgASTExpression* rhs);
     CProgASTAnd(const CProgASTAnd& src) = delete;
-    virtual ~CProgASTAnd();
 
     // ------------------------------------------------- Public Member Functions
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTAnd& operator=(const CProgASTAnd& src) = delete;
@@ -461,10 +437,10 @@ public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTOr(CProgASTExpression* lhs, CProgASTExpression* rhs);
     CProgASTOr(const CProgASTOr& src) = delete;
-    virtual ~CProgASTOr();
 
     // ------------------------------------------------- Public Member Functions
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTOr& operator=(const CProgASTOr& src) = delete;
@@ -482,10 +458,10 @@ public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTNot(CProgASTExpression* expression);
     CProgASTNot(const CProgASTNot& src) = delete;
-    virtual ~CProgASTNot();
 
     // ------------------------------------------------- Public Member Functions
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTNot& operator=(const CProgASTNot& src) = delete;
@@ -494,254 +470,89 @@ private:
 };
 
 ////////////////////////////////////////////////////////////////////////////////
-// class CProgASTLessThan : public CProgASTExpression                         //
-////////////////////////////////////////////////////////////////////////////////
-
-class CProgASTLessThan : public CProgASTExpression {
-public:
-    // ------------------------------------------------ Constructor / Destructor
-    CProgASTLessThan(CProgASTExpression* lhs, CProgASTExpression* rhs);
-    CProgASTLessThan(const CProgASTLessThan& src) = delete;
-    virtual ~CProgASTLessThan();
-
-    // ------------------------------------------------- Public Member Functions
-    virtual std::string build_ir(CFG* cfg) const override;
-
-    // ---------------------------------------------------- Overloaded Operators
-    CProgASTLessThan& operator=(const CProgASTLessThan& src) = delete;
-private:
-    const CProgASTExpression* lhs_operand;
-    const CProgASTExpression* rhs_operand;
-};
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTLessThanOrEqual : public CProgASTExpression                         //
-////////////////////////////////////////////////////////////////////////////////
-
-class CProgASTLessThanOrEqual : public CProgASTExpression {
-public:
-    // ------------------------------------------------ Constructor / Destructor
-    CProgASTLessThanOrEqual(CProgASTExpression* lhs, CProgASTExpression* rhs);
-    CProgASTLessThanOrEqual(const CProgASTLessThanOrEqual& src) = delete;
-    virtual ~CProgASTLessThanOrEqual();
-
-    // ------------------------------------------------- Public Member Functions
-    virtual std::string build_ir(CFG* cfg) const override;
-
-    // ---------------------------------------------------- Overloaded Operators
-    CProgASTLessThanOrEqual& operator=(const CProgASTLessThanOrEqual& src) = delete;
-private:
-    const CProgASTExpression* lhs_operand;
-    const CProgASTExpression* rhs_operand;
-};
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTGreaterThan : public CProgASTExpression                      //
-////////////////////////////////////////////////////////////////////////////////
-
-class CProgASTGreaterThan : public CProgASTExpression {
-public:
-    // ------------------------------------------------ Constructor / Destructor
-    CProgASTGreaterThan(CProgASTExpression* lhs, CProgASTExpression* rhs);
-    CProgASTGreaterThan(const CProgASTGreaterThan& src) = delete;
-    virtual ~CProgASTGreaterThan();
-
-    // ------------------------------------------------- Public Member Functions
-    virtual std::string build_ir(CFG* cfg) const override;
-
-    // ---------------------------------------------------- Overloaded Operators
-    CProgASTGreaterThan& operator=(const CProgASTGreaterThan& src) = delete;
-private:
-    const CProgASTExpression* lhs_operand;
-    const CProgASTExpression* rhs_operand;
-};
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTGreaterThanOrEqual : public CProgASTExpression               //
-////////////////////////////////////////////////////////////////////////////////
-
-class CProgASTGreaterThanOrEqual : public CProgASTExpression {
-public:
-    // ------------------------------------------------ Constructor / Destructor
-    CProgASTGreaterThanOrEqual(CProgASTExpression* lhs, CProgASTExpression* rhs);
-    CProgASTGreaterThanOrEqual(const CProgASTGreaterThanOrEqual& src) = delete;
-    virtual ~CProgASTGreaterThanOrEqual();
-
-    // ------------------------------------------------- Public Member Functions
-    virtual std::string build_ir(CFG* cfg) const override;
-
-    // ---------------------------------------------------- Overloaded Operators
-    CProgASTGreaterThanOrEqual& operator=(const CProgASTGreaterThanOrEqual& src) = delete;
-private:
-    const CProgASTExpression* lhs_operand;
-    const CProgASTExpression* rhs_operand;
-};
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTGreaterThanOrEqual : public CProgASTExpression               //
-////////////////////////////////////////////////////////////////////////////////
-
-class CProgASTEqual : public CProgASTExpression {
-public:
-    // ------------------------------------------------ Constructor / Destructor
-    CProgASTEqual(CProgASTExpression* lhs, CProgASTExpression* rhs);
-    CProgASTEqual(const CProgASTEqual& src) = delete;
-    virtual ~CProgASTEqual();
-
-    // ------------------------------------------------- Public Member Functions
-    virtual std::string build_ir(CFG* cfg) const override;
-
-    // ---------------------------------------------------- Overloaded Operators
-    CProgASTEqual& operator=(const CProgASTEqual& src) = delete;
-private:
-    const CProgASTExpression* lhs_operand;
-    const CProgASTExpression* rhs_operand;
-};
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTNotEqual : public CProgASTExpression               //
-////////////////////////////////////////////////////////////////////////////////
-
-class CProgASTNotEqual : public CProgASTExpression {
-public:
-    // ------------------------------------------------ Constructor / Destructor
-    CProgASTNotEqual(CProgASTExpression* lhs, CProgASTExpression* rhs);
-    CProgASTNotEqual(const CProgASTNotEqual& src) = delete;
-    virtual ~CProgASTNotEqual();
-
-    // ------------------------------------------------- Public Member Functions
-    virtual std::string build_ir(CFG* cfg) const override;
-
-    // ---------------------------------------------------- Overloaded Operators
-    CProgASTNotEqual& operator=(const CProgASTNotEqual& src) = delete;
-private:
-    const CProgASTExpression* lhs_operand;
-    const CProgASTExpression* rhs_operand;
-};
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTAddition : public CProgASTExpression                         //
-////////////////////////////////////////////////////////////////////////////////
-
-class CProgASTAddition : public CProgASTExpression {
-public:
-    // ------------------------------------------------ Constructor / Destructor
-    CProgASTAddition(CProgASTExpression* lhs, CProgASTExpression* rhs);
-    CProgASTAddition(const CProgASTAddition& src) = delete;
-    virtual ~CProgASTAddition();
-
-    // ------------------------------------------------- Public Member Functions
-    virtual std::string build_ir(CFG* cfg) const override;
-
-    // ---------------------------------------------------- Overloaded Operators
-    CProgASTAddition& operator=(const CProgASTAddition& src) = delete;
-private:
-    const CProgASTExpression* lhs_operand;
-    const CProgASTExpression* rhs_operand;
-};
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTSubtraction : public CProgASTExpression                      //
+// class CProgASTFlatExpression : public CProgASTExpression                   //
 ////////////////////////////////////////////////////////////////////////////////
 
-class CProgASTSubtraction : public CProgASTExpression {
+/* Tree of binary operations (arithmetic, bitwise and comparisons, but not &&
+     and || which branch) stored as a contiguous array in post-order: the
+     operands of a node come before it and are referenced by their indices,
+     and the root is the last node. The leaves are the other expressions.
+         uint32_t a = flat->add_leaf(a_expr);
+         uint32_t b = flat->add_leaf(b_expr);
+         flat->add_operation(IRInstr::add, a, b);  // a + b
+     It is lowered by a single loop over the array, so that the depth of the
+     tree is not bounded by the native stack.
+*/
+class CProgASTFlatExpression : public CProgASTExpression {
 public:
     // ------------------------------------------------ Constructor / Destructor
-    CProgASTSubtraction(CProgASTExpression* lhs, CProgASTExpression* rhs);
-    CProgASTSubtraction(const CProgASTSubtraction& src) = delete;
-    virtual ~CProgASTSubtraction();
+    CProgASTFlatExpression() = default;
+    CProgASTFlatExpression(const CProgASTFlatExpression& src) = delete;
 
     // ------------------------------------------------- Public Member Functions
+    uint32_t add_leaf(const CProgASTExpression* leaf); /**< index of the new node */
+    uint32_t add_operation(IRInstr::Operation operation, uint32_t lhs, uint32_t rhs); /**< index of the new node */
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
-    CProgASTSubtraction& operator=(const CProgASTSubtraction& src) = delete;
+    CProgASTFlatExpression& operator=(const CProgASTFlatExpression& src) = delete;
 private:
-    const CProgASTExpression* lhs_operand;
-    const CProgASTExpression* rhs_operand;
-};
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTMultiplication : public CProgASTExpression                   //
-////////////////////////////////////////////////////////////////////////////////
-
-class CProgASTMultiplication : public CProgASTExpression {
-public:
-    // ------------------------------------------------ Constructor / Destructor
-    CProgASTMultiplication(CProgASTExpression* lhs, CProgASTExpression* rhs);
-    CProgASTMultiplication(const CProgASTMultiplication& src) = delete;
-    virtual ~CProgASTMultiplication();
-
-    // ------------------------------------------------- Public Member Functions
-    virtual std::string build_ir(CFG* cfg) const override;
-
-    // ---------------------------------------------------- Overloaded Operators
-    CProgASTMultiplication& operator=(const CProgASTMultiplication& src) = delete;
-private:
-    const CProgASTExpression* lhs_operand;
-    const CProgASTExpression* rhs_operand;
-};
-
-////////////////////////////////////////////////////////////////////////////////
-// class CProgASTDivision : public CProgASTExpression                         //
-////////////////////////////////////////////////////////////////////////////////
+    struct Node {
+        IRInstr::Operation operation; /**< unused by the leaves */
+        uint32_t lhs;
+        uint32_t rhs;
+        const CProgASTExpression* leaf; /**< nullptr for the operations */
+    };
 
-class CProgASTDivision : public CProgASTExpression {
-public:
-    // ------------------------------------------------ Constructor / Destructor
-    CProgASTDivision(CProgASTExpression* lhs, CProgASTExpression* rhs);
-    CProgASTDivision(const CProgASTDivision& src) = delete;
-    virtual ~CProgASTDivision();
-
-    // ------------------------------------------------- Public Member Functions
-    virtual std::string build_ir(CFG* cfg) const override;
-
-    // ---------------------------------------------------- Overloaded Operators
-    CProgASTDivision& operator=(const CProgASTDivision& src) = delete;
-private:
-    const CProgASTExpression* lhs_operand;
-    const CProgASTExpression* rhs_operand;
+    std::vector<Node> nodes;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
-// class CProgASTModulo : public CProgASTExpression                           //
+// class CProgASTUnaryMinus : public CProgASTExpression                       //
 ////////////////////////////////////////////////////////////////////////////////
 
-class CProgASTModulo : public CProgASTExpression {
+class CProgASTUnaryMinus : public CProgASTExpression {
 public:
     // ------------------------------------------------ Constructor / Destructor
-    CProgASTModulo(CProgASTExpression* lhs, CProgASTExpression* rhs);
-    CProgASTModulo(const CProgASTModulo& src) = delete;
-    virtual ~CProgASTModulo();
+    CProgASTUnaryMinus(CProgASTExpression* expression);
+    CProgASTUnaryMinus(const CProgASTUnaryMinus& src) = delete;
 
     // ------------------------------------------------- Public Member Functions
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
-    CProgASTModulo& operator=(const CProgASTModulo& src) = delete;
+    CProgASTUnaryMinus& operator=(const CProgASTUnaryMinus& src) = delete;
 private:
-    const CProgASTExpression* lhs_operand;
-    const CProgASTExpression* rhs_operand;
+    const CProgASTExpression* inner_expression;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
-// class CProgASTUnaryMinus : public CProgASTExpression                       //
+// class CProgASTExpect : public CProgASTExpression                           //
 ////////////////////////////////////////////////////////////////////////////////
 
-class CProgASTUnaryMinus : public CProgASTExpression {
+/** __builtin_expect(expression, value): the value of expression, likely(expression)
+      or unlikely(expression): !!expression, 0 or 1 as the usual macros. The
+      branches testing it favour the expected one */
+class CProgASTExpect : public CProgASTExpression {
 public:
     // ------------------------------------------------ Constructor / Destructor
-    CProgASTUnaryMinus(CProgASTExpression* expression);
-    CProgASTUnaryMinus(const CProgASTUnaryMinus& src) = delete;
-    virtual ~CProgASTUnaryMinus();
+    CProgASTExpect(CProgASTExpression* expression, bool expected, bool normalized = false);
+    CProgASTExpect(const CProgASTExpect& src) = delete;
 
     // ------------------------------------------------- Public Member Functions
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
+    virtual std::string build_test_ir(CFG* cfg) const override;
+    virtual bool get_expected_value(bool &expected) const override;
 
     // ---------------------------------------------------- Overloaded Operators
-    CProgASTUnaryMinus& operator=(const CProgASTUnaryMinus& src) = delete;
+    CProgASTExpect& operator=(const CProgASTExpect& src) = delete;
 private:
     const CProgASTExpression* inner_expression;
+    const bool expected_value; /**< non zero */
+    const bool normalized_value; /**< !!expression, of likely() and unlikely() */
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -753,11 +564,11 @@ public:
     // ------------------------------------------------ Constructor / Destructor
     CProgASTFunccall(CProgASTIdentifier* identifier);
     CProgASTFunccall(const CProgASTFunccall& src) = delete;
-    virtual ~CProgASTFunccall();
 
     // ------------------------------------------------- Public Member Functions
     void add_arg(CProgASTExpression* arg);
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTFunccall& operator=(const CProgASTFunccall& src) = delete;
@@ -779,6 +590,7 @@ public:
 
     // ------------------------------------------------- Public Member Functions
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTIntLiteral& operator=(const CProgASTIntLiteral& src) = delete;
@@ -799,6 +611,7 @@ public:
 
     // ------------------------------------------------- Public Member Functions
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTCharLiteral& operator=(const CProgASTCharLiteral& src) = delete;
@@ -820,6 +633,7 @@ public:
     // ------------------------------------------------- Public Member Functions
     std::string getText() const;
     virtual std::string build_ir(CFG* cfg) const override;
+    virtual void print_debug_infos(size_t depth) const override;
 
     // ---------------------------------------------------- Overloaded Operators
     CProgASTIdentifier& operator=(const CProgASTIdentifier& src) = delete;
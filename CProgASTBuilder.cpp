@@ -0,0 +1,109 @@
+// ------------------------------------------------------------- Project Headers
+#include "CProgASTBuilder.h"
+#include "CProgAST.h"
+#include "IR.h"
+
+// ---------------------------------------------------------- C++ System Headers
+#include <cstdint>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////
+// class CProgASTBuilder                                                      //
+////////////////////////////////////////////////////////////////////////////////
+
+// ---------------------------------------------------- Constructor / Destructor
+CProgASTBuilder::CProgASTBuilder(bool hash_consing) :
+    hash_consing(hash_consing)
+{}
+
+// ----------------------------------------------------- Public Member Functions
+CProgASTProgram* CProgASTBuilder::create_program()
+{
+    program = new CProgASTProgram();
+    return program;
+}
+
+CProgASTExpression* CProgASTBuilder::share(const std::string &key, CProgASTExpression* expression)
+{
+    if (!hash_consing)
+        return expression;
+    auto it = shared_expressions.find(key);
+    if (it != shared_expressions.end())
+    {
+        it->second->set_shared();
+        return it->second;
+    }
+    shared_expressions.emplace(key, expression);
+    pure_expressions.insert(expression);
+    return expression;
+}
+
+bool CProgASTBuilder::is_pure(const CProgASTExpression* expression) const
+{
+    return pure_expressions.count(expression) != 0;
+}
+
+bool CProgASTBuilder::is_hash_consing() const
+{
+    return hash_consing;
+}
+
+std::string CProgASTBuilder::get_node_key(const CProgASTExpression* expression)
+{
+    return std::to_string(reinterpret_cast<uintptr_t>(expression));
+}
+
+void CProgASTBuilder::declare_function(const std::string &function_name)
+{
+    functions.insert(function_name);
+}
+
+bool CProgASTBuilder::is_expect_call(const std::string &function_name, size_t nb_args) const
+{
+    // a function of the program with the name of a hint is called as any other
+    return nb_args == 1 && (function_name == "likely" || function_name == "unlikely") && functions.count(function_name) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class CProgASTFlatBuilder                                                  //
+////////////////////////////////////////////////////////////////////////////////
+
+// ---------------------------------------------------- Constructor / Destructor
+CProgASTFlatBuilder::CProgASTFlatBuilder(CProgASTBuilder &builder) :
+    builder(builder), flat(builder.create<CProgASTFlatExpression>())
+{}
+
+// ----------------------------------------------------- Public Member Functions
+uint32_t CProgASTFlatBuilder::add_leaf(CProgASTExpression* leaf)
+{
+    if (!builder.is_pure(leaf))
+    {
+        // the leaf may write the variables read by the nodes before it
+        pure = false;
+        node_indices.clear();
+        return flat->add_leaf(leaf);
+    }
+    std::string node_key = "l" + CProgASTBuilder::get_node_key(leaf) + ";";
+    auto it = node_indices.find(node_key);
+    if (it == node_indices.end())
+        it = node_indices.emplace(node_key, flat->add_leaf(leaf)).first;
+    key += node_key;
+    return it->second;
+}
+
+uint32_t CProgASTFlatBuilder::add_operation(IRInstr::Operation operation, uint32_t lhs, uint32_t rhs)
+{
+    if (!builder.is_hash_consing())
+        return flat->add_operation(operation, lhs, rhs);
+    std::string node_key = "o" + std::to_string(operation) + "," + std::to_string(lhs) + "," + std::to_string(rhs) + ";";
+    auto it = node_indices.find(node_key);
+    if (it == node_indices.end())
+        it = node_indices.emplace(node_key, flat->add_operation(operation, lhs, rhs)).first;
+    key += node_key;
+    return it->second;
+}
+
+CProgASTExpression* CProgASTFlatBuilder::get_expression()
+{
+    return pure ? builder.share(key, flat) : flat;
+}
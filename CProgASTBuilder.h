@@ -0,0 +1,102 @@
+#pragma once
+
+// ---------------------------------------------------------- C++ System Headers
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+// ------------------------------------------------------------- Project Headers
+#include "CProgAST.h"
+#include "IR.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// class CProgASTBuilder                                                      //
+////////////////////////////////////////////////////////////////////////////////
+
+/* Creates the nodes of the AST for the front ends, CProgCSTVisitor from the
+     ANTLR parse tree and CProgFastParser from the tokens, so that both build
+     the same AST. With -fhash-cons, the expressions without side effects are
+     hash-consed: each one is keyed by its kind, its operands and its literal
+     or identifier, and the identical ones are a single node with several
+     parents, whose value is computed once per block.
+*/
+class CProgASTBuilder {
+public:
+    // ------------------------------------------------ Constructor / Destructor
+    CProgASTBuilder(bool hash_consing);
+    CProgASTBuilder(const CProgASTBuilder& src) = delete;
+
+    // ------------------------------------------------- Public Member Functions
+    CProgASTProgram* create_program(); /**< owned by the caller, the next nodes are created in it */
+    template <typename T, typename... Args>
+    T* create(Args&&... args); /**< node of the program */
+    template <typename T, typename... Args>
+    CProgASTExpression* create_shared(const std::string &key, Args&&... args); /**< node of the expression without side effects identified by key, the existing one with -fhash-cons */
+    CProgASTExpression* share(const std::string &key, CProgASTExpression* expression); /**< expression, or the existing node with the same key with -fhash-cons */
+    bool is_pure(const CProgASTExpression* expression) const; /**< hash-consed, without side effects */
+    bool is_hash_consing() const;
+    static std::string get_node_key(const CProgASTExpression* expression); /**< of a hash-consed node, in the keys of its parents */
+    void declare_function(const std::string &function_name); /**< defined by the program, before its calls are built */
+    bool is_expect_call(const std::string &function_name, size_t nb_args) const; /**< likely(x) or unlikely(x) the program does not define, built as a CProgASTExpect */
+
+    // ---------------------------------------------------- Overloaded Operators
+    CProgASTBuilder& operator=(const CProgASTBuilder& src) = delete;
+private:
+    CProgASTProgram* program = nullptr; /**< being built, it creates the nodes */
+    const bool hash_consing; /**< -fhash-cons */
+    std::unordered_map<std::string, CProgASTExpression*> shared_expressions; /**< by key */
+    std::unordered_set<const CProgASTExpression*> pure_expressions; /**< the nodes of shared_expressions */
+    std::unordered_set<std::string> functions; /**< declared by declare_function() */
+};
+
+template <typename T, typename... Args>
+T* CProgASTBuilder::create(Args&&... args)
+{
+    return program->create<T>(std::forward<Args>(args)...);
+}
+
+template <typename T, typename... Args>
+CProgASTExpression* CProgASTBuilder::create_shared(const std::string &key, Args&&... args)
+{
+    if (!hash_consing)
+        return program->create<T>(std::forward<Args>(args)...);
+    auto it = shared_expressions.find(key);
+    if (it != shared_expressions.end())
+    {
+        it->second->set_shared();
+        return it->second;
+    }
+    return share(key, program->create<T>(std::forward<Args>(args)...));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class CProgASTFlatBuilder                                                  //
+////////////////////////////////////////////////////////////////////////////////
+
+/* A CProgASTFlatExpression being built, its nodes added in post-order. With
+     -fhash-cons, the identical nodes of the array are added once, as long as
+     no leaf with side effects runs between them, and the whole expression is
+     shared when all its leaves are pure.
+*/
+class CProgASTFlatBuilder {
+public:
+    // ------------------------------------------------ Constructor / Destructor
+    CProgASTFlatBuilder(CProgASTBuilder &builder);
+    CProgASTFlatBuilder(const CProgASTFlatBuilder& src) = delete;
+
+    // ------------------------------------------------- Public Member Functions
+    uint32_t add_leaf(CProgASTExpression* leaf); /**< index of the node */
+    uint32_t add_operation(IRInstr::Operation operation, uint32_t lhs, uint32_t rhs); /**< index of the node */
+    CProgASTExpression* get_expression(); /**< once all the nodes are added */
+
+    // ---------------------------------------------------- Overloaded Operators
+    CProgASTFlatBuilder& operator=(const CProgASTFlatBuilder& src) = delete;
+private:
+    CProgASTBuilder &builder;
+    CProgASTFlatExpression* flat;
+    std::unordered_map<std::string, uint32_t> node_indices; /**< of the identical nodes, by key */
+    std::string key = "f"; /**< of the expression, for CProgASTBuilder::share() */
+    bool pure = true;
+};
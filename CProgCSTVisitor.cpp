@@ -1,20 +1,35 @@
 // ------------------------------------------------------------- Project Headers
 #include "CProgCSTVisitor.h"
 #include "CProgAST.h"
+#include "CProgASTBuilder.h"
 #include "IR.h"
+#include "Options.h"
 #include "Writer.h"
 
 // ---------------------------------------------------------- C++ System Headers
+#include <cstdint>
 #include <iostream>
 #include <string>
+#include <vector>
 
 ////////////////////////////////////////////////////////////////////////////////
 // class CProgCSTVisitor                                                      //
 ////////////////////////////////////////////////////////////////////////////////
 
+// ---------------------------------------------------- Constructor / Destructor
+CProgCSTVisitor::CProgCSTVisitor(const Options &options) :
+    builder(options.hash_consing)
+{}
+
+// ----------------------------------------------------- Public Member Functions
 antlrcpp::Any CProgCSTVisitor::visitProgram(CProgParser::ProgramContext *ctx)
 {
-    CProgASTProgram *program = new CProgASTProgram();
+    CProgASTProgram* program = builder.create_program();
+    // the calls may come before the definition of the function
+    for(auto funcdef_ctx : ctx->funcdef())
+    {
+        builder.declare_function(funcdef_ctx->IDENTIFIER()->getText());
+    }
     for(auto funcdef_ctx : ctx->funcdef())
     {
         program->add_funcdef(visit(funcdef_ctx).as<CProgASTFuncdef*>());
@@ -25,7 +40,8 @@ antlrcpp::Any CProgCSTVisitor::visitProgram(CProgParser::ProgramContext *ctx)
 antlrcpp::Any CProgCSTVisitor::visitFuncdef(CProgParser::FuncdefContext *ctx)
 {
     std::string identifier = ctx->IDENTIFIER()->getText();
-    CProgASTFuncdef *funcdef = new CProgASTFuncdef(identifier, Type::INT_64);
+    CProgASTFuncdef *funcdef = builder.create<CProgASTFuncdef>(identifier, Type::INT_64);
+    funcdef->set_source_position(get_source_position(ctx));
     if(ctx->arg_decl_list())
     {
         size_t i;
@@ -59,44 +75,48 @@ antlrcpp::Any CProgCSTVisitor::visitFuncdef(CProgParser::FuncdefContext *ctx)
 
 antlrcpp::Any CProgCSTVisitor::visitStatement(CProgParser::StatementContext *ctx)
 {
+    CProgASTStatement* statement = nullptr;
     if(ctx->return_statement() != nullptr)
     {
-        return static_cast<CProgASTStatement*>(visit(ctx->return_statement()).as<CProgASTReturn*>());
+        statement = visit(ctx->return_statement()).as<CProgASTReturn*>();
     }
     else if(ctx->declaration() != nullptr)
     {
-        return static_cast<CProgASTStatement*>(visit(ctx->declaration()).as<CProgASTDeclaration*>());
+        statement = visit(ctx->declaration()).as<CProgASTDeclaration*>();
     }
     else if(ctx->expr() != nullptr)
     {
-        return static_cast<CProgASTStatement*>(visit(ctx->expr()).as<CProgASTExpression*>());
+        statement = visit(ctx->expr()).as<CProgASTExpression*>();
     }
     else if(ctx->if_condition() != nullptr)
     {
-        return static_cast<CProgASTStatement*>(visit(ctx->if_condition()).as<CProgASTIfStatement*>());
+        statement = visit(ctx->if_condition()).as<CProgASTIfStatement*>();
     }
     else if(ctx->while_statement() != nullptr)
     {
-        return static_cast<CProgASTStatement*>(visit(ctx->while_statement()).as<CProgASTWhileStatement*>());
+        statement = visit(ctx->while_statement()).as<CProgASTWhileStatement*>();
     }
     else if(ctx->for_statement() != nullptr)
     {
-        return static_cast<CProgASTStatement*>(visit(ctx->for_statement()).as<CProgASTForStatement*>());
+        statement = visit(ctx->for_statement()).as<CProgASTForStatement*>();
     }
     else if(ctx->compound_statement() != nullptr)
     {
-        return static_cast<CProgASTStatement*>(visit(ctx->compound_statement()).as<CProgASTCompoundStatement*>());
+        statement = visit(ctx->compound_statement()).as<CProgASTCompoundStatement*>();
     }
     else
     {
         Writer::error() << "empty statement currently not supported" << std::endl;
-        return nullptr;
+        return statement;
     }
+    if(statement)
+        statement->set_source_position(get_source_position(ctx));
+    return statement;
 }
 
 antlrcpp::Any CProgCSTVisitor::visitReturn_statement(CProgParser::Return_statementContext *ctx)
 {
-    return new CProgASTReturn(visit(ctx->expr()).as<CProgASTExpression*>());
+    return builder.create<CProgASTReturn>(visit(ctx->expr()).as<CProgASTExpression*>());
 }
 
 antlrcpp::Any CProgCSTVisitor::visitDeclaration(CProgParser::DeclarationContext *ctx)
@@ -121,21 +141,21 @@ antlrcpp::Any CProgCSTVisitor::visitDeclaration(CProgParser::DeclarationContext
         return nullptr;
     }
 
-    CProgASTDeclaration* declaration = new CProgASTDeclaration(type);
+    CProgASTDeclaration* declaration = builder.create<CProgASTDeclaration>(type);
     for(auto declarator_ctx : ctx->declarator())
     {
         CProgASTIdentifier* identifier = nullptr;
         CProgASTAssignment* initializer = nullptr;
         if(declarator_ctx->IDENTIFIER() != nullptr)
         {
-            identifier = new CProgASTIdentifier(declarator_ctx->IDENTIFIER()->getText());
+            identifier = builder.create<CProgASTIdentifier>(declarator_ctx->IDENTIFIER()->getText());
         }
         else if(declarator_ctx->assignment() != nullptr)
         {
             initializer = visit(declarator_ctx->assignment()).as<CProgASTAssignment*>();
-            identifier = new CProgASTIdentifier(declarator_ctx->assignment()->IDENTIFIER()->getText());
+            identifier = builder.create<CProgASTIdentifier>(declarator_ctx->assignment()->IDENTIFIER()->getText());
         }
-        declaration->add_declarator(new CProgASTDeclarator(identifier, initializer));
+        declaration->add_declarator(builder.create<CProgASTDeclarator>(identifier, initializer));
     }
     return declaration;
 }
@@ -143,41 +163,56 @@ antlrcpp::Any CProgCSTVisitor::visitDeclaration(CProgParser::DeclarationContext
 antlrcpp::Any CProgCSTVisitor::visitIf_condition(CProgParser::If_conditionContext *ctx)
 {
     CProgASTExpression* condition = visit(ctx->expr()).as<CProgASTExpression*>();
+    condition->set_source_position(get_source_position(ctx->expr()));
     CProgASTStatement* if_statement = visit(ctx->statement(0)).as<CProgASTStatement*>();
     CProgASTStatement* else_statement = nullptr;
     if(ctx->statement().size() > 1)
     {
         else_statement = visit(ctx->statement(1)).as<CProgASTStatement*>();
     }
-    return new CProgASTIfStatement(condition, if_statement, else_statement);
+    return builder.create<CProgASTIfStatement>(condition, if_statement, else_statement);
 }
 
 antlrcpp::Any CProgCSTVisitor::visitWhile_statement(CProgParser::While_statementContext *ctx)
 {
     CProgASTExpression* condition = visit(ctx->expr()).as<CProgASTExpression*>();
+    condition->set_source_position(get_source_position(ctx->expr()));
     CProgASTStatement* body = visit(ctx->statement()).as<CProgASTStatement*>();
-    return new CProgASTWhileStatement(condition, body);
+    return builder.create<CProgASTWhileStatement>(condition, body);
 }
 
 antlrcpp::Any CProgCSTVisitor::visitFor_statement(CProgParser::For_statementContext *ctx)
 {
-    CProgASTExpression* initialization = visit(ctx->expr(0)).as<CProgASTExpression*>();
-    CProgASTExpression* condition = visit(ctx->expr(1)).as<CProgASTExpression*>();
-    CProgASTExpression* increment = visit(ctx->expr(2)).as<CProgASTExpression*>();
+    // each expression may be left out, the ';' before it tells which one it is
+    CProgASTExpression* expressions[3] = {nullptr, nullptr, nullptr};
+    size_t index = 0;
+    for(antlr4::tree::ParseTree* child : ctx->children)
+    {
+        CProgParser::ExprContext* expr_ctx = dynamic_cast<CProgParser::ExprContext*>(child);
+        if(expr_ctx)
+        {
+            expressions[index] = visit(expr_ctx).as<CProgASTExpression*>();
+            expressions[index]->set_source_position(get_source_position(expr_ctx));
+        }
+        else if(child->getText() == ";")
+        {
+            ++index;
+        }
+    }
     CProgASTStatement* body = visit(ctx->statement()).as<CProgASTStatement*>();
-    return new CProgASTForStatement(initialization, condition, increment, body);
+    return builder.create<CProgASTForStatement>(expressions[0], expressions[1], expressions[2], body);
 }
 
 antlrcpp::Any CProgCSTVisitor::visitAssignment(CProgParser::AssignmentContext *ctx)
 {
-    CProgASTIdentifier* identifier = new CProgASTIdentifier(ctx->IDENTIFIER()->getText());
+    CProgASTIdentifier* identifier = builder.create<CProgASTIdentifier>(ctx->IDENTIFIER()->getText());
     CProgASTExpression* expression = visit(ctx->expr()).as<CProgASTExpression*>();
-    return new CProgASTAssignment(identifier, expression);
+    return builder.create<CProgASTAssignment>(identifier, expression);
 }
 
 antlrcpp::Any CProgCSTVisitor::visitCompound_statement(CProgParser::Compound_statementContext *ctx)
 {
-    CProgASTCompoundStatement* compound_statement = new CProgASTCompoundStatement();
+    CProgASTCompoundStatement* compound_statement = builder.create<CProgASTCompoundStatement>();
     for(auto statement_ctx : ctx->statement())
     {
         compound_statement->add_statement(visit(statement_ctx).as<CProgASTStatement*>());
@@ -193,17 +228,24 @@ antlrcpp::Any CProgCSTVisitor::visitExpr(CProgParser::ExprContext *ctx)
     {
         if(ctx->INT_LITERAL())
         {
-            rexpr = new CProgASTIntLiteral(std::stoi(ctx->INT_LITERAL()->getText()));
+            int64_t value = std::stoi(ctx->INT_LITERAL()->getText());
+            rexpr = builder.create_shared<CProgASTIntLiteral>("i" + std::to_string(value), value);
         }
         else if(ctx->CHAR_LITERAL())
         {
             std::string literal = ctx->CHAR_LITERAL()->getText();
-            rexpr = new CProgASTCharLiteral(literal.substr(1, literal.size()-2));
+            rexpr = builder.create_shared<CProgASTCharLiteral>("c" + literal, literal.substr(1, literal.size()-2));
+        }
+        else if (ctx->ARG_OP && builder.is_expect_call(ctx->IDENTIFIER()->getText(), ctx->arg_list() ? ctx->arg_list()->expr().size() : 0))
+        {
+            // likely(x) and unlikely(x), the usual macros of __builtin_expect, are not keywords
+            CProgASTExpression* expr = visit(ctx->arg_list()->expr(0)).as<CProgASTExpression*>();
+            rexpr = builder.create<CProgASTExpect>(expr, ctx->IDENTIFIER()->getText() == "likely", true);
         }
         else if (ctx->ARG_OP)
         {
-            CProgASTIdentifier* func_name = new CProgASTIdentifier(ctx->IDENTIFIER()->getText());
-            CProgASTFunccall* func_call = new CProgASTFunccall(func_name);
+            CProgASTIdentifier* func_name = builder.create<CProgASTIdentifier>(ctx->IDENTIFIER()->getText());
+            CProgASTFunccall* func_call = builder.create<CProgASTFunccall>(func_name);
             if(ctx->arg_list())
             {
                 for(auto arg_ctx : ctx->arg_list()->expr())
@@ -215,7 +257,7 @@ antlrcpp::Any CProgCSTVisitor::visitExpr(CProgParser::ExprContext *ctx)
         }
         else if(ctx->IDENTIFIER())
         {
-            rexpr = new CProgASTIdentifier(ctx->IDENTIFIER()->getText());
+            rexpr = builder.create_shared<CProgASTIdentifier>("v" + ctx->IDENTIFIER()->getText(), ctx->IDENTIFIER()->getText());
         }
     }
     else if (op_size == 1)
@@ -225,15 +267,19 @@ antlrcpp::Any CProgCSTVisitor::visitExpr(CProgParser::ExprContext *ctx)
         {
             rexpr = expr;
         }
+        else if (ctx->EXPECT_OP)
+        {
+            rexpr = builder.create<CProgASTExpect>(expr, std::stoll(ctx->INT_LITERAL()->getText()) != 0);
+        }
         else if (ctx->POSTFIX_OP)
         {
             if(ctx->OP_PP())
             {
-                rexpr = new CProgASTPostPP(expr);
+                rexpr = builder.create<CProgASTPostPP>(expr);
             }
             else if(ctx->OP_MM())
             {
-                rexpr = new CProgASTPostMM(expr);
+                rexpr = builder.create<CProgASTPostMM>(expr);
             }
         }
         else if (ctx->PREFIX_OP)
@@ -244,115 +290,139 @@ antlrcpp::Any CProgCSTVisitor::visitExpr(CProgParser::ExprContext *ctx)
             }
             else if(ctx->OP_MINUS())
             {
-                rexpr = new CProgASTUnaryMinus(expr);
+                rexpr = builder.is_pure(expr) ? builder.create_shared<CProgASTUnaryMinus>("-" + CProgASTBuilder::get_node_key(expr), expr)
+                                      : builder.create<CProgASTUnaryMinus>(expr);
             }
             else if(ctx->OP_PP())
             {
-                rexpr = new CProgASTPrePP(expr);
+                rexpr = builder.create<CProgASTPrePP>(expr);
             }
             else if(ctx->OP_MM())
             {
-                rexpr = new CProgASTPreMM(expr);
+                rexpr = builder.create<CProgASTPreMM>(expr);
             }
             else if(ctx->OP_NOT())
             {
-                rexpr = new CProgASTNot(expr);
+                rexpr = builder.is_pure(expr) ? builder.create_shared<CProgASTNot>("!" + CProgASTBuilder::get_node_key(expr), expr)
+                                      : builder.create<CProgASTNot>(expr);
             }
             else if(ctx->OP_BNOT())
             {
-                rexpr = new CProgASTBNot(expr);
+                rexpr = builder.is_pure(expr) ? builder.create_shared<CProgASTBNot>("~" + CProgASTBuilder::get_node_key(expr), expr)
+                                      : builder.create<CProgASTBNot>(expr);
             }
         }
         else if (ctx->OP_ASGN())
         {
-            CProgASTIdentifier *identifier = new CProgASTIdentifier(ctx->IDENTIFIER()->getText());
-            rexpr = new CProgASTAssignment(identifier, expr);
+            CProgASTIdentifier *identifier = builder.create<CProgASTIdentifier>(ctx->IDENTIFIER()->getText());
+            rexpr = builder.create<CProgASTAssignment>(identifier, expr);
         }
     }
     else if (op_size == 2)
     {
-        CProgASTExpression* lhs = visit(ctx->expr(0)).as<CProgASTExpression*>();
-        CProgASTExpression* rhs = visit(ctx->expr(1)).as<CProgASTExpression*>();
-        if(ctx->OP_MUL())
-        {
-            rexpr = new CProgASTMultiplication(lhs, rhs);
-        }
-        else if(ctx->OP_DIV())
-        {
-            rexpr = new CProgASTDivision(lhs, rhs);
-        }
-        else if(ctx->OP_MOD())
-        {
-            rexpr = new CProgASTModulo(lhs, rhs);
-        }
-        else if(ctx->OP_PLUS())
-        {
-            rexpr = new CProgASTAddition(lhs, rhs);
-        }
-        else if(ctx->OP_MINUS())
-        {
-            rexpr = new CProgASTSubtraction(lhs, rhs);
-        }
-        else if(ctx->OP_BAND())
-        {
-            rexpr = new CProgASTBAnd(lhs, rhs);
-        }
-        else if(ctx->OP_BOR())
-        {
-            rexpr = new CProgASTBOr(lhs, rhs);
-        }
-        else if(ctx->OP_BXOR())
-        {
-            rexpr = new CProgASTBXor(lhs, rhs);
-        }
-        else if(ctx->OP_AND())
+        IRInstr::Operation operation;
+        if (get_flat_operation(ctx, operation))
         {
-            rexpr = new CProgASTAnd(lhs, rhs);
+            rexpr = build_flat_expression(ctx);
         }
-        else if(ctx->OP_OR())
+        else
         {
-            rexpr = new CProgASTOr(lhs, rhs);
-        }
-        else if(ctx->OP_LT())
-        {
-            rexpr = new CProgASTLessThan(lhs, rhs);
-        }
-        else if(ctx->OP_LTE())
-        {
-            rexpr = new CProgASTLessThanOrEqual(lhs, rhs);
-        }
-        else if(ctx->OP_GT())
-        {
-            rexpr = new CProgASTGreaterThan(lhs, rhs);
-        }
-        else if(ctx->OP_GTE())
-        {
-            rexpr = new CProgASTGreaterThanOrEqual(lhs, rhs);
-        }
-        else if(ctx->OP_EQ())
-        {
-            rexpr = new CProgASTEqual(lhs, rhs);
-        }
-        else if(ctx->OP_NE())
-        {
-            rexpr = new CProgASTNotEqual(lhs, rhs);
-        }
-        else if(ctx->OP_LT())
-        {
-            rexpr = new CProgASTLessThan(lhs, rhs);
+            CProgASTExpression* lhs = visit(ctx->expr(0)).as<CProgASTExpression*>();
+            CProgASTExpression* rhs = visit(ctx->expr(1)).as<CProgASTExpression*>();
+            if(ctx->OP_AND())
+            {
+                rexpr = builder.create<CProgASTAnd>(lhs, rhs);
+            }
+            else if(ctx->OP_OR())
+            {
+                rexpr = builder.create<CProgASTOr>(lhs, rhs);
+            }
         }
-        else if(ctx->OP_GT())
+    }
+    return rexpr;
+}
+
+// ---------------------------------------------------- Private Member Functions
+CProgASTExpression* CProgCSTVisitor::build_flat_expression(CProgParser::ExprContext *ctx)
+{
+    // iterative post-order traversal of the flat operations below ctx: the
+    // native stack does not grow with the length of a chain like a+b+c+...
+    struct Frame {
+        CProgParser::ExprContext *ctx;
+        bool expanded; /**< the operands are already on the stack */
+    };
+    CProgASTFlatBuilder flat(builder);
+    std::vector<Frame> frames = {{ctx, false}};
+    std::vector<uint32_t> operands;
+    while (!frames.empty())
+    {
+        Frame frame = frames.back();
+        frames.pop_back();
+        CProgParser::ExprContext *expr_ctx = frame.ctx;
+        while (expr_ctx->PAR_OP)
+            expr_ctx = expr_ctx->expr(0);
+        IRInstr::Operation operation;
+        if (!get_flat_operation(expr_ctx, operation))
         {
-            rexpr = new CProgASTGreaterThan(lhs, rhs);
+            operands.push_back(flat.add_leaf(visit(expr_ctx).as<CProgASTExpression*>()));
         }
-        else if(ctx->OP_LTE())
+        else if (!frame.expanded)
         {
-            rexpr = new CProgASTLessThanOrEqual(lhs, rhs);
+            frames.push_back({expr_ctx, true});
+            frames.push_back({expr_ctx->expr(1), false});
+            frames.push_back({expr_ctx->expr(0), false});
         }
-        else if(ctx->OP_GTE())
+        else
         {
-            rexpr = new CProgASTGreaterThanOrEqual(lhs, rhs);
+            uint32_t rhs = operands.back();
+            operands.pop_back();
+            uint32_t lhs = operands.back();
+            operands.pop_back();
+            operands.push_back(flat.add_operation(operation, lhs, rhs));
         }
     }
-    return rexpr;
+    return flat.get_expression();
+}
+
+bool CProgCSTVisitor::get_flat_operation(CProgParser::ExprContext *ctx, IRInstr::Operation &operation)
+{
+    if (ctx->expr().size() != 2)
+        return false;
+    if (ctx->OP_MUL())
+        operation = IRInstr::mul;
+    else if (ctx->OP_DIV())
+        operation = IRInstr::div;
+    else if (ctx->OP_MOD())
+        operation = IRInstr::mod;
+    else if (ctx->OP_PLUS())
+        operation = IRInstr::add;
+    else if (ctx->OP_MINUS())
+        operation = IRInstr::sub;
+    else if (ctx->OP_BAND())
+        operation = IRInstr::band;
+    else if (ctx->OP_BOR())
+        operation = IRInstr::bor;
+    else if (ctx->OP_BXOR())
+        operation = IRInstr::bxor;
+    else if (ctx->OP_LT())
+        operation = IRInstr::cmp_lt;
+    else if (ctx->OP_LTE())
+        operation = IRInstr::cmp_le;
+    else if (ctx->OP_GT())
+        operation = IRInstr::cmp_gt;
+    else if (ctx->OP_GTE())
+        operation = IRInstr::cmp_ge;
+    else if (ctx->OP_EQ())
+        operation = IRInstr::cmp_eq;
+    else if (ctx->OP_NE())
+        operation = IRInstr::cmp_ne;
+    else
+        return false;
+    return true;
+}
+
+SourcePosition CProgCSTVisitor::get_source_position(antlr4::ParserRuleContext *ctx)
+{
+    // ANTLR columns start from 0
+    return SourcePosition(ctx->getStart()->getLine(), ctx->getStart()->getCharPositionInLine() + 1);
 }
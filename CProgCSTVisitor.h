@@ -3,12 +3,21 @@
 // ------------------------------------------------------------- Project Headers
 #include "antlr4-runtime.h"
 #include "CProgBaseVisitor.h"
+#include "CProgASTBuilder.h"
+#include "IR.h"
 
-// ---------------------------------------------------------- C++ System Headers
-#include <string>
+////////////////////////////////////////////////////////////////////////////////
+// Forward Declarations                                                       //
+////////////////////////////////////////////////////////////////////////////////
 
+class CProgASTExpression;
+struct Options;
+
+/** Builds the AST of the parse tree, with the nodes of CProgASTBuilder */
 class CProgCSTVisitor : public CProgBaseVisitor {
 public:
+    CProgCSTVisitor(const Options &options);
+
     virtual antlrcpp::Any visitProgram(CProgParser::ProgramContext *ctx) override;
     virtual antlrcpp::Any visitFuncdef(CProgParser::FuncdefContext *ctx) override;
     virtual antlrcpp::Any visitStatement(CProgParser::StatementContext *ctx) override;
@@ -20,4 +29,10 @@ public:
     virtual antlrcpp::Any visitAssignment(CProgParser::AssignmentContext *ctx) override;
     virtual antlrcpp::Any visitCompound_statement(CProgParser::Compound_statementContext *ctx) override;
     virtual antlrcpp::Any visitExpr(CProgParser::ExprContext *ctx) override;
+private:
+    CProgASTExpression* build_flat_expression(CProgParser::ExprContext *ctx); /**< of the flat operations rooted at ctx, without recursion */
+    static bool get_flat_operation(CProgParser::ExprContext *ctx, IRInstr::Operation &operation); /**< of a binary ctx lowered by a CProgASTFlatExpression */
+    static SourcePosition get_source_position(antlr4::ParserRuleContext *ctx); /**< of the first token of ctx */
+
+    CProgASTBuilder builder;
 };
@@ -0,0 +1,845 @@
+// ------------------------------------------------------------- Project Headers
+#include "CProgFastParser.h"
+#include "CProgAST.h"
+#include "CProgASTBuilder.h"
+#include "IR.h"
+#include "Options.h"
+#include "Writer.h"
+
+// ---------------------------------------------------------- C++ System Headers
+#include <cctype>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static const std::unordered_map<std::string, CProgTokenKind> keywords =
+{
+    { "void",             CProgTokenKind::VOID_TYPE_NAME },
+    { "int",              CProgTokenKind::INT_TYPE_NAME },
+    { "int16_t",          CProgTokenKind::INT_16_TYPE_NAME },
+    { "int32_t",          CProgTokenKind::INT_32_TYPE_NAME },
+    { "int64_t",          CProgTokenKind::INT_64_TYPE_NAME },
+    { "char",             CProgTokenKind::CHAR_TYPE_NAME },
+    { "return",           CProgTokenKind::RETURN },
+    { "if",               CProgTokenKind::IF },
+    { "else",             CProgTokenKind::ELSE },
+    { "while",            CProgTokenKind::WHILE },
+    { "for",              CProgTokenKind::FOR },
+    { "__builtin_expect", CProgTokenKind::BUILTIN_EXPECT }
+};
+
+// binding power of the prefix operators, above the one of every binary operator
+static const int PREFIX_PRECEDENCE = 10;
+
+// the tokens ANTLR lists in its syntax errors before a choice, in the order of
+// their types in CProg.g4
+static const char TYPE_NAMES[] = "{'void', 'int', 'int16_t', 'int32_t', 'int64_t', 'char', IDENTIFIER}";
+static const char ARGUMENTS_START[] = "{')', 'void', 'int', 'int16_t', 'int32_t', 'int64_t', 'char', IDENTIFIER}";
+static const char STATEMENT_START[] = "{'(', ';', '{', 'void', 'int', 'int16_t', 'int32_t', 'int64_t', 'char', 'return', 'if', 'while', 'for', '__builtin_expect', '++', '--', '+', '-', '!', '~', INT_LITERAL, CHAR_LITERAL, IDENTIFIER}";
+static const char BLOCK_STATEMENT_START[] = "{'(', ';', '{', '}', 'void', 'int', 'int16_t', 'int32_t', 'int64_t', 'char', 'return', 'if', 'while', 'for', '__builtin_expect', '++', '--', '+', '-', '!', '~', INT_LITERAL, CHAR_LITERAL, IDENTIFIER}";
+static const char EXPRESSION_START[] = "{'(', '__builtin_expect', '++', '--', '+', '-', '!', '~', INT_LITERAL, CHAR_LITERAL, IDENTIFIER}";
+
+////////////////////////////////////////////////////////////////////////////////
+// class CProgFastLexer                                                       //
+////////////////////////////////////////////////////////////////////////////////
+
+// ----------------------------------------------------------------- Constructor
+CProgFastLexer::CProgFastLexer(const std::string &source) :
+    source(source), position(0), line(1), column(0), nb_errors(0)
+{}
+
+// ----------------------------------------------------- Public Member Functions
+std::vector<CProgToken> CProgFastLexer::tokenize()
+{
+    std::vector<CProgToken> tokens;
+    while(position < source.size())
+    {
+        char c = peek();
+        size_t start = position;
+        size_t start_line = line;
+        size_t start_column = column;
+
+        if(c == ' ' || c == '\t' || c == '\r' || c == '\n')
+        {
+            advance();
+        }
+        else if(c == '/' && peek(1) == '/')
+        {
+            while(position < source.size() && peek() != '\r' && peek() != '\n')
+                advance();
+        }
+        else if(c == '/' && peek(1) == '*' && source.find("*/", position + 2) != std::string::npos)
+        {
+            advance(source.find("*/", position + 2) + 2 - position);
+        }
+        else if(c == '#')
+        {
+            while(position < source.size() && peek() != '\n')
+                advance();
+            advance();
+            tokens.push_back({CProgTokenKind::PREPROC_DIR, source.substr(start, position-start), start_line, start_column});
+        }
+        else if(isalpha(static_cast<unsigned char>(c)) || c == '_')
+        {
+            while(isalnum(static_cast<unsigned char>(peek())) || peek() == '_')
+                advance();
+            std::string text = source.substr(start, position-start);
+            auto keyword = keywords.find(text);
+            CProgTokenKind kind = keyword != keywords.end() ? keyword->second : CProgTokenKind::IDENTIFIER;
+            tokens.push_back({kind, std::move(text), start_line, start_column});
+        }
+        else if(isdigit(static_cast<unsigned char>(c)))
+        {
+            while(isdigit(static_cast<unsigned char>(peek())))
+                advance();
+            tokens.push_back({CProgTokenKind::INT_LITERAL, source.substr(start, position-start), start_line, start_column});
+        }
+        else if(c == '\'' && peek(1) == '\\' && peek(3) == '\'' && position + 3 < source.size())
+        {
+            advance(4);
+            tokens.push_back({CProgTokenKind::CHAR_LITERAL, source.substr(start, 4), start_line, start_column});
+        }
+        else if(c == '\'' && peek(2) == '\'' && position + 2 < source.size())
+        {
+            advance(3);
+            tokens.push_back({CProgTokenKind::CHAR_LITERAL, source.substr(start, 3), start_line, start_column});
+        }
+        else
+        {
+            size_t length;
+            CProgTokenKind kind = get_punctuator(length);
+            if(kind != CProgTokenKind::END_OF_FILE)
+            {
+                advance(length);
+                tokens.push_back({kind, source.substr(start, length), start_line, start_column});
+            }
+            else
+            {
+                ++nb_errors;
+                Writer::error() << "line " << start_line << ":" << start_column
+                                << " token recognition error at: '" << c << "'" << std::endl;
+                advance();
+            }
+        }
+    }
+    tokens.push_back({CProgTokenKind::END_OF_FILE, "<EOF>", line, column});
+    return tokens;
+}
+
+size_t CProgFastLexer::get_nb_errors() const
+{
+    return nb_errors;
+}
+
+// ---------------------------------------------------- Private Member Functions
+char CProgFastLexer::peek(size_t offset) const
+{
+    return position + offset < source.size() ? source[position + offset] : '\0';
+}
+
+void CProgFastLexer::advance(size_t count)
+{
+    for(size_t i=0; i<count && position < source.size(); ++i)
+    {
+        if(source[position] == '\n')
+        {
+            ++line;
+            column = 0;
+        }
+        else
+        {
+            ++column;
+        }
+        ++position;
+    }
+}
+
+CProgTokenKind CProgFastLexer::get_punctuator(size_t &length) const
+{
+    // the longest operator, "<=" is not "<" then "="
+    char next = peek(1);
+    length = 2;
+    switch(peek())
+    {
+        case '+': if(next == '+') return CProgTokenKind::OP_PP;  length = 1; return CProgTokenKind::OP_PLUS;
+        case '-': if(next == '-') return CProgTokenKind::OP_MM;  length = 1; return CProgTokenKind::OP_MINUS;
+        case '<': if(next == '=') return CProgTokenKind::OP_LTE; length = 1; return CProgTokenKind::OP_LT;
+        case '>': if(next == '=') return CProgTokenKind::OP_GTE; length = 1; return CProgTokenKind::OP_GT;
+        case '=': if(next == '=') return CProgTokenKind::OP_EQ;  length = 1; return CProgTokenKind::OP_ASGN;
+        case '!': if(next == '=') return CProgTokenKind::OP_NE;  length = 1; return CProgTokenKind::OP_NOT;
+        case '&': if(next == '&') return CProgTokenKind::OP_AND; length = 1; return CProgTokenKind::OP_BAND;
+        case '|': if(next == '|') return CProgTokenKind::OP_OR;  length = 1; return CProgTokenKind::OP_BOR;
+        default: break;
+    }
+    length = 1;
+    switch(peek())
+    {
+        case '(': return CProgTokenKind::LPAR;
+        case ')': return CProgTokenKind::RPAR;
+        case '{': return CProgTokenKind::LBRACE;
+        case '}': return CProgTokenKind::RBRACE;
+        case ';': return CProgTokenKind::SEMICOLON;
+        case ',': return CProgTokenKind::COMMA;
+        case '~': return CProgTokenKind::OP_BNOT;
+        case '*': return CProgTokenKind::OP_MUL;
+        case '/': return CProgTokenKind::OP_DIV;
+        case '%': return CProgTokenKind::OP_MOD;
+        case '^': return CProgTokenKind::OP_BXOR;
+        default:  return CProgTokenKind::END_OF_FILE;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class CProgFastParser                                                      //
+////////////////////////////////////////////////////////////////////////////////
+
+// ----------------------------------------------------------------- Constructor
+CProgFastParser::CProgFastParser(const std::vector<CProgToken> &tokens, const Options &options) :
+    tokens(tokens), position(0), closing_parentheses(tokens.size(), tokens.size()),
+    flat_parentheses(tokens.size(), -1), nesting_depth(0), builder(options.hash_consing)
+{
+    std::vector<size_t> opening;
+    for(size_t i=0; i<tokens.size(); ++i)
+    {
+        if(tokens[i].kind == CProgTokenKind::LPAR)
+            opening.push_back(i);
+        else if(tokens[i].kind == CProgTokenKind::RPAR && !opening.empty())
+        {
+            closing_parentheses[opening.back()] = i;
+            opening.pop_back();
+        }
+    }
+}
+
+// ----------------------------------------------------- Public Member Functions
+CProgASTProgram* CProgFastParser::parse_program()
+{
+    CProgASTProgram *program = builder.create_program();
+    // the calls may come before the definition of the function: the names
+    // followed by '(' outside of the bodies
+    size_t depth = 0;
+    for(size_t i=0; i+1<tokens.size(); ++i)
+    {
+        if(tokens[i].kind == CProgTokenKind::LBRACE)
+            ++depth;
+        else if(tokens[i].kind == CProgTokenKind::RBRACE && depth > 0)
+            --depth;
+        else if(depth == 0 && tokens[i].kind == CProgTokenKind::IDENTIFIER && tokens[i+1].kind == CProgTokenKind::LPAR)
+            builder.declare_function(tokens[i].text);
+    }
+    try
+    {
+        while(accept(CProgTokenKind::PREPROC_DIR))
+            ;
+        while(peek().kind != CProgTokenKind::END_OF_FILE)
+        {
+            program->add_funcdef(parse_funcdef());
+        }
+    }
+    catch(const SyntaxError&)
+    {
+        delete program;
+        return nullptr;
+    }
+    return program;
+}
+
+// ---------------------------------------------------- Private Member Functions
+CProgASTFuncdef* CProgFastParser::parse_funcdef()
+{
+    const CProgToken &type_name = advance();
+    if(!is_type_name(type_name.kind) && type_name.kind != CProgTokenKind::IDENTIFIER)
+        syntax_error(type_name, "mismatched input '" + type_name.text + "' expecting " + TYPE_NAMES);
+    const CProgToken &name = peek();
+    expect(CProgTokenKind::IDENTIFIER, "IDENTIFIER", [](CProgTokenKind kind) { return kind == CProgTokenKind::LPAR; });
+    CProgASTFuncdef *funcdef = builder.create<CProgASTFuncdef>(name.text, Type::INT_64);
+    funcdef->set_source_position(get_source_position(type_name));
+
+    expect(CProgTokenKind::LPAR, "'('", [](CProgTokenKind kind) { return is_type_name(kind) || kind == CProgTokenKind::IDENTIFIER || kind == CProgTokenKind::RPAR; });
+    if(peek().kind == CProgTokenKind::VOID_TYPE_NAME && peek(1).kind == CProgTokenKind::RPAR)
+    {
+        advance();
+    }
+    else if(peek().kind != CProgTokenKind::RPAR)
+    {
+        if(!is_type_name(peek().kind) && peek().kind != CProgTokenKind::IDENTIFIER)
+            unexpected_token([](CProgTokenKind kind) { return is_type_name(kind) || kind == CProgTokenKind::IDENTIFIER || kind == CProgTokenKind::RPAR; }, ARGUMENTS_START);
+        do
+        {
+            if(!is_type_name(peek().kind) && peek().kind != CProgTokenKind::IDENTIFIER)
+                unexpected_token([](CProgTokenKind kind) { return is_type_name(kind) || kind == CProgTokenKind::IDENTIFIER; }, TYPE_NAMES);
+            const CProgToken &arg_type_name = advance();
+            const CProgToken &arg_name = peek();
+            expect(CProgTokenKind::IDENTIFIER, "IDENTIFIER", [](CProgTokenKind kind) { return kind == CProgTokenKind::COMMA || kind == CProgTokenKind::RPAR; });
+            if(arg_type_name.kind == CProgTokenKind::VOID_TYPE_NAME || arg_type_name.kind == CProgTokenKind::IDENTIFIER)
+                Writer::error() << "missing argument or unexpected type" << std::endl;
+            else
+                funcdef->add_arg(arg_name.text, get_type(arg_type_name.kind));
+        } while(accept(CProgTokenKind::COMMA));
+    }
+    expect(CProgTokenKind::RPAR, "')'", [](CProgTokenKind kind) { return kind == CProgTokenKind::LBRACE; });
+
+    // the statements of the body belong to the function, not to a compound statement
+    expect(CProgTokenKind::LBRACE, "'{'", [](CProgTokenKind kind) { return can_start_statement(kind) || kind == CProgTokenKind::RBRACE; });
+    for(bool first = true; !accept_end_of_block(first); first = false)
+    {
+        CProgASTStatement *statement = parse_statement();
+        if(statement)
+            funcdef->add_statement(statement);
+    }
+    return funcdef;
+}
+
+CProgASTStatement* CProgFastParser::parse_statement()
+{
+    if(!can_start_statement(peek().kind))
+        unexpected_token(can_start_statement, STATEMENT_START);
+    NestingLevel level(*this);
+    SourcePosition position = get_source_position(peek());
+    CProgASTStatement *statement = parse_statement_unlocated();
+    if(statement)
+        statement->set_source_position(position);
+    return statement;
+}
+
+CProgASTStatement* CProgFastParser::parse_statement_unlocated()
+{
+    CProgASTStatement *statement;
+    switch(peek().kind)
+    {
+        case CProgTokenKind::LBRACE:
+            return parse_compound_statement();
+        case CProgTokenKind::IF:
+            return parse_if_condition();
+        case CProgTokenKind::WHILE:
+            return parse_while_statement();
+        case CProgTokenKind::FOR:
+            return parse_for_statement();
+        case CProgTokenKind::SEMICOLON:
+            advance();
+            Writer::error() << "empty statement currently not supported" << std::endl;
+            return nullptr;
+        case CProgTokenKind::RETURN:
+            advance();
+            statement = builder.create<CProgASTReturn>(parse_expr());
+            break;
+        default:
+            // a type name, even an unknown one followed by the declared name
+            if(is_type_name(peek().kind) || (peek().kind == CProgTokenKind::IDENTIFIER && peek(1).kind == CProgTokenKind::IDENTIFIER))
+                statement = parse_declaration();
+            else
+                statement = parse_expr();
+            break;
+    }
+    expect(CProgTokenKind::SEMICOLON, "';'", can_follow_statement);
+    return statement;
+}
+
+CProgASTCompoundStatement* CProgFastParser::parse_compound_statement()
+{
+    expect(CProgTokenKind::LBRACE, "'{'");
+    CProgASTCompoundStatement *compound_statement = builder.create<CProgASTCompoundStatement>();
+    for(bool first = true; !accept_end_of_block(first); first = false)
+    {
+        CProgASTStatement *statement = parse_statement();
+        if(statement)
+            compound_statement->add_statement(statement);
+    }
+    return compound_statement;
+}
+
+CProgASTDeclaration* CProgFastParser::parse_declaration()
+{
+    const CProgToken &type_name = advance();
+    bool valid_type = true;
+    if(type_name.kind == CProgTokenKind::VOID_TYPE_NAME)
+    {
+        Writer::error() << "can't declare a void variable" << std::endl;
+        valid_type = false;
+    }
+    else if(type_name.kind == CProgTokenKind::IDENTIFIER)
+    {
+        Writer::error() << "unknown type name '" << type_name.text << "'" << std::endl;
+        valid_type = false;
+    }
+
+    // the declarators of an invalid type are parsed, but not kept
+    CProgASTDeclaration *declaration = valid_type ? builder.create<CProgASTDeclaration>(get_type(type_name.kind)) : nullptr;
+    do
+    {
+        const CProgToken &name = peek();
+        expect(CProgTokenKind::IDENTIFIER, "IDENTIFIER");
+        CProgASTAssignment *initializer = nullptr;
+        if(accept(CProgTokenKind::OP_ASGN))
+        {
+            CProgASTIdentifier *identifier = builder.create<CProgASTIdentifier>(name.text);
+            initializer = builder.create<CProgASTAssignment>(identifier, parse_expr());
+        }
+        if(declaration)
+            declaration->add_declarator(builder.create<CProgASTDeclarator>(builder.create<CProgASTIdentifier>(name.text), initializer));
+    } while(accept(CProgTokenKind::COMMA));
+    return declaration;
+}
+
+CProgASTStatement* CProgFastParser::parse_if_condition()
+{
+    advance();
+    expect(CProgTokenKind::LPAR, "'('", can_start_expression);
+    CProgASTExpression *condition = parse_condition();
+    expect(CProgTokenKind::RPAR, "')'", can_start_statement);
+    CProgASTStatement *if_statement = parse_statement();
+    CProgASTStatement *else_statement = nullptr;
+    if(accept(CProgTokenKind::ELSE))
+    {
+        else_statement = parse_statement();
+    }
+    return builder.create<CProgASTIfStatement>(condition, if_statement, else_statement);
+}
+
+CProgASTStatement* CProgFastParser::parse_while_statement()
+{
+    advance();
+    expect(CProgTokenKind::LPAR, "'('", can_start_expression);
+    CProgASTExpression *condition = parse_condition();
+    expect(CProgTokenKind::RPAR, "')'", can_start_statement);
+    CProgASTStatement *body = parse_statement();
+    return builder.create<CProgASTWhileStatement>(condition, body);
+}
+
+CProgASTStatement* CProgFastParser::parse_for_statement()
+{
+    advance();
+    expect(CProgTokenKind::LPAR, "'('", [](CProgTokenKind kind) { return can_start_expression(kind) || kind == CProgTokenKind::SEMICOLON; });
+    CProgASTExpression *initialization = peek().kind != CProgTokenKind::SEMICOLON ? parse_condition() : nullptr;
+    expect(CProgTokenKind::SEMICOLON, "';'", [](CProgTokenKind kind) { return can_start_expression(kind) || kind == CProgTokenKind::SEMICOLON; });
+    CProgASTExpression *condition = peek().kind != CProgTokenKind::SEMICOLON ? parse_condition() : nullptr;
+    expect(CProgTokenKind::SEMICOLON, "';'", [](CProgTokenKind kind) { return can_start_expression(kind) || kind == CProgTokenKind::RPAR; });
+    CProgASTExpression *increment = peek().kind != CProgTokenKind::RPAR ? parse_condition() : nullptr;
+    expect(CProgTokenKind::RPAR, "')'", can_start_statement);
+    CProgASTStatement *body = parse_statement();
+    return builder.create<CProgASTForStatement>(initialization, condition, increment, body);
+}
+
+CProgASTExpression* CProgFastParser::parse_condition()
+{
+    SourcePosition position = get_source_position(peek());
+    CProgASTExpression *condition = parse_expr();
+    condition->set_source_position(position);
+    return condition;
+}
+
+CProgASTExpression* CProgFastParser::parse_expr(int min_precedence)
+{
+    NestingLevel level(*this);
+    CProgASTExpression *lhs;
+    if(is_parenthesized_flat(position))
+    {
+        CProgASTFlatBuilder flat(builder);
+        parse_flat(flat, parse_flat_operand(flat), min_precedence);
+        lhs = flat.get_expression();
+    }
+    else
+    {
+        lhs = parse_postfix();
+    }
+
+    while(true)
+    {
+        CProgTokenKind op = peek().kind;
+        int precedence = get_binary_precedence(op);
+        if(precedence < min_precedence)
+            return lhs;
+        if(op == CProgTokenKind::OP_AND || op == CProgTokenKind::OP_OR)
+        {
+            advance();
+            CProgASTExpression *rhs = parse_expr(precedence + 1);
+            if(op == CProgTokenKind::OP_AND)
+                lhs = builder.create<CProgASTAnd>(lhs, rhs);
+            else
+                lhs = builder.create<CProgASTOr>(lhs, rhs);
+            continue;
+        }
+        CProgASTFlatBuilder flat(builder);
+        parse_flat(flat, flat.add_leaf(lhs), min_precedence);
+        lhs = flat.get_expression();
+    }
+}
+
+uint32_t CProgFastParser::parse_flat(CProgASTFlatBuilder &flat, uint32_t lhs, int min_precedence)
+{
+    // && and || branch, their operands are separate expressions
+    while(true)
+    {
+        CProgTokenKind op = peek().kind;
+        int precedence = get_binary_precedence(op);
+        if(precedence < min_precedence || op == CProgTokenKind::OP_AND || op == CProgTokenKind::OP_OR)
+            return lhs;
+        advance();
+        uint32_t rhs = parse_flat(flat, parse_flat_operand(flat), precedence + 1);
+        lhs = flat.add_operation(get_flat_operation(op), lhs, rhs);
+    }
+}
+
+uint32_t CProgFastParser::parse_flat_operand(CProgASTFlatBuilder &flat)
+{
+    if(!is_parenthesized_flat(position))
+        return flat.add_leaf(parse_postfix());
+    NestingLevel level(*this);
+    advance();
+    uint32_t root = parse_flat(flat, parse_flat_operand(flat), 0);
+    expect(CProgTokenKind::RPAR, "')'", can_follow_expression);
+    return root;
+}
+
+CProgASTExpression* CProgFastParser::parse_postfix()
+{
+    CProgASTExpression *expr = parse_primary();
+    while(true)
+    {
+        if(accept(CProgTokenKind::OP_PP))
+            expr = builder.create<CProgASTPostPP>(expr);
+        else if(accept(CProgTokenKind::OP_MM))
+            expr = builder.create<CProgASTPostMM>(expr);
+        else
+            return expr;
+    }
+}
+
+CProgASTExpression* CProgFastParser::parse_primary()
+{
+    const CProgToken &token = advance();
+    CProgASTExpression *expr;
+    switch(token.kind)
+    {
+        case CProgTokenKind::LPAR:
+            expr = parse_expr();
+            expect(CProgTokenKind::RPAR, "')'", can_follow_expression);
+            return expr;
+        case CProgTokenKind::INT_LITERAL:
+        {
+            int64_t value = std::stoi(token.text);
+            return builder.create_shared<CProgASTIntLiteral>("i" + std::to_string(value), value);
+        }
+        case CProgTokenKind::CHAR_LITERAL:
+            return builder.create_shared<CProgASTCharLiteral>("c" + token.text, token.text.substr(1, token.text.size()-2));
+        case CProgTokenKind::BUILTIN_EXPECT:
+        {
+            expect(CProgTokenKind::LPAR, "'('", can_start_expression);
+            expr = parse_expr();
+            expect(CProgTokenKind::COMMA, "','", [](CProgTokenKind kind) { return kind == CProgTokenKind::INT_LITERAL; });
+            const CProgToken &value = peek();
+            expect(CProgTokenKind::INT_LITERAL, "INT_LITERAL", [](CProgTokenKind kind) { return kind == CProgTokenKind::RPAR; });
+            expect(CProgTokenKind::RPAR, "')'", can_follow_expression);
+            return builder.create<CProgASTExpect>(expr, std::stoll(value.text) != 0);
+        }
+        case CProgTokenKind::IDENTIFIER:
+            if(accept(CProgTokenKind::LPAR))
+            {
+                std::vector<CProgASTExpression*> args;
+                if(!accept(CProgTokenKind::RPAR))
+                {
+                    do
+                    {
+                        args.push_back(parse_expr());
+                    } while(accept(CProgTokenKind::COMMA));
+                    expect(CProgTokenKind::RPAR, "')'", can_follow_expression);
+                }
+                if(builder.is_expect_call(token.text, args.size()))
+                    return builder.create<CProgASTExpect>(args[0], token.text == "likely", true);
+                CProgASTFunccall *func_call = builder.create<CProgASTFunccall>(builder.create<CProgASTIdentifier>(token.text));
+                for(CProgASTExpression *arg : args)
+                    func_call->add_arg(arg);
+                return func_call;
+            }
+            if(accept(CProgTokenKind::OP_ASGN))
+            {
+                // right associative, below every binary operator
+                CProgASTIdentifier *identifier = builder.create<CProgASTIdentifier>(token.text);
+                return builder.create<CProgASTAssignment>(identifier, parse_expr());
+            }
+            return builder.create_shared<CProgASTIdentifier>("v" + token.text, token.text);
+        case CProgTokenKind::OP_PLUS:
+            return parse_expr(PREFIX_PRECEDENCE);
+        case CProgTokenKind::OP_MINUS:
+            expr = parse_expr(PREFIX_PRECEDENCE);
+            return builder.is_pure(expr) ? builder.create_shared<CProgASTUnaryMinus>("-" + CProgASTBuilder::get_node_key(expr), expr)
+                                         : builder.create<CProgASTUnaryMinus>(expr);
+        case CProgTokenKind::OP_PP:
+            return builder.create<CProgASTPrePP>(parse_expr(PREFIX_PRECEDENCE));
+        case CProgTokenKind::OP_MM:
+            return builder.create<CProgASTPreMM>(parse_expr(PREFIX_PRECEDENCE));
+        case CProgTokenKind::OP_NOT:
+            expr = parse_expr(PREFIX_PRECEDENCE);
+            return builder.is_pure(expr) ? builder.create_shared<CProgASTNot>("!" + CProgASTBuilder::get_node_key(expr), expr)
+                                         : builder.create<CProgASTNot>(expr);
+        case CProgTokenKind::OP_BNOT:
+            expr = parse_expr(PREFIX_PRECEDENCE);
+            return builder.is_pure(expr) ? builder.create_shared<CProgASTBNot>("~" + CProgASTBuilder::get_node_key(expr), expr)
+                                         : builder.create<CProgASTBNot>(expr);
+        default:
+            // ANTLR syncs before the alternatives of expr, the token is dropped
+            // when the next one starts an expression
+            syntax_error(token, (can_start_expression(peek().kind) ? "extraneous input '" : "mismatched input '") + token.text + "' expecting " + EXPRESSION_START);
+            return nullptr;
+    }
+}
+
+bool CProgFastParser::is_parenthesized_flat(size_t index)
+{
+    if(index >= tokens.size() || tokens[index].kind != CProgTokenKind::LPAR || closing_parentheses[index] == tokens.size())
+        return false;
+    // (a + b)++ is a postfix operation on the parentheses
+    size_t end = closing_parentheses[index];
+    CProgTokenKind next = tokens[end + 1 < tokens.size() ? end + 1 : end].kind;
+    if(next == CProgTokenKind::OP_PP || next == CProgTokenKind::OP_MM)
+        return false;
+    return is_flat_between(index, end);
+}
+
+bool CProgFastParser::is_flat_between(size_t begin, size_t end)
+{
+    if(flat_parentheses[begin] != -1)
+        return flat_parentheses[begin];
+    // ((a + b)) is looked through twice, the innermost parentheses decide
+    size_t outermost = begin;
+    while(flat_parentheses[begin] == -1 && tokens[begin + 1].kind == CProgTokenKind::LPAR && closing_parentheses[begin + 1] == end - 1)
+    {
+        ++begin;
+        --end;
+    }
+    bool flat = false;
+    if(flat_parentheses[begin] != -1)
+    {
+        flat = flat_parentheses[begin];
+    }
+    else
+    {
+        // a binary operator outside of nested parentheses, before the first
+        // assignment and && or ||, whose operands are separate expressions
+        bool operand = false; /**< the previous token ends an operand, + and - are binary after it */
+        for(size_t i=begin+1; i<end; ++i)
+        {
+            CProgTokenKind kind = tokens[i].kind;
+            if(kind == CProgTokenKind::OP_ASGN || kind == CProgTokenKind::OP_AND || kind == CProgTokenKind::OP_OR)
+            {
+                flat = flat && kind == CProgTokenKind::OP_ASGN;
+                break;
+            }
+            if(kind == CProgTokenKind::LPAR)
+            {
+                i = closing_parentheses[i];
+                operand = true;
+            }
+            else if(kind == CProgTokenKind::IDENTIFIER || kind == CProgTokenKind::INT_LITERAL || kind == CProgTokenKind::CHAR_LITERAL)
+            {
+                operand = true;
+            }
+            else if(kind != CProgTokenKind::OP_PP && kind != CProgTokenKind::OP_MM)
+            {
+                flat = flat || (operand && get_binary_precedence(kind) >= 0);
+                operand = false;
+            }
+        }
+    }
+    for(size_t i=outermost; i<=begin; ++i)
+        flat_parentheses[i] = flat;
+    return flat;
+}
+
+bool CProgFastParser::can_start_statement(CProgTokenKind kind)
+{
+    return can_start_expression(kind)
+        || is_type_name(kind)
+        || kind == CProgTokenKind::LBRACE
+        || kind == CProgTokenKind::SEMICOLON
+        || kind == CProgTokenKind::RETURN
+        || kind == CProgTokenKind::IF
+        || kind == CProgTokenKind::WHILE
+        || kind == CProgTokenKind::FOR;
+}
+
+bool CProgFastParser::can_start_expression(CProgTokenKind kind)
+{
+    switch(kind)
+    {
+        case CProgTokenKind::LPAR: case CProgTokenKind::BUILTIN_EXPECT:
+        case CProgTokenKind::OP_PP: case CProgTokenKind::OP_MM: case CProgTokenKind::OP_PLUS: case CProgTokenKind::OP_MINUS:
+        case CProgTokenKind::OP_NOT: case CProgTokenKind::OP_BNOT:
+        case CProgTokenKind::INT_LITERAL: case CProgTokenKind::CHAR_LITERAL: case CProgTokenKind::IDENTIFIER:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool CProgFastParser::can_follow_statement(CProgTokenKind kind)
+{
+    return can_start_statement(kind) || kind == CProgTokenKind::RBRACE || kind == CProgTokenKind::ELSE;
+}
+
+bool CProgFastParser::can_follow_expression(CProgTokenKind kind)
+{
+    return get_binary_precedence(kind) >= 0
+        || kind == CProgTokenKind::OP_PP
+        || kind == CProgTokenKind::OP_MM
+        || kind == CProgTokenKind::SEMICOLON
+        || kind == CProgTokenKind::RPAR
+        || kind == CProgTokenKind::COMMA;
+}
+
+bool CProgFastParser::is_type_name(CProgTokenKind kind)
+{
+    return kind == CProgTokenKind::VOID_TYPE_NAME
+        || kind == CProgTokenKind::CHAR_TYPE_NAME
+        || kind == CProgTokenKind::INT_TYPE_NAME
+        || kind == CProgTokenKind::INT_16_TYPE_NAME
+        || kind == CProgTokenKind::INT_32_TYPE_NAME
+        || kind == CProgTokenKind::INT_64_TYPE_NAME;
+}
+
+Type CProgFastParser::get_type(CProgTokenKind type_name)
+{
+    switch(type_name)
+    {
+        case CProgTokenKind::CHAR_TYPE_NAME:   return Type::CHAR;
+        case CProgTokenKind::INT_16_TYPE_NAME: return Type::INT_16;
+        case CProgTokenKind::INT_32_TYPE_NAME: return Type::INT_32;
+        case CProgTokenKind::VOID_TYPE_NAME:   return Type::VOID;
+        default:                               return Type::INT_64;
+    }
+}
+
+int CProgFastParser::get_binary_precedence(CProgTokenKind kind)
+{
+    // the order of the alternatives of expr in CProg.g4
+    switch(kind)
+    {
+        case CProgTokenKind::OP_MUL: case CProgTokenKind::OP_DIV: case CProgTokenKind::OP_MOD:
+            return 9;
+        case CProgTokenKind::OP_PLUS: case CProgTokenKind::OP_MINUS:
+            return 8;
+        case CProgTokenKind::OP_LT: case CProgTokenKind::OP_LTE: case CProgTokenKind::OP_GT: case CProgTokenKind::OP_GTE:
+            return 7;
+        case CProgTokenKind::OP_EQ: case CProgTokenKind::OP_NE:
+            return 6;
+        case CProgTokenKind::OP_BAND:
+            return 5;
+        case CProgTokenKind::OP_BXOR:
+            return 4;
+        case CProgTokenKind::OP_BOR:
+            return 3;
+        case CProgTokenKind::OP_AND:
+            return 2;
+        case CProgTokenKind::OP_OR:
+            return 1;
+        default:
+            return -1;
+    }
+}
+
+IRInstr::Operation CProgFastParser::get_flat_operation(CProgTokenKind kind)
+{
+    switch(kind)
+    {
+        case CProgTokenKind::OP_MUL:   return IRInstr::mul;
+        case CProgTokenKind::OP_DIV:   return IRInstr::div;
+        case CProgTokenKind::OP_MOD:   return IRInstr::mod;
+        case CProgTokenKind::OP_PLUS:  return IRInstr::add;
+        case CProgTokenKind::OP_MINUS: return IRInstr::sub;
+        case CProgTokenKind::OP_LT:    return IRInstr::cmp_lt;
+        case CProgTokenKind::OP_LTE:   return IRInstr::cmp_le;
+        case CProgTokenKind::OP_GT:    return IRInstr::cmp_gt;
+        case CProgTokenKind::OP_GTE:   return IRInstr::cmp_ge;
+        case CProgTokenKind::OP_EQ:    return IRInstr::cmp_eq;
+        case CProgTokenKind::OP_NE:    return IRInstr::cmp_ne;
+        case CProgTokenKind::OP_BAND:  return IRInstr::band;
+        case CProgTokenKind::OP_BXOR:  return IRInstr::bxor;
+        default:                       return IRInstr::bor;
+    }
+}
+
+SourcePosition CProgFastParser::get_source_position(const CProgToken &token)
+{
+    // the columns of SourcePosition start from 1
+    return SourcePosition(token.line, token.column + 1);
+}
+
+const CProgToken& CProgFastParser::peek(size_t offset) const
+{
+    return position + offset < tokens.size() ? tokens[position + offset] : tokens.back();
+}
+
+const CProgToken& CProgFastParser::advance()
+{
+    const CProgToken &token = peek();
+    if(position < tokens.size() - 1)
+        ++position;
+    return token;
+}
+
+bool CProgFastParser::accept(CProgTokenKind kind)
+{
+    if(peek().kind != kind)
+        return false;
+    advance();
+    return true;
+}
+
+void CProgFastParser::expect(CProgTokenKind kind, const std::string &text, bool (*can_follow)(CProgTokenKind))
+{
+    if(accept(kind))
+        return;
+    // the single token recovery of ANTLR: the token is extraneous when the next
+    // one is expected, the expected one is missing when the token can follow it
+    if(peek(1).kind == kind)
+        syntax_error(peek(), "extraneous input '" + peek().text + "' expecting " + text);
+    if(can_follow && can_follow(peek().kind))
+        syntax_error(peek(), "missing " + text + " at '" + peek().text + "'");
+    syntax_error(peek(), "mismatched input '" + peek().text + "' expecting " + text);
+}
+
+void CProgFastParser::unexpected_token(bool (*is_expected)(CProgTokenKind), const std::string &expected)
+{
+    const char *input = is_expected(peek(1).kind) ? "extraneous input '" : "mismatched input '";
+    syntax_error(peek(), input + peek().text + "' expecting " + expected);
+}
+
+bool CProgFastParser::accept_end_of_block(bool first_statement)
+{
+    if(accept(CProgTokenKind::RBRACE))
+        return true;
+    if(can_start_statement(peek().kind))
+        return false;
+    // after a statement, ANTLR reports the token which ends the loop of the
+    // statements as extraneous, whatever comes next
+    if(first_statement)
+        unexpected_token([](CProgTokenKind kind) { return can_start_statement(kind) || kind == CProgTokenKind::RBRACE; }, BLOCK_STATEMENT_START);
+    syntax_error(peek(), std::string("extraneous input '") + peek().text + "' expecting " + BLOCK_STATEMENT_START);
+    return false;
+}
+
+void CProgFastParser::syntax_error(const CProgToken &token, const std::string &message)
+{
+    Writer::error() << "line " << token.line << ":" << token.column << " " << message << std::endl;
+    throw SyntaxError();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class CProgFastParser::NestingLevel                                        //
+////////////////////////////////////////////////////////////////////////////////
+
+// ---------------------------------------------------- Constructor / Destructor
+CProgFastParser::NestingLevel::NestingLevel(CProgFastParser &parser) :
+    parser(parser)
+{
+    if(parser.nesting_depth == MAX_NESTING_DEPTH)
+        parser.syntax_error(parser.peek(), "nested more than " + std::to_string(MAX_NESTING_DEPTH) + " levels deep");
+    ++parser.nesting_depth;
+}
+
+CProgFastParser::NestingLevel::~NestingLevel()
+{
+    --parser.nesting_depth;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+// ---------------------------------------------------------- C++ System Headers
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------- Project Headers
+#include "CProgASTBuilder.h"
+#include "IR.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Forward Declarations                                                       //
+////////////////////////////////////////////////////////////////////////////////
+
+class CProgASTProgram;
+class CProgASTFuncdef;
+class CProgASTStatement;
+class CProgASTExpression;
+class CProgASTCompoundStatement;
+class CProgASTDeclaration;
+struct Options;
+
+////////////////////////////////////////////////////////////////////////////////
+// class CProgFastLexer                                                       //
+////////////////////////////////////////////////////////////////////////////////
+
+/** The tokens of CProg.g4, the skipped ones excepted */
+enum class CProgTokenKind {
+    END_OF_FILE, PREPROC_DIR, IDENTIFIER, INT_LITERAL, CHAR_LITERAL,
+    VOID_TYPE_NAME, CHAR_TYPE_NAME, INT_TYPE_NAME, INT_16_TYPE_NAME, INT_32_TYPE_NAME, INT_64_TYPE_NAME,
+    RETURN, IF, ELSE, WHILE, FOR, BUILTIN_EXPECT,
+    LPAR, RPAR, LBRACE, RBRACE, SEMICOLON, COMMA,
+    OP_PP, OP_MM, OP_PLUS, OP_MINUS, OP_NOT, OP_BNOT, OP_MUL, OP_DIV, OP_MOD,
+    OP_LT, OP_GT, OP_LTE, OP_GTE, OP_EQ, OP_NE, OP_ASGN,
+    OP_AND, OP_BAND, OP_OR, OP_BOR, OP_BXOR
+};
+
+struct CProgToken {
+    CProgTokenKind kind;
+    std::string text;
+    size_t line;
+    size_t column; /**< from 0, as ANTLR */
+};
+
+/* Hand-written lexer of the CProg.g4 tokens, for --frontend=fast. The
+     errors are reported as the ANTLR lexer reports them:
+         line 1:0 token recognition error at: '@'
+*/
+class CProgFastLexer {
+public:
+    // ------------------------------------------------------------- Constructor
+    CProgFastLexer(const std::string &source);
+
+    // ------------------------------------------------- Public Member Functions
+    std::vector<CProgToken> tokenize(); /**< ended by END_OF_FILE */
+    size_t get_nb_errors() const;
+private:
+    char peek(size_t offset = 0) const;
+    void advance(size_t count = 1);
+    CProgTokenKind get_punctuator(size_t &length) const; /**< at the position, END_OF_FILE if none */
+
+    const std::string &source;
+    size_t position;
+    size_t line;
+    size_t column;
+    size_t nb_errors;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// class CProgFastParser                                                      //
+////////////////////////////////////////////////////////////////////////////////
+
+/* Hand-written parser of the CProg.g4 language, for --frontend=fast: it builds
+     the CProgAST nodes straight from the tokens, without the ANTLR parse tree,
+     and the nodes are the ones CProgCSTVisitor builds from that tree.
+     Statements are parsed by recursive descent and expressions by precedence
+     climbing, with the precedence of the alternatives of `expr` in CProg.g4.
+     Like in CProgCSTVisitor, a chain of arithmetic, bitwise and comparison
+     operations is a single CProgASTFlatExpression, parentheses included:
+         a * (b + c) - d      one flat expression of 3 operations
+     The first syntax error is reported as ANTLR words it and stops the parse:
+     like its DefaultErrorStrategy, a token is extraneous when the next one is
+     the expected one, and the expected token is missing when the current one
+     can follow it, in some context rather than in the exact one.
+     The recursion is bounded: beyond MAX_NESTING_DEPTH nested statements,
+     parentheses or prefix operators, the parse stops with a syntax error
+     rather than overflowing the stack.
+*/
+class CProgFastParser {
+public:
+    // ------------------------------------------------------------- Constructor
+    CProgFastParser(const std::vector<CProgToken> &tokens, const Options &options);
+
+    // ------------------------------------------------- Public Member Functions
+    CProgASTProgram* parse_program(); /**< nullptr after a syntax error */
+private:
+    struct SyntaxError {}; /**< thrown by syntax_error(), caught by parse_program() */
+
+    /* One level of the recursive descent, for the lifetime of the object:
+         the syntax error is reported when the level would exceed the limit. */
+    class NestingLevel {
+    public:
+        NestingLevel(CProgFastParser &parser);
+        ~NestingLevel();
+    private:
+        CProgFastParser &parser;
+    };
+
+    static const size_t MAX_NESTING_DEPTH = 1000;
+
+    CProgASTFuncdef* parse_funcdef();
+    CProgASTStatement* parse_statement();
+    CProgASTStatement* parse_statement_unlocated();
+    CProgASTCompoundStatement* parse_compound_statement();
+    CProgASTDeclaration* parse_declaration();
+    CProgASTStatement* parse_if_condition();
+    CProgASTStatement* parse_while_statement();
+    CProgASTStatement* parse_for_statement();
+    CProgASTExpression* parse_condition(); /**< of a statement, located at its first token */
+    CProgASTExpression* parse_expr(int min_precedence = 0);
+    uint32_t parse_flat(CProgASTFlatBuilder &flat, uint32_t lhs, int min_precedence); /**< root of the operations of precedence >= min_precedence after lhs */
+    uint32_t parse_flat_operand(CProgASTFlatBuilder &flat);
+    CProgASTExpression* parse_postfix();
+    CProgASTExpression* parse_primary();
+    bool is_parenthesized_flat(size_t index); /**< parentheses at index around a flat expression, which CProgCSTVisitor looks through */
+    bool is_flat_between(size_t begin, size_t end); /**< the tokens between the parentheses at begin and end */
+
+    static bool can_start_statement(CProgTokenKind kind);
+    static bool can_start_expression(CProgTokenKind kind);
+    static bool can_follow_statement(CProgTokenKind kind); /**< in some context */
+    static bool can_follow_expression(CProgTokenKind kind); /**< in some context */
+    static bool is_type_name(CProgTokenKind kind);
+    static Type get_type(CProgTokenKind type_name);
+    static int get_binary_precedence(CProgTokenKind kind); /**< -1 if kind is not a binary operator */
+    static IRInstr::Operation get_flat_operation(CProgTokenKind kind);
+    static SourcePosition get_source_position(const CProgToken &token);
+
+    const CProgToken& peek(size_t offset = 0) const;
+    const CProgToken& advance();
+    bool accept(CProgTokenKind kind);
+    void expect(CProgTokenKind kind, const std::string &text, bool (*can_follow)(CProgTokenKind) = nullptr); /**< can_follow the expected token, if it may be missing */
+    void unexpected_token(bool (*is_expected)(CProgTokenKind), const std::string &expected); /**< the current one, before a choice between expected tokens */
+    bool accept_end_of_block(bool first_statement); /**< '}', or a syntax error if the token starts no statement */
+    void syntax_error(const CProgToken &token, const std::string &message);
+
+    const std::vector<CProgToken> &tokens;
+    size_t position;
+    std::vector<size_t> closing_parentheses; /**< index of the ')' of each '(', tokens.size() if none */
+    std::vector<int8_t> flat_parentheses; /**< memo of is_flat_between() by '(', -1 if unknown */
+    size_t nesting_depth; /**< levels of NestingLevel currently open */
+    CProgASTBuilder builder;
+};
@@ -1,15 +1,25 @@
 // ------------------------------------------------------------- Project Headers
 #include "IR.h"
+#include "Analysis.h"
+#include "Options.h"
+#include "Statistics.h"
+#include "TimeReport.h"
 #include "Writer.h"
 
 // ---------------------------------------------------------- C++ System Headers
 #include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
 #include <map>
+#include <set>
+#include <sstream>
 #include <string>
 #include <vector>
 
-static std::vector<std::string> param_registers_64 = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
+static const char* const param_registers_64[] = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
+static unsigned int local_label_count = 0;
 
 ////////////////////////////////////////////////////////////////////////////////
 // enum Type                                                                  //
@@ -33,6 +43,78 @@ std::map<Type, const TypeProperties> types =
     { Type::VOID,     TypeProperties(0, "void") }
 };
 
+////////////////////////////////////////////////////////////////////////////////
+// struct SourcePosition                                                      //
+////////////////////////////////////////////////////////////////////////////////
+
+SourcePosition::SourcePosition(size_t line, size_t column) :
+    line(line), column(column)
+{}
+
+////////////////////////////////////////////////////////////////////////////////
+// class StringPool                                                           //
+////////////////////////////////////////////////////////////////////////////////
+
+const uint32_t StringPool::NOT_FOUND;
+std::deque<std::string> StringPool::strings;
+std::vector<size_t> StringPool::hashes;
+std::vector<uint32_t> StringPool::slots;
+
+// ----------------------------------------------------- Public Member Functions
+uint32_t StringPool::intern(const std::string &str)
+{
+    if (2 * (strings.size() + 1) > slots.size())
+        grow();
+    const size_t hash = std::hash<std::string>()(str);
+    const size_t slot = find_slot(str, hash);
+    if (slots[slot] == NOT_FOUND)
+    {
+        slots[slot] = strings.size();
+        strings.push_back(str);
+        hashes.push_back(hash);
+    }
+    return slots[slot];
+}
+
+uint32_t StringPool::find(const std::string &str)
+{
+    if (slots.empty())
+        return NOT_FOUND;
+    return slots[find_slot(str, std::hash<std::string>()(str))];
+}
+
+const std::string& StringPool::get(uint32_t id)
+{
+    return strings[id];
+}
+
+size_t StringPool::size()
+{
+    return strings.size();
+}
+
+// ---------------------------------------------------- Private Member Functions
+size_t StringPool::find_slot(const std::string &str, size_t hash)
+{
+    const size_t mask = slots.size() - 1;
+    size_t slot = hash & mask;
+    while (slots[slot] != NOT_FOUND && (hashes[slots[slot]] != hash || strings[slots[slot]] != str))
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+void StringPool::grow()
+{
+    slots.assign(slots.empty() ? 64 : 2 * slots.size(), NOT_FOUND);
+    for (uint32_t id = 0; id < strings.size(); ++id)
+    {
+        size_t slot = hashes[id] & (slots.size() - 1);
+        while (slots[slot] != NOT_FOUND)
+            slot = (slot + 1) & (slots.size() - 1);
+        slots[slot] = id;
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class TableOfSymbols                                                       //
 ////////////////////////////////////////////////////////////////////////////////
@@ -53,59 +135,96 @@ std::string TableOfSymbols::add_tmp_var(Type type)
     std::string name = "!tmp" + std::to_string(next_tmp_var_id);
     next_tmp_var_id++;
     size += types.at(type).size;
-    symbols[name] = SymbolProperties(type, get_next_free_symbol_index());
+    add(name, SymbolProperties(type, get_next_free_symbol_index()), name);
     return name;
 }
 
-void TableOfSymbols::add_symbol(std::string identifier, Type type)
+std::string TableOfSymbols::add_symbol(const std::string &identifier, Type type)
 {
+    std::string name;
     size += types.at(type).size;
-    symbols[identifier] = SymbolProperties(type, get_next_free_symbol_index());
+    add(identifier, SymbolProperties(type, get_next_free_symbol_index()), name);
+    return name;
 }
 
-void TableOfSymbols::add_arg(std::string identifier, Type type)
+std::string TableOfSymbols::add_arg(const std::string &identifier, Type type)
 {
+    std::string name;
+    SymbolProperties properties;
     if(next_arg_index < 6)
     {
         size += types.at(type).size;
-        symbols[identifier] = SymbolProperties(type, get_next_free_symbol_index());
-        symbols[identifier].arg_index = next_arg_index++;
+        properties = SymbolProperties(type, get_next_free_symbol_index());
     }
     else
     {
-        symbols[identifier] = SymbolProperties(type, 16 + next_arg_offset);
-        symbols[identifier].arg_index = next_arg_index++;
+        properties = SymbolProperties(type, 16 + next_arg_offset);
         next_arg_offset += types.at(type).size;
     }
+    properties.arg_index = next_arg_index++;
+    properties.initialized = true;
 
-    symbols[identifier].initialized = true;
+    args.push_back(symbols.size());
+    add(identifier, properties, name);
+    return name;
 }
 
-bool TableOfSymbols::is_declared(std::string identifier) const
+void TableOfSymbols::enter_scope()
 {
-    if(parent && parent->symbols.find(identifier) != parent->symbols.end())
-    {
-        return true;
-    }
-    return symbols.find(identifier) != symbols.end();
+    scopes.emplace_back();
 }
 
-const SymbolProperties& TableOfSymbols::get_symbol(std::string identifier) const
+void TableOfSymbols::exit_scope()
 {
-    if(parent && parent->symbols.find(identifier) != parent->symbols.end())
-    {
-        return parent->symbols.at(identifier);
-    }
-    return symbols.at(identifier);
+    // the hidden declarations are visible again, in the reverse order they were hidden
+    for (auto it = scopes.back().rbegin(); it != scopes.back().rend(); ++it)
+        visible_ids[it->first] = it->second;
+    scopes.pop_back();
+}
+
+std::string TableOfSymbols::lookup(const std::string &identifier) const
+{
+    const uint32_t id = StringPool::find(identifier);
+    if (id < visible_ids.size() && visible_ids[id] != -1)
+        return names[visible_ids[id]];
+    if (parent)
+        return parent->lookup(identifier);
+    return "";
 }
 
-SymbolProperties& TableOfSymbols::get_symbol(std::string identifier)
+bool TableOfSymbols::is_declared_in_scope(const std::string &identifier) const
 {
-    if(parent && parent->symbols.find(identifier) != parent->symbols.end())
+    const uint32_t id = StringPool::find(identifier);
+    if (id >= visible_ids.size() || visible_ids[id] == -1)
+        return false;
+    if (scopes.empty())
+        return true;
+    for (const std::pair<uint32_t, int> &declaration : scopes.back())
     {
-        return parent->symbols.at(identifier);
+        if (declaration.first == id)
+            return true;
     }
-    return symbols.at(identifier);
+    return false;
+}
+
+bool TableOfSymbols::is_declared(const std::string &name) const
+{
+    return find(name) != -1 || (parent && parent->is_declared(name));
+}
+
+const SymbolProperties& TableOfSymbols::get_symbol(const std::string &name) const
+{
+    const int index = find(name);
+    if (index == -1 && parent)
+        return parent->get_symbol(name);
+    if (index == -1)
+        throw std::out_of_range("TableOfSymbols::get_symbol() : '" + name + "' is not declared");
+    return symbols[index];
+}
+
+SymbolProperties& TableOfSymbols::get_symbol(const std::string &name)
+{
+    return const_cast<SymbolProperties&>(static_cast<const TableOfSymbols*>(this)->get_symbol(name));
 }
 
 const SymbolProperties& TableOfSymbols::get_arg(int index) const
@@ -116,13 +235,7 @@ const SymbolProperties& TableOfSymbols::get_arg(int index) const
     }
     else if(index < next_arg_index)
     {
-        auto it = std::find_if(symbols.begin(), symbols.end(),
-            [index](const std::pair<std::string, SymbolProperties>& t) -> bool
-            {
-                return t.second.arg_index == index;
-            }
-        );
-        return it->second;
+        return symbols[args[index]];
     }
     throw std::out_of_range("TableOfSymbols::get_arg() : index is out of range");
 }
@@ -152,38 +265,82 @@ int TableOfSymbols::get_nb_parameters() const
     return next_arg_index;
 }
 
-void TableOfSymbols::initialize(const std::string &identifier)
+int TableOfSymbols::get_nb_tmp_vars() const
 {
-    symbols[identifier].initialized = true;
+    return next_tmp_var_id;
 }
 
-void TableOfSymbols::set_used(const std::string &identifier)
+void TableOfSymbols::initialize(const std::string &name)
 {
-    symbols[identifier].used = true;
+    const int index = find(name);
+    if (index != -1)
+        symbols[index].initialized = true;
+}
+
+void TableOfSymbols::set_used(const std::string &name)
+{
+    const int index = find(name);
+    if (index != -1)
+        symbols[index].used = true;
 }
 
 void TableOfSymbols::check_for_unused()
 {
-    for (auto &symbol : symbols)
+    for (const SymbolProperties &symbol : symbols)
     {
-        if (symbol.first.at(0) != '!' && !symbol.second.used)
+        if (symbol.identifier.at(0) != '!' && !symbol.used)
         {
-            if (symbol.second.arg_index == -1)
-                Writer::warning() << "unused variable '" << symbol.first << "'" << std::endl;
+            if (symbol.arg_index == -1)
+                Writer::warning() << "unused variable '" << symbol.identifier << "'" << std::endl;
             else
-                Writer::warning() << "unused parameter '" << symbol.first << "'" << std::endl;
+                Writer::warning() << "unused parameter '" << symbol.identifier << "'" << std::endl;
         }
     }
 }
 
 void TableOfSymbols::print_debug_infos() const
 {
-    for(auto p : symbols)
+    for(size_t i=0; i<symbols.size(); ++i)
     {
-        Writer::info() << "Nom variable : " << p.first << ", Type : " << types.at(p.second.type).name << ", Index : " << p.second.index << std::endl;
+        Writer::info() << "  Nom variable : " << names[i] << ", Type : " << types.at(symbols[i].type).name << ", Index : " << symbols[i].index << std::endl;
     }
 }
 
+// ---------------------------------------------------- Private Member Functions
+SymbolProperties& TableOfSymbols::add(const std::string &identifier, const SymbolProperties &properties, std::string &name)
+{
+    const uint32_t identifier_id = StringPool::intern(identifier);
+    if (identifier_id >= visible_ids.size())
+    {
+        visible_ids.resize(StringPool::size(), -1);
+        nb_declarations.resize(StringPool::size(), 0);
+    }
+
+    // the identifier declared again in the function gets a name of its own, that no identifier can take
+    name = identifier;
+    if (nb_declarations[identifier_id]++ > 0)
+        name += "." + std::to_string(nb_declarations[identifier_id] - 1);
+    const uint32_t name_id = StringPool::intern(name);
+    if (name_id >= symbol_ids.size())
+        symbol_ids.resize(StringPool::size(), -1);
+
+    const int index = symbols.size();
+    symbols.push_back(properties);
+    symbols.back().identifier = identifier;
+    names.push_back(name);
+    symbol_ids[name_id] = index;
+    if (!scopes.empty())
+        scopes.back().emplace_back(identifier_id, visible_ids[identifier_id]);
+    visible_ids[identifier_id] = index;
+    return symbols.back();
+}
+
+int TableOfSymbols::find(const std::string &name) const
+{
+    const uint32_t id = StringPool::find(name);
+    return id < symbol_ids.size() ? symbol_ids[id] : -1;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class IRInstr                                                              //
 ////////////////////////////////////////////////////////////////////////////////
@@ -268,6 +425,33 @@ std::ostream& operator<<(std::ostream& os, const IRInstr::Operation& op)
         case IRInstr::Operation::bnot:
             operation = "bnot";
         break;
+        case IRInstr::Operation::shl:
+            operation = "shl";
+        break;
+        case IRInstr::Operation::sar:
+            operation = "sar";
+        break;
+        case IRInstr::Operation::abs:
+            operation = "abs";
+        break;
+        case IRInstr::Operation::min:
+            operation = "min";
+        break;
+        case IRInstr::Operation::max:
+            operation = "max";
+        break;
+        case IRInstr::Operation::popcnt:
+            operation = "popcnt";
+        break;
+        case IRInstr::Operation::lzcnt:
+            operation = "lzcnt";
+        break;
+        case IRInstr::Operation::tzcnt:
+            operation = "tzcnt";
+        break;
+        case IRInstr::Operation::select:
+            operation = "select";
+        break;
         case IRInstr::Operation::land:
             operation = "and";
         break;
@@ -277,6 +461,9 @@ std::ostream& operator<<(std::ostream& os, const IRInstr::Operation& op)
         case IRInstr::Operation::lnot:
             operation = "not";
         break;
+        case IRInstr::Operation::counter_inc:
+            operation = "counter_inc";
+        break;
         case IRInstr::Operation::ret:
             operation = "ret";
         break;
@@ -285,7 +472,15 @@ std::ostream& operator<<(std::ostream& os, const IRInstr::Operation& op)
 }
 
 IRInstr::IRInstr(BasicBlock* bb, Operation op, Type t, const std::vector<std::string> &params) :
-    bb(bb), op(op), t(t), params(params)
+    bb(bb), op(op), t(t), position(bb->cfg->current_position)
+{
+    this->params.reserve(params.size());
+    for (const std::string &param : params)
+        this->params.push_back(bb->cfg->intern_operand(param));
+}
+
+IRInstr::IRInstr(BasicBlock* bb, const IRInstr& src) :
+    bb(bb), op(src.op), t(src.t), position(src.position), params(src.params)
 {}
 
 void IRInstr::gen_asm(Writer& w)
@@ -294,90 +489,90 @@ void IRInstr::gen_asm(Writer& w)
     switch(op)
     {
         case Operation::ldconst:
-            w.assembly(1) << x86_instr("mov", bb->cfg->get_var_type(params[0])) << " $" << params[1] << ", " << bb->cfg->IR_var_to_asm(params[0]) << std::endl;
+            w.assembly(1) << x86_instr("mov", get_operand(0).type) << " $" << get_operand(1).name << ", " << bb->cfg->IR_var_to_asm(get_operand(0)) << '\n';
         break;
         case Operation::add:
         {
-            Type type = bb->cfg->get_max_type(params[1], params[2]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            w.assembly(1) << x86_mov_var_reg(params[2], "b", type) << std::endl;
-            w.assembly(1) << x86_instr_reg_reg("add", type, "b", "a") << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = TypeProperties::max(get_operand(1).type, get_operand(2).type);
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_mov_var_reg(get_operand(2), Register::B, type) << '\n';
+            w.assembly(1) << x86_instr_reg_reg("add", type, Register::B, Register::A) << '\n';
+            Type output_type = get_operand(0).type;
             if (type < output_type)
-                w.assembly(1) << x86_convert_reg_a(type, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(type, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
         }
         break;
         case Operation::sub:
         {
-            Type type = bb->cfg->get_max_type(params[1], params[2]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            w.assembly(1) << x86_mov_var_reg(params[2], "b", type) << std::endl;
-            w.assembly(1) << x86_instr_reg_reg("sub", type, "b", "a") << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = TypeProperties::max(get_operand(1).type, get_operand(2).type);
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_mov_var_reg(get_operand(2), Register::B, type) << '\n';
+            w.assembly(1) << x86_instr_reg_reg("sub", type, Register::B, Register::A) << '\n';
+            Type output_type = get_operand(0).type;
             if (type < output_type)
-                w.assembly(1) << x86_convert_reg_a(type, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(type, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
         }
         break;
         case Operation::mul:
         {
-            Type type = bb->cfg->get_max_type(params[1], params[2]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            w.assembly(1) << x86_mov_var_reg(params[2], "b", type) << std::endl;
-            w.assembly(1) << x86_instr_reg_reg("imul", type, "b", "a") << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = TypeProperties::max(get_operand(1).type, get_operand(2).type);
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_mov_var_reg(get_operand(2), Register::B, type) << '\n';
+            w.assembly(1) << x86_instr_reg_reg("imul", type, Register::B, Register::A) << '\n';
+            Type output_type = get_operand(0).type;
             if (type < output_type)
-                w.assembly(1) << x86_convert_reg_a(type, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(type, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
         }
         break;
         case Operation::div:
         {
-            Type type = bb->cfg->get_max_type(params[1], params[2]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            w.assembly(1) << x86_mov_var_reg(params[2], "b", type) << std::endl;
-            w.assembly(1) << x86_extend_reg_a(type) << std::endl;
-            w.assembly(1) << x86_instr_reg("idiv", type, "b") << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = TypeProperties::max(get_operand(1).type, get_operand(2).type);
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_mov_var_reg(get_operand(2), Register::B, type) << '\n';
+            w.assembly(1) << x86_extend_reg_a(type) << '\n';
+            w.assembly(1) << x86_instr_reg("idiv", type, Register::B) << '\n';
+            Type output_type = get_operand(0).type;
             if (type < output_type)
-                w.assembly(1) << x86_convert_reg_a(type, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(type, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
         }
         break;
         case Operation::mod:
         {
-            Type type = bb->cfg->get_max_type(params[1], params[2]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            w.assembly(1) << x86_mov_var_reg(params[2], "b", type) << std::endl;
-            w.assembly(1) << x86_extend_reg_a(type) << std::endl;
-            w.assembly(1) << x86_instr_reg("idiv", type, "b") << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = TypeProperties::max(get_operand(1).type, get_operand(2).type);
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_mov_var_reg(get_operand(2), Register::B, type) << '\n';
+            w.assembly(1) << x86_extend_reg_a(type) << '\n';
+            w.assembly(1) << x86_instr_reg("idiv", type, Register::B) << '\n';
+            Type output_type = get_operand(0).type;
             if (type < output_type)
             {
-                w.assembly(1) << x86_instr(x86_instr("movs", type) + "t", output_type) << " "
-                              << IR_reg_to_asm("d", type) << ", " << IR_reg_to_asm("a", output_type) << std::endl;
+                w.assembly(1) << x86_instr("movs", type) << "t" << x86_instr("", output_type) << " "
+                              << IR_reg_to_asm(Register::D, type) << ", " << IR_reg_to_asm(Register::A, output_type) << '\n';
             }
             else
-                w.assembly(1) << x86_mov_reg_var("d", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_mov_reg_var(Register::D, output_type, get_operand(0)) << '\n';
         }
         break;
         case Operation::neg:
         {
-            Type type = bb->cfg->get_var_type(params[1]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            w.assembly(1) << x86_instr_reg("neg", type, "a") << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = get_operand(1).type;
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_instr_reg("neg", type, Register::A) << '\n';
+            Type output_type = get_operand(0).type;
             if (type < output_type)
-                w.assembly(1) << x86_convert_reg_a(type, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(type, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
         }
         break;
         case Operation::pre_pp:
-             w.assembly(1) << x86_instr("inc", bb->cfg->get_var_type(params[0])) << " " << bb->cfg->IR_var_to_asm(params[0]) << std::endl;
+             w.assembly(1) << x86_instr("inc", get_operand(0).type) << " " << bb->cfg->IR_var_to_asm(get_operand(0)) << '\n';
         break;
         case Operation::pre_mm:
-            w.assembly(1) << x86_instr("dec", bb->cfg->get_var_type(params[0])) << " " << bb->cfg->IR_var_to_asm(params[0]) << std::endl;
+            w.assembly(1) << x86_instr("dec", get_operand(0).type) << " " << bb->cfg->IR_var_to_asm(get_operand(0)) << '\n';
         break;
         case Operation::post_pp:
 
@@ -387,26 +582,26 @@ void IRInstr::gen_asm(Writer& w)
         break;
         case Operation::rmem:
         {
-            Type type = bb->cfg->get_var_type(params[1]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = get_operand(1).type;
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            Type output_type = get_operand(0).type;
             if (type < output_type)
-                w.assembly(1) << x86_convert_reg_a(type, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(type, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
         }
         break;
         case Operation::wmem:
         {
-            Type type = bb->cfg->get_var_type(params[1]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = get_operand(1).type;
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            Type output_type = get_operand(0).type;
             if (type < output_type)
-                w.assembly(1) << x86_convert_reg_a(type, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(type, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
         }
         break;
         case Operation::call:
-            w.assembly(1) << "movq $0, %rax" << std::endl;
+            w.assembly(1) << "movq $0, %rax" << '\n';
             count_register = 5;
             if (params.size() < 8)
             {
@@ -416,148 +611,281 @@ void IRInstr::gen_asm(Writer& w)
             {
                 if (count_params < 8)
                 {
-                    w.assembly(1) << x86_mov_var_reg(params[count_params], "a", Type::INT_64) << std::endl;
-                    w.assembly(1) << "movq %rax, " << param_registers_64[count_register] << std::endl;
+                    w.assembly(1) << x86_mov_var_reg(get_operand(count_params), Register::A, Type::INT_64) << '\n';
+                    w.assembly(1) << "movq %rax, " << param_registers_64[count_register] << '\n';
                 }
                 else
                 {
-                    w.assembly(1) << x86_mov_var_reg(params[count_params], "a", Type::INT_64) << std::endl;
-                    w.assembly(1) << "pushq %rax" << std::endl;
+                    w.assembly(1) << x86_mov_var_reg(get_operand(count_params), Register::A, Type::INT_64) << '\n';
+                    w.assembly(1) << "pushq %rax" << '\n';
                 }
                 --count_register;
             }
-            w.assembly(1) << "call " << params[1] << std::endl;
-            if (params[0] != "")
+            w.assembly(1) << "call " << get_operand(1).name << '\n';
+            if (!get_operand(0).name.empty())
             {
-                w.assembly(1) << x86_mov_reg_var("a", Type::INT_64, params[0]) << std::endl; // getting return value
+                w.assembly(1) << x86_mov_reg_var(Register::A, Type::INT_64, get_operand(0)) << '\n'; // getting return value
             }
         break;
         case Operation::cmp_null:
-            w.assembly(1) << x86_instr("cmp", bb->cfg->get_var_type(params[0])) << " $0, " << bb->cfg->IR_var_to_asm(params[0]) << std::endl;
+            w.assembly(1) << x86_instr("cmp", get_operand(0).type) << " $0, " << bb->cfg->IR_var_to_asm(get_operand(0)) << '\n';
         break;
         case Operation::cmp_eq:
         {
-            Type type = bb->cfg->get_max_type(params[1], params[2]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            w.assembly(1) << x86_mov_var_reg(params[2], "b", type) << std::endl;
-            w.assembly(1) << x86_instr_reg_reg("cmp", type, "b", "a") << std::endl;
-            w.assembly(1) << "sete %al" << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = TypeProperties::max(get_operand(1).type, get_operand(2).type);
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_mov_var_reg(get_operand(2), Register::B, type) << '\n';
+            w.assembly(1) << x86_instr_reg_reg("cmp", type, Register::B, Register::A) << '\n';
+            w.assembly(1) << "sete %al" << '\n';
+            Type output_type = get_operand(0).type;
             if (Type::CHAR < output_type)
-                w.assembly(1) << x86_convert_reg_a(Type::CHAR, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(Type::CHAR, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
         }
         break;
         case Operation::cmp_lt:
         {
-            Type type = bb->cfg->get_max_type(params[1], params[2]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            w.assembly(1) << x86_mov_var_reg(params[2], "b", type) << std::endl;
-            w.assembly(1) << x86_instr_reg_reg("cmp", type, "b", "a") << std::endl;
-            w.assembly(1) << "setl %al" << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = TypeProperties::max(get_operand(1).type, get_operand(2).type);
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_mov_var_reg(get_operand(2), Register::B, type) << '\n';
+            w.assembly(1) << x86_instr_reg_reg("cmp", type, Register::B, Register::A) << '\n';
+            w.assembly(1) << "setl %al" << '\n';
+            Type output_type = get_operand(0).type;
             if (Type::CHAR < output_type)
-                w.assembly(1) << x86_convert_reg_a(Type::CHAR, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(Type::CHAR, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
         }
         break;
         case Operation::cmp_le:
         {
-            Type type = bb->cfg->get_max_type(params[1], params[2]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            w.assembly(1) << x86_mov_var_reg(params[2], "b", type) << std::endl;
-            w.assembly(1) << x86_instr_reg_reg("cmp", type, "b", "a") << std::endl;
-            w.assembly(1) << "setle %al" << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = TypeProperties::max(get_operand(1).type, get_operand(2).type);
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_mov_var_reg(get_operand(2), Register::B, type) << '\n';
+            w.assembly(1) << x86_instr_reg_reg("cmp", type, Register::B, Register::A) << '\n';
+            w.assembly(1) << "setle %al" << '\n';
+            Type output_type = get_operand(0).type;
             if (Type::CHAR < output_type)
-                w.assembly(1) << x86_convert_reg_a(Type::CHAR, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(Type::CHAR, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
         }
         break;
         case Operation::cmp_gt:
         {
-            Type type = bb->cfg->get_max_type(params[1], params[2]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            w.assembly(1) << x86_mov_var_reg(params[2], "b", type) << std::endl;
-            w.assembly(1) << x86_instr_reg_reg("cmp", type, "b", "a") << std::endl;
-            w.assembly(1) << "setg %al" << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = TypeProperties::max(get_operand(1).type, get_operand(2).type);
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_mov_var_reg(get_operand(2), Register::B, type) << '\n';
+            w.assembly(1) << x86_instr_reg_reg("cmp", type, Register::B, Register::A) << '\n';
+            w.assembly(1) << "setg %al" << '\n';
+            Type output_type = get_operand(0).type;
             if (Type::CHAR < output_type)
-                w.assembly(1) << x86_convert_reg_a(Type::CHAR, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(Type::CHAR, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
         }
         break;
         case Operation::cmp_ge:
         {
-            Type type = bb->cfg->get_max_type(params[1], params[2]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            w.assembly(1) << x86_mov_var_reg(params[2], "b", type) << std::endl;
-            w.assembly(1) << x86_instr_reg_reg("cmp", type, "b", "a") << std::endl;
-            w.assembly(1) << "setge %al" << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = TypeProperties::max(get_operand(1).type, get_operand(2).type);
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_mov_var_reg(get_operand(2), Register::B, type) << '\n';
+            w.assembly(1) << x86_instr_reg_reg("cmp", type, Register::B, Register::A) << '\n';
+            w.assembly(1) << "setge %al" << '\n';
+            Type output_type = get_operand(0).type;
             if (Type::CHAR < output_type)
-                w.assembly(1) << x86_convert_reg_a(Type::CHAR, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(Type::CHAR, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
         }
         break;
         case Operation::cmp_ne:
         {
-            Type type = bb->cfg->get_max_type(params[1], params[2]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            w.assembly(1) << x86_mov_var_reg(params[2], "b", type) << std::endl;
-            w.assembly(1) << x86_instr_reg_reg("cmp", type, "b", "a") << std::endl;
-            w.assembly(1) << "setne %al" << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = TypeProperties::max(get_operand(1).type, get_operand(2).type);
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_mov_var_reg(get_operand(2), Register::B, type) << '\n';
+            w.assembly(1) << x86_instr_reg_reg("cmp", type, Register::B, Register::A) << '\n';
+            w.assembly(1) << "setne %al" << '\n';
+            Type output_type = get_operand(0).type;
             if (Type::CHAR < output_type)
-                w.assembly(1) << x86_convert_reg_a(Type::CHAR, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(Type::CHAR, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
         }
         break;
         case Operation::band:
         {
-            Type type = bb->cfg->get_max_type(params[1], params[2]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            w.assembly(1) << x86_mov_var_reg(params[2], "b", type) << std::endl;
-            w.assembly(1) << x86_instr_reg_reg("and", type, "b", "a") << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = TypeProperties::max(get_operand(1).type, get_operand(2).type);
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_mov_var_reg(get_operand(2), Register::B, type) << '\n';
+            w.assembly(1) << x86_instr_reg_reg("and", type, Register::B, Register::A) << '\n';
+            Type output_type = get_operand(0).type;
             if (type < output_type)
-                w.assembly(1) << x86_convert_reg_a(type, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(type, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
         }
         break;
         case Operation::bor:
         {
-            Type type = bb->cfg->get_max_type(params[1], params[2]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            w.assembly(1) << x86_mov_var_reg(params[2], "b", type) << std::endl;
-            w.assembly(1) << x86_instr_reg_reg("or", type, "b", "a") << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = TypeProperties::max(get_operand(1).type, get_operand(2).type);
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_mov_var_reg(get_operand(2), Register::B, type) << '\n';
+            w.assembly(1) << x86_instr_reg_reg("or", type, Register::B, Register::A) << '\n';
+            Type output_type = get_operand(0).type;
             if (type < output_type)
-                w.assembly(1) << x86_convert_reg_a(type, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(type, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
         }
         break;
         case Operation::bxor:
         {
-            Type type = bb->cfg->get_max_type(params[1], params[2]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            w.assembly(1) << x86_mov_var_reg(params[2], "b", type) << std::endl;
-            w.assembly(1) << x86_instr_reg_reg("xor", type, "b", "a") << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = TypeProperties::max(get_operand(1).type, get_operand(2).type);
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_mov_var_reg(get_operand(2), Register::B, type) << '\n';
+            w.assembly(1) << x86_instr_reg_reg("xor", type, Register::B, Register::A) << '\n';
+            Type output_type = get_operand(0).type;
             if (type < output_type)
-                w.assembly(1) << x86_convert_reg_a(type, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(type, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
         }
         break;
         case Operation::bnot:
         {
-            Type type = bb->cfg->get_var_type(params[1]);
-            w.assembly(1) << x86_mov_var_reg(params[1], "a", type) << std::endl;
-            w.assembly(1) << x86_instr_reg("not", type, "a") << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            Type type = get_operand(1).type;
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_instr_reg("not", type, Register::A) << '\n';
+            Type output_type = get_operand(0).type;
+            if (type < output_type)
+                w.assembly(1) << x86_convert_reg_a(type, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
+        }
+        break;
+        case Operation::shl:
+        case Operation::sar:
+        {
+            // x86 only shifts by %cl
+            Type type = get_operand(1).type;
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_mov_var_reg(get_operand(2), Register::C, Type::INT_64) << '\n';
+            w.assembly(1) << x86_instr(op == Operation::shl ? "sal" : "sar", type) << " %cl, " << IR_reg_to_asm(Register::A, type) << '\n';
+            Type output_type = get_operand(0).type;
+            if (type < output_type)
+                w.assembly(1) << x86_convert_reg_a(type, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
+        }
+        break;
+        case Operation::abs:
+        {
+            // the sign mask m = x >> (bits-1) gives |x| = (x ^ m) - m
+            Type type = get_operand(1).type;
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_instr_reg_reg("mov", type, Register::A, Register::D) << '\n';
+            w.assembly(1) << x86_instr("sar", type) << " $" << types.at(type).size*8 - 1 << ", " << IR_reg_to_asm(Register::D, type) << '\n';
+            w.assembly(1) << x86_instr_reg_reg("xor", type, Register::D, Register::A) << '\n';
+            w.assembly(1) << x86_instr_reg_reg("sub", type, Register::D, Register::A) << '\n';
+            Type output_type = get_operand(0).type;
+            if (type < output_type)
+                w.assembly(1) << x86_convert_reg_a(type, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
+        }
+        break;
+        case Operation::min:
+        case Operation::max:
+        {
+            // cmov has no 8 bit form
+            Type type = TypeProperties::max(get_operand(1).type, get_operand(2).type);
+            if (type < Type::INT_16)
+                type = Type::INT_32;
+            w.assembly(1) << x86_mov_var_reg(get_operand(1), Register::A, type) << '\n';
+            w.assembly(1) << x86_mov_var_reg(get_operand(2), Register::B, type) << '\n';
+            w.assembly(1) << x86_instr_reg_reg("cmp", type, Register::B, Register::A) << '\n';
+            w.assembly(1) << x86_instr_reg_reg(op == Operation::min ? "cmovg" : "cmovl", type, Register::B, Register::A) << '\n';
+            Type output_type = get_operand(0).type;
             if (type < output_type)
-                w.assembly(1) << x86_convert_reg_a(type, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(type, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, TypeProperties::max(type, output_type), get_operand(0)) << '\n';
+        }
+        break;
+        case Operation::popcnt:
+        {
+            w.assembly(1) << x86_mov_var_reg_zero_extended(get_operand(1)) << '\n';
+            if (w.get_options().popcnt)
+                w.assembly(1) << "popcntq %rax, %rax" << '\n';
+            else
+            {
+                // clears the lowest set bit until none is left
+                X86LocalLabel loop_label = new_local_label();
+                X86LocalLabel end_label = new_local_label();
+                w.assembly(1) << "xorl %ebx, %ebx" << '\n';
+                w.assembly(1) << "testq %rax, %rax" << '\n';
+                w.assembly(1) << "jz " << end_label << '\n';
+                w.assembly(0) << loop_label << ":" << '\n';
+                w.assembly(1) << "incl %ebx" << '\n';
+                w.assembly(1) << "leaq -1(%rax), %rcx" << '\n';
+                w.assembly(1) << "andq %rcx, %rax" << '\n';
+                w.assembly(1) << "jnz " << loop_label << '\n';
+                w.assembly(0) << end_label << ":" << '\n';
+                w.assembly(1) << "movq %rbx, %rax" << '\n';
+            }
+            w.assembly(1) << x86_mov_reg_var(Register::A, Type::INT_64, get_operand(0)) << '\n';
+        }
+        break;
+        case Operation::lzcnt:
+        {
+            // counted on 64 bits, the upper bits are zeros
+            size_t bits = types.at(get_operand(1).type).size*8;
+            w.assembly(1) << x86_mov_var_reg_zero_extended(get_operand(1)) << '\n';
+            if (w.get_options().lzcnt)
+                w.assembly(1) << "lzcntq %rax, %rax" << '\n';
+            else
+            {
+                // bsr gives the index of the highest set bit, and nothing for 0
+                X86LocalLabel zero_label = new_local_label();
+                X86LocalLabel end_label = new_local_label();
+                w.assembly(1) << "bsrq %rax, %rax" << '\n';
+                w.assembly(1) << "jz " << zero_label << '\n';
+                w.assembly(1) << "xorq $63, %rax" << '\n';
+                w.assembly(1) << "jmp " << end_label << '\n';
+                w.assembly(0) << zero_label << ":" << '\n';
+                w.assembly(1) << "movq $64, %rax" << '\n';
+                w.assembly(0) << end_label << ":" << '\n';
+            }
+            if (bits < 64)
+                w.assembly(1) << "subq $" << 64 - bits << ", %rax" << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, Type::INT_64, get_operand(0)) << '\n';
+        }
+        break;
+        case Operation::tzcnt:
+        {
+            // a bit set just above the value stops the count at its size
+            size_t bits = types.at(get_operand(1).type).size*8;
+            w.assembly(1) << x86_mov_var_reg_zero_extended(get_operand(1)) << '\n';
+            if (bits < 64)
+                w.assembly(1) << "btsq $" << bits << ", %rax" << '\n';
+            if (w.get_options().bmi)
+                w.assembly(1) << "tzcntq %rax, %rax" << '\n';
+            else if (bits < 64)
+                w.assembly(1) << "bsfq %rax, %rax" << '\n';
+            else
+            {
+                X86LocalLabel end_label = new_local_label();
+                w.assembly(1) << "bsfq %rax, %rax" << '\n';
+                w.assembly(1) << "jnz " << end_label << '\n';
+                w.assembly(1) << "movq $64, %rax" << '\n';
+                w.assembly(0) << end_label << ":" << '\n';
+            }
+            w.assembly(1) << x86_mov_reg_var(Register::A, Type::INT_64, get_operand(0)) << '\n';
+        }
+        break;
+        case Operation::select:
+        {
+            // d = c ? x : y, cmov has no 8 bit form
+            Type type = TypeProperties::max(get_operand(2).type, get_operand(3).type);
+            if (type < Type::INT_16)
+                type = Type::INT_32;
+            w.assembly(1) << x86_mov_var_reg(get_operand(3), Register::A, type) << '\n';
+            w.assembly(1) << x86_mov_var_reg(get_operand(2), Register::B, type) << '\n';
+            w.assembly(1) << x86_instr("cmp", get_operand(1).type) << " $0, " << bb->cfg->IR_var_to_asm(get_operand(1)) << '\n';
+            w.assembly(1) << x86_instr_reg_reg("cmovne", type, Register::B, Register::A) << '\n';
+            Type output_type = get_operand(0).type;
+            if (type < output_type)
+                w.assembly(1) << x86_convert_reg_a(type, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, TypeProperties::max(type, output_type), get_operand(0)) << '\n';
         }
         break;
         case Operation::land:
@@ -568,84 +896,146 @@ void IRInstr::gen_asm(Writer& w)
         break;
         case Operation::lnot:
         {
-            w.assembly(1) << x86_instr("cmp", bb->cfg->get_var_type(params[1])) << " $0, " << bb->cfg->IR_var_to_asm(params[1]) << std::endl;
-            w.assembly(1) << "sete %al" << std::endl;
-            Type output_type = bb->cfg->get_var_type(params[0]);
+            w.assembly(1) << x86_instr("cmp", get_operand(1).type) << " $0, " << bb->cfg->IR_var_to_asm(get_operand(1)) << '\n';
+            w.assembly(1) << "sete %al" << '\n';
+            Type output_type = get_operand(0).type;
             if (Type::CHAR < output_type)
-                w.assembly(1) << x86_convert_reg_a(Type::CHAR, output_type) << std::endl;
-            w.assembly(1) << x86_mov_reg_var("a", output_type, params[0]) << std::endl;
+                w.assembly(1) << x86_convert_reg_a(Type::CHAR, output_type) << '\n';
+            w.assembly(1) << x86_mov_reg_var(Register::A, output_type, get_operand(0)) << '\n';
         }
         break;
+        case Operation::counter_inc:
+            w.assembly(1) << "incq " << get_operand(0).name << "+" << 8 * get_operand(1).value << "(%rip)" << '\n';
+        break;
         case Operation::ret:
-            w.assembly(1) << x86_mov_var_reg(params[0], "a", Type::INT_64) << std::endl;
-            w.assembly(1) << "jmp " << bb->cfg->get_last_bb()->label << std::endl;
+        {
+            // the return value is loaded only if it is not already in %rax
+            const IRInstr* previous = bb->get_previous_IRInstr(this);
+            Type type = get_operand(0).type;
+            if (previous && previous->leaves_result_in_reg_a(get_operand(0).name))
+            {
+                if (type < Type::INT_64)
+                    w.assembly(1) << x86_convert_reg_a(type, Type::INT_64) << '\n';
+                if (Statistics::is_enabled())
+                    Statistics::add(bb->cfg->get_name(), "codegen.eliminated-loads");
+            }
+            else if (previous && previous->op == Operation::ldconst && previous->params[0] == params[0] && type == Type::INT_64)
+            {
+                w.assembly(1) << "movq $" << previous->get_operand(1).name << ", %rax" << '\n';
+                if (Statistics::is_enabled())
+                    Statistics::add(bb->cfg->get_name(), "codegen.ret-immediate");
+            }
+            else
+                w.assembly(1) << x86_mov_var_reg(get_operand(0), Register::A, Type::INT_64) << '\n';
+
+            // tail duplication : a small epilogue costs less than a jump to the exit block
+            if (bb->cfg->get_epilogue_size(w.get_options()) <= CFG::MAX_DUPLICATED_EPILOGUE_SIZE)
+                bb->cfg->gen_asm_epilogue(w);
+            else
+                w.assembly(1) << "jmp " << bb->cfg->get_last_bb()->label << '\n';
+        }
         break;
     }
 }
 
-std::string IRInstr::IR_reg_to_asm(const std::string &reg, Type type)
+// the tables of the code generation, indexed by Type and Register
+static const char* const type_suffixes[] = { "", "b", "w", "l", "q" };
+static const size_t type_sizes[] = { 0, 1, 2, 4, 8 };
+static const char* const register_names[][4] =
+{
+    { "%al", "%bl", "%cl", "%dl" },
+    { "%ax", "%bx", "%cx", "%dx" },
+    { "%eax", "%ebx", "%ecx", "%edx" },
+    { "%rax", "%rbx", "%rcx", "%rdx" }
+};
+static const char* const extend_reg_a_instructions[] = { "error", "cbtw", "cwtd", "cltd", "cqto" };
+
+std::ostream& operator<<(std::ostream& os, const X86Mnemonic& mnemonic)
+{
+    return os << mnemonic.name << type_suffixes[static_cast<int>(mnemonic.type)]
+              << type_suffixes[static_cast<int>(mnemonic.extended_type)];
+}
+
+std::ostream& operator<<(std::ostream& os, const X86Operand& operand)
+{
+    if (operand.reg)
+        return os << operand.reg;
+    return os << operand.index << "(%rbp)";
+}
+
+std::ostream& operator<<(std::ostream& os, const X86Instruction& instruction)
+{
+    os << instruction.mnemonic;
+    if (instruction.nb_operands >= 1)
+        os << " " << instruction.source;
+    if (instruction.nb_operands >= 2)
+        os << ", " << instruction.destination;
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, const X86LocalLabel& label)
+{
+    return os << ".Lbrutus" << label.number;
+}
+
+const char* IRInstr::IR_reg_to_asm(Register reg, Type type)
+{
+    if (type == Type::VOID)
+    {
+        Writer::error() << "unexpected type " << types.at(type).name << " in IR_reg_to_asm" << std::endl;
+        return "error";
+    }
+    return register_names[static_cast<int>(type) - 1][static_cast<int>(reg)];
+}
+
+X86Mnemonic IRInstr::x86_instr(const char* instr, Type type)
 {
-    switch (type)
+    if (type == Type::VOID)
     {
-        case Type::CHAR:
-            return "%" + reg + "l";
-        case Type::INT_16:
-            return "%" + reg + "x";
-        case Type::INT_32:
-            return "%e" + reg + "x";
-        case Type::INT_64:
-            return "%r" + reg + "x";
-        default:
-            Writer::error() << "unexpected type " << types.at(type).name << " in IR_reg_to_asm" << std::endl;
-            return "error";
+        Writer::error() << "unexpected type " << types.at(type).name << " in x86_instr" << std::endl;
+        return { "error", Type::VOID, Type::VOID };
     }
+    return { instr, type, Type::VOID };
 }
 
-std::string IRInstr::x86_instr(const std::string &instr, Type type)
+X86Mnemonic IRInstr::x86_instr(X86Mnemonic instr, Type type)
 {
-    switch (type)
+    if (type == Type::VOID)
     {
-        case Type::CHAR:
-            return instr + "b";
-        case Type::INT_16:
-            return instr + "w";
-        case Type::INT_32:
-            return instr + "l";
-        case Type::INT_64:
-            return instr + "q";
-        default:
-            Writer::error() << "unexpected type " << types.at(type).name << " in x86_instr" << std::endl;
-            return "error";
+        Writer::error() << "unexpected type " << types.at(type).name << " in x86_instr" << std::endl;
+        return { "error", Type::VOID, Type::VOID };
     }
+    instr.extended_type = type;
+    return instr;
 }
 
-std::string IRInstr::x86_instr_reg(const std::string &instr, Type type, const std::string &reg) const
+X86Instruction IRInstr::x86_instr_reg(const char* instr, Type type, Register reg)
 {
-    return x86_instr(instr, type) + " " + IR_reg_to_asm(reg, type);
+    return { x86_instr(instr, type), 1, { IR_reg_to_asm(reg, type), 0 }, { nullptr, 0 } };
 }
 
-std::string IRInstr::x86_instr_reg_reg(const std::string &instr, Type type, const std::string &reg1, const std::string &reg2) const
+X86Instruction IRInstr::x86_instr_reg_reg(const char* instr, Type type, Register reg1, Register reg2)
 {
-    return x86_instr(instr, type) + " " + IR_reg_to_asm(reg1, type) + ", " + IR_reg_to_asm(reg2, type);
+    return { x86_instr(instr, type), 2, { IR_reg_to_asm(reg1, type), 0 }, { IR_reg_to_asm(reg2, type), 0 } };
 }
 
-std::string IRInstr::x86_mov_var_reg(const std::string &var, const std::string &reg, Type reg_type, bool signed_fill) const
+X86Instruction IRInstr::x86_mov_var_reg(const IROperand &var, Register reg, Type reg_type, bool signed_fill) const
 {
-    Type var_type = bb->cfg->get_var_type(var);
-    std::string instr;
-    if (types.at(var_type).size >= types.at(reg_type).size)
+    Type var_type = var.type;
+    X86Mnemonic instr;
+    if (type_sizes[static_cast<int>(var_type)] >= type_sizes[static_cast<int>(reg_type)])
         instr = x86_instr("mov", reg_type);
     else
         instr = x86_instr(x86_instr(signed_fill ? "movs" : "movz", var_type), reg_type);
 
-    return instr + " " + bb->cfg->IR_var_to_asm(var) + ", " + IR_reg_to_asm(reg, reg_type);
+    return { instr, 2, bb->cfg->IR_var_to_asm(var), { IR_reg_to_asm(reg, reg_type), 0 } };
 }
 
-std::string IRInstr::x86_mov_reg_var(const std::string &reg, Type reg_type, const std::string &var) const
+X86Instruction IRInstr::x86_mov_reg_var(Register reg, Type reg_type, const IROperand &var) const
 {
-    Type var_type = bb->cfg->get_var_type(var);
-    std::string instr;
-    if (types.at(reg_type).size >= types.at(var_type).size)
+    Type var_type = var.type;
+    X86Mnemonic instr = { "", Type::VOID, Type::VOID };
+    if (type_sizes[static_cast<int>(reg_type)] >= type_sizes[static_cast<int>(var_type)])
     {
         instr = x86_instr("mov", var_type);
         reg_type = var_type;
@@ -653,49 +1043,41 @@ std::string IRInstr::x86_mov_reg_var(const std::string &reg, Type reg_type, cons
     else
         Writer::error() << "reg_type < var_type in x86_mov_reg_var" << std::endl;
 
-    return instr + " " + IR_reg_to_asm(reg, reg_type) + ", " + bb->cfg->IR_var_to_asm(var);
+    return { instr, 2, { IR_reg_to_asm(reg, reg_type), 0 }, bb->cfg->IR_var_to_asm(var) };
 }
 
-std::string IRInstr::x86_extend_reg_a(Type from)
+X86Instruction IRInstr::x86_mov_var_reg_zero_extended(const IROperand &var) const
 {
-    std::string to;
-    switch (from)
-    {
-        case Type::CHAR:
-            to = "w";
-        break;
-        case Type::INT_16:
-            to = "d";
-        break;
-        case Type::INT_32:
-            to = "d";
-        break;
-        case Type::INT_64:
-            to = "o";
-        break;
-        default:
-            to = "error";
-            Writer::error() << "type error in x86_extend_reg_a" << std::endl;
-        break;
-    }
-    return x86_instr("c", from) + "t" + to;
+    // writing a 32 bit register clears the upper half of the 64 bit one
+    return x86_mov_var_reg(var, Register::A, var.type == Type::INT_64 ? Type::INT_64 : Type::INT_32, false);
 }
 
-std::string IRInstr::x86_convert_reg_a(Type from, Type to)
+X86LocalLabel IRInstr::new_local_label()
 {
-    //return x86_instr(x86_instr("c", from) + "t", to);
-    return x86_instr(x86_instr("movs", from), to) + " " + IR_reg_to_asm("a", from) + ", " + IR_reg_to_asm("a", to);
+    return { local_label_count++ };
+}
+
+const char* IRInstr::x86_extend_reg_a(Type from)
+{
+    if (from == Type::VOID)
+        Writer::error() << "type error in x86_extend_reg_a" << std::endl;
+    return extend_reg_a_instructions[static_cast<int>(from)];
+}
+
+X86Instruction IRInstr::x86_convert_reg_a(Type from, Type to)
+{
+    //return x86_instr(x86_instr(Register::C, from) + "t", to);
+    return { x86_instr(x86_instr("movs", from), to), 2, { IR_reg_to_asm(Register::A, from), 0 }, { IR_reg_to_asm(Register::A, to), 0 } };
 }
 
 void IRInstr::print_debug_infos() const
 {
-    Writer::info() << "Type de retour : " << types.at(t).name << ", Operation : " << op << std::endl;
-    Writer::info() << "Parametres : ";
-    for (std::string param : params)
+    std::ostream& os = Writer::info() << "    " << op << " " << types.at(t).name << " :";
+    for (size_t i=0; i<params.size(); ++i)
     {
-        Writer::info() << param << ", ";
+        os << (i == 0 ? " " : ", ") << bb->cfg->get_operand(params[i]).name;
     }
-    Writer::info() << std::endl;
+    os << " (ligne " << position.line << ":" << position.column << ")" << std::endl;
 }
 
 IRInstr::Operation IRInstr::get_operation() const
@@ -703,6 +1085,132 @@ IRInstr::Operation IRInstr::get_operation() const
     return op;
 }
 
+Type IRInstr::get_type() const
+{
+    return t;
+}
+
+size_t IRInstr::get_nb_params() const
+{
+    return params.size();
+}
+
+const std::string& IRInstr::get_param(size_t index) const
+{
+    return bb->cfg->get_operand(params[index]).name;
+}
+
+const IROperand& IRInstr::get_operand(size_t index) const
+{
+    return bb->cfg->get_operand(params[index]);
+}
+
+const SourcePosition& IRInstr::get_position() const
+{
+    return position;
+}
+
+std::vector<std::string> IRInstr::get_written_vars() const
+{
+    switch(op)
+    {
+        case Operation::ret:
+        case Operation::cmp_null:
+        case Operation::counter_inc:
+            return {};
+        case Operation::call:
+            if (get_param(0).empty())
+                return {};
+            return {get_param(0)};
+        case Operation::post_pp:
+        case Operation::post_mm:
+            return {get_param(0), get_param(1)};
+        default:
+            return {get_param(0)};
+    }
+}
+
+std::vector<std::string> IRInstr::get_read_vars() const
+{
+    switch(op)
+    {
+        case Operation::ldconst:
+        case Operation::counter_inc:
+            return {};
+        case Operation::pre_pp:
+        case Operation::pre_mm:
+        case Operation::cmp_null:
+        case Operation::ret:
+            return {get_param(0)};
+        default:
+        {
+            std::vector<std::string> vars;
+            for (size_t i = op == Operation::call ? 2 : 1; i < params.size(); ++i)
+                vars.push_back(get_param(i));
+            return vars;
+        }
+    }
+}
+
+bool IRInstr::has_side_effects() const
+{
+    return op == Operation::call || op == Operation::ret || op == Operation::counter_inc;
+}
+
+bool IRInstr::get_expected_probability(double &probability) const
+{
+    if (op != Operation::cmp_null || params.size() < 2)
+        return false;
+    probability = std::stod(get_param(1)) / 100.0;
+    return true;
+}
+
+void IRInstr::set_expected_probability(double probability)
+{
+    params.resize(2);
+    params[1] = bb->cfg->intern_operand(std::to_string(100 * probability));
+}
+
+bool IRInstr::leaves_result_in_reg_a(const std::string &var) const
+{
+    if (params.empty() || get_param(0) != var)
+        return false;
+    switch(op)
+    {
+        case Operation::add:
+        case Operation::sub:
+        case Operation::mul:
+        case Operation::div:
+        case Operation::neg:
+        case Operation::rmem:
+        case Operation::wmem:
+        case Operation::call:
+        case Operation::cmp_eq:
+        case Operation::cmp_lt:
+        case Operation::cmp_le:
+        case Operation::cmp_gt:
+        case Operation::cmp_ge:
+        case Operation::cmp_ne:
+        case Operation::band:
+        case Operation::bor:
+        case Operation::bxor:
+        case Operation::bnot:
+        case Operation::shl:
+        case Operation::sar:
+        case Operation::abs:
+        case Operation::min:
+        case Operation::max:
+        case Operation::popcnt:
+        case Operation::lzcnt:
+        case Operation::tzcnt:
+        case Operation::select:
+        case Operation::lnot:
+            return true;
+        default:
+            return false;
+    }
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // class BasicBlock                                                           //
@@ -716,108 +1224,145 @@ BasicBlock::BasicBlock(CFG* cfg, const std::string &entry_label) :
     this->cfg = cfg;
 }
 
-BasicBlock::~BasicBlock()
+void BasicBlock::gen_asm(Writer& writer, const BasicBlock* next)
 {
+    writer.assembly(0) << label << ":" << '\n';
     for (IRInstr* instr : instrs)
     {
-        delete instr;
-    }
-}
-
-void BasicBlock::gen_asm(Writer& writer)
-{
-    writer.assembly(0) << label << ":" << std::endl;
-    for (IRInstr* instr : instrs)
-    {
+        cfg->gen_asm_source_position(writer, instr->get_position());
         instr->gen_asm(writer);
     }
 
     if(instrs.empty())
     {
-        if(exit_true)
+        if(exit_true && exit_true != next)
         {
-            writer.assembly(1) << "jmp " << exit_true->label << std::endl;
+            writer.assembly(1) << "jmp " << exit_true->label << '\n';
         }
         return;
     }
 
-    if (instrs.back()->get_operation() == IRInstr::Operation::cmp_null)
+    // the ret instruction already left the function
+    if (instrs.back()->get_operation() == IRInstr::Operation::ret)
     {
-        writer.assembly(1) << "jne " << exit_true->label << std::endl;
-        if(exit_false)
-        {
-            writer.assembly(1) << "jmp " << exit_false->label << std::endl;
-        }
-    }
-    else if (instrs.back()->get_operation() == IRInstr::Operation::cmp_eq)
-    {
-        writer.assembly(1) << "je " << exit_true->label << std::endl;
-        if(exit_false)
-        {
-            writer.assembly(1) << "jmp " << exit_false->label << std::endl;
-        }
+        return;
     }
-    else if (instrs.back()->get_operation() == IRInstr::Operation::cmp_lt)
+
+    if (exit_false == nullptr)
     {
-        writer.assembly(1) << "jl " << exit_true->label << std::endl;
-        if(exit_false)
+        if (!exit_true)
         {
-            writer.assembly(1) << "jmp " << exit_false->label << std::endl;
+            Writer::error() << instrs.size() << std::endl;
+            Writer::error() << label << std::endl;
         }
-    }
-    else if (instrs.back()->get_operation() == IRInstr::Operation::cmp_le)
-    {
-        writer.assembly(1) << "jle " << exit_true->label << std::endl;
-        if(exit_false)
+        else if (exit_true != next)
         {
-            writer.assembly(1) << "jmp " << exit_false->label << std::endl;
+            writer.assembly(1) << "jmp " << exit_true->label << '\n';
         }
+        return;
     }
-    else if (instrs.back()->get_operation() == IRInstr::Operation::cmp_gt)
+
+    const char* jump_true = nullptr;  // conditional jump taken towards exit_true
+    const char* jump_false = nullptr; // conditional jump taken towards exit_false
+    switch (instrs.back()->get_operation())
     {
-        writer.assembly(1) << "jg " << exit_true->label << std::endl;
-        if(exit_false)
+        case IRInstr::Operation::cmp_null:
+            jump_true = "jne";
+            jump_false = "je";
+        break;
+        case IRInstr::Operation::cmp_eq:
+            jump_true = "je";
+            jump_false = "jne";
+        break;
+        case IRInstr::Operation::cmp_lt:
+            jump_true = "jl";
+            jump_false = "jge";
+        break;
+        case IRInstr::Operation::cmp_le:
+            jump_true = "jle";
+            jump_false = "jg";
+        break;
+        case IRInstr::Operation::cmp_gt:
+            jump_true = "jg";
+            jump_false = "jle";
+        break;
+        case IRInstr::Operation::cmp_ge:
+            jump_true = "jge";
+            jump_false = "jl";
+        break;
+        default:
         {
-            writer.assembly(1) << "jmp " << exit_false->label << std::endl;
+            std::string name = cfg->get_last_var_name();
+
+            writer.assembly(1) << "movq " << cfg->get_var_index(name) << "(%rbp), %rax" << '\n';
+            writer.assembly(1) << "cmpq $0, %rax" << '\n';
+            jump_true = "jne";
+            jump_false = "je";
         }
+        break;
     }
-    else if (instrs.back()->get_operation() == IRInstr::Operation::cmp_ge)
+
+    // the successor placed right after this block is reached by falling through
+    if (exit_false == next)
     {
-        writer.assembly(1) << "jge " << exit_true->label << std::endl;
-        if(exit_false)
-        {
-            writer.assembly(1) << "jmp " << exit_false->label << std::endl;
-        }
+        writer.assembly(1) << jump_true << " " << exit_true->label << '\n';
     }
-    else if (exit_false != nullptr)
+    else if (exit_true == next)
     {
-        std::string name = cfg->get_last_var_name();
-
-        writer.assembly(1) << "movq " << cfg->get_var_index(name) << "(%rbp), %rax" << std::endl;
-        writer.assembly(1) << "cmpq $0, %rax" << std::endl;
-        writer.assembly(1) << "je " << exit_false->label << std::endl;
-        writer.assembly(1) << "jne " << exit_true->label << std::endl;
+        writer.assembly(1) << jump_false << " " << exit_false->label << '\n';
     }
     else
     {
-        if (!exit_true)
-        {
-            Writer::error() << instrs.size() << std::endl;
-            Writer::error() << label << std::endl;
-        }
-        writer.assembly(1) << "jmp " << exit_true->label << std::endl;
+        writer.assembly(1) << jump_true << " " << exit_true->label << '\n';
+        writer.assembly(1) << "jmp " << exit_false->label << '\n';
     }
 }
 
 void BasicBlock::add_IRInstr(IRInstr::Operation op, Type t, std::vector<std::string> params)
 {
-    instrs.push_back(new IRInstr(this, op, t, params));
+    instrs.push_back(cfg->create_IRInstr(this, op, t, params));
+}
+
+const IRInstr* BasicBlock::get_previous_IRInstr(const IRInstr* instr) const
+{
+    auto it = std::find(instrs.begin(), instrs.end(), instr);
+    if (it == instrs.begin() || it == instrs.end())
+        return nullptr;
+    return *(it-1);
+}
+
+std::vector<BasicBlock*> BasicBlock::get_successors() const
+{
+    std::vector<BasicBlock*> successors;
+    if (exit_true)
+        successors.push_back(exit_true);
+    if (exit_false && exit_false != exit_true)
+        successors.push_back(exit_false);
+    return successors;
+}
+
+bool BasicBlock::is_conditional() const
+{
+    return exit_true && exit_false && !instrs.empty()
+        && instrs.back()->get_operation() == IRInstr::Operation::cmp_null;
+}
+
+void BasicBlock::replace_successor(const BasicBlock* old_successor, BasicBlock* new_successor)
+{
+    if (exit_true == old_successor)
+        exit_true = new_successor;
+    if (exit_false == old_successor)
+        exit_false = new_successor;
 }
 
 void BasicBlock::print_debug_infos() const
 {
-    Writer::info() << "Basic Bloc : " << label << std::endl;
-    // Amelioration : ajouter les noms des blocs suivants (exit_true, exit_false)
+    std::ostream& os = Writer::info() << "  Basic Bloc : " << label;
+    if (exit_true)
+        os << " -> " << exit_true->label;
+    if (exit_false)
+        os << ", " << exit_false->label;
+    os << std::endl;
     for (IRInstr* instr : instrs)
     {
         instr->print_debug_infos();
@@ -829,37 +1374,103 @@ void BasicBlock::print_debug_infos() const
 ////////////////////////////////////////////////////////////////////////////////
 
 CFG::CFG(const CProgASTFuncdef* funcdef, const std::string &name, TableOfSymbols* global_symbols) :
-    ast(funcdef), nextBBnumber(0), function_name(name), symbols(global_symbols)
+    ast(funcdef), nextBBnumber(0), function_name(name), symbols(global_symbols), block_frequency(nullptr), epilogue_size(0)
 {
-    BasicBlock* entry = new BasicBlock(this, new_BB_name());
-    BasicBlock* exit = new BasicBlock(this, new_BB_name());
+    BasicBlock* entry = create_bb();
+    BasicBlock* exit = create_bb();
     entry->exit_true = exit;
     bbs.push_back(entry);
     bbs.push_back(exit);
     current_bb = entry;
 }
 
+CFG::~CFG()
+{
+    delete block_frequency;
+}
+
 void CFG::gen_asm(Writer& writer)
 {
-    for (BasicBlock* bb : bbs){
-        bb->gen_asm(writer);
+    layout_unlikely_blocks();
+
+    // hot/cold splitting: the entry and exit blocks frame the function and stay in .text
+    std::vector<BasicBlock*> hot_bbs;
+    cold_bbs.clear();
+    for (BasicBlock* bb : bbs)
+    {
+        if (writer.get_options().split_cold_blocks && bb != bbs.front() && bb != bbs.back()
+            && get_block_frequency(bb) < COLD_FREQUENCY)
+            cold_bbs.push_back(bb);
+        else
+            hot_bbs.push_back(bb);
+    }
+
+    for (size_t i=0; i<hot_bbs.size(); ++i){
+        hot_bbs[i]->gen_asm(writer, i+1 < hot_bbs.size() ? hot_bbs[i+1] : nullptr);
     }
 }
 
-std::string CFG::IR_var_to_asm(const std::string &var)
+void CFG::gen_asm_cold_blocks(Writer& writer)
 {
-    return std::to_string(get_var_index(var)) + "(%rbp)";
+    if (cold_bbs.empty())
+        return;
+    writer.assembly(1) << ".section\t.text.unlikely,\"ax\",@progbits" << '\n';
+    writer.assembly(1) << ".type\t" << function_name << ".cold, @function" << '\n';
+    writer.assembly(0) << function_name << ".cold:" << '\n';
+    // the frame of the function is already set up when the cold part is entered
+    writer.assembly(1) << ".cfi_startproc" << '\n';
+    writer.assembly(1) << ".cfi_def_cfa %rbp, 16" << '\n';
+    writer.assembly(1) << ".cfi_offset %rbp, -16" << '\n';
+    emitted_position = SourcePosition();
+    for (size_t i=0; i<cold_bbs.size(); ++i){
+        cold_bbs[i]->gen_asm(writer, i+1 < cold_bbs.size() ? cold_bbs[i+1] : nullptr);
+    }
+    writer.assembly(1) << ".cfi_endproc" << '\n';
+    writer.assembly(1) << ".size\t" << function_name << ".cold, .-" << function_name << ".cold" << '\n';
+    writer.assembly(1) << ".text" << '\n';
+}
+
+void CFG::gen_asm_function_end(Writer& writer)
+{
+    writer.assembly(1) << ".cfi_endproc" << '\n';
+    writer.assembly(1) << ".size\t" << function_name << ", .-" << function_name << '\n';
+}
+
+void CFG::gen_asm_source_position(Writer& writer, const SourcePosition &position)
+{
+    if (position.line == 0 || position.line == emitted_position.line)
+        return;
+    writer.assembly(1) << ".loc 1 " << position.line << " " << position.column << '\n';
+    emitted_position = position;
+}
+
+X86Operand CFG::IR_var_to_asm(const std::string &var)
+{
+    return { nullptr, get_var_index(var) };
+}
+
+X86Operand CFG::IR_var_to_asm(const IROperand &var) const
+{
+    if (var.kind != IROperand::VARIABLE)
+        Writer::error() << "use of undeclared identifier '" << var.name << "'" << std::endl;
+    return { nullptr, var.index };
 }
 
 void CFG::gen_asm_prologue(Writer& w){
-    w.assembly(1) << ".globl\t" << function_name << std::endl;
-    //w.assembly(1) << ".type\t" << function_name << ", @function" << std::endl;
-    w.assembly(0) << function_name << ":" << std::endl;
-    w.assembly(1) << "pushq %rbp" << std::endl;
-    w.assembly(1) << "movq %rsp, %rbp" << std::endl;
-    size_t stack_size = symbols.get_aligned_size(32);
+    w.assembly(1) << ".globl\t" << function_name << '\n';
+    w.assembly(1) << ".type\t" << function_name << ", @function" << '\n';
+    w.assembly(0) << function_name << ":" << '\n';
+    w.assembly(1) << ".cfi_startproc" << '\n';
+    emitted_position = SourcePosition();
+    gen_asm_source_position(w, definition_position);
+    w.assembly(1) << "pushq %rbp" << '\n';
+    w.assembly(1) << ".cfi_def_cfa_offset 16" << '\n';
+    w.assembly(1) << ".cfi_offset %rbp, -16" << '\n';
+    w.assembly(1) << "movq %rsp, %rbp" << '\n';
+    w.assembly(1) << ".cfi_def_cfa_register %rbp" << '\n';
+    size_t stack_size = get_frame_size(w.get_options());
     if (stack_size != 0)
-        w.assembly(1) << "subq $" << std::to_string(stack_size) << ", %rsp" << std::endl;
+        w.assembly(1) << "subq $" << stack_size << ", %rsp" << '\n';
 
     if (symbols.get_nb_parameters() > 0)
     {
@@ -874,17 +1485,79 @@ void CFG::gen_asm_prologue(Writer& w){
             limit = symbols.get_nb_parameters();
         }
         for (int count_param = 0; count_param < limit; ++count_param) {
-            w.assembly(1) << "movq " << param_registers_64[count_register] << ", %rax" << std::endl;
-            w.assembly(1) << IRInstr::x86_instr("mov", symbols.get_arg(count_param).type) << " " << IRInstr::IR_reg_to_asm("a", symbols.get_arg(count_param).type) << ", " << symbols.get_arg(count_param).index << "(%rbp)" << std::endl;
+            w.assembly(1) << "movq " << param_registers_64[count_register] << ", %rax" << '\n';
+            w.assembly(1) << IRInstr::x86_instr("mov", symbols.get_arg(count_param).type) << " " << IRInstr::IR_reg_to_asm(Register::A, symbols.get_arg(count_param).type) << ", " << symbols.get_arg(count_param).index << "(%rbp)" << '\n';
             --count_register;
         }
     }
+
+    if (w.get_options().instrument_functions)
+    {
+        // start cycle, no callee yet, and this frame becomes the one of the callees
+        const int index = get_instrument_frame_index();
+        w.assembly(1) << "rdtsc" << '\n';
+        w.assembly(1) << "shlq $32, %rdx" << '\n';
+        w.assembly(1) << "orq %rdx, %rax" << '\n';
+        w.assembly(1) << "movq %rax, " << index << "(%rbp)" << '\n';
+        w.assembly(1) << "movq $0, " << index + 8 << "(%rbp)" << '\n';
+        w.assembly(1) << "movq __brutus_instrument_frame(%rip), %rax" << '\n';
+        w.assembly(1) << "movq %rax, " << index + 16 << "(%rbp)" << '\n';
+        w.assembly(1) << "leaq " << index + 8 << "(%rbp), %rax" << '\n';
+        w.assembly(1) << "movq %rax, __brutus_instrument_frame(%rip)" << '\n';
+    }
+}
+
+void CFG::gen_asm_epilogue(Writer& w) const {
+    if (w.get_options().instrument_functions)
+    {
+        // the cycles of this call go to its function record, and to the callees of the caller
+        const int index = get_instrument_frame_index();
+        w.assembly(1) << "movq %rax, %rsi" << '\n';
+        w.assembly(1) << "rdtsc" << '\n';
+        w.assembly(1) << "shlq $32, %rdx" << '\n';
+        w.assembly(1) << "orq %rdx, %rax" << '\n';
+        w.assembly(1) << "subq " << index << "(%rbp), %rax" << '\n';
+        w.assembly(1) << "leaq .Lbrutus_instrument_" << function_name << "(%rip), %rdx" << '\n';
+        w.assembly(1) << "incq (%rdx)" << '\n';
+        w.assembly(1) << "addq %rax, 8(%rdx)" << '\n';
+        w.assembly(1) << "addq %rax, 16(%rdx)" << '\n';
+        w.assembly(1) << "movq " << index + 8 << "(%rbp), %rcx" << '\n';
+        w.assembly(1) << "subq %rcx, 16(%rdx)" << '\n';
+        w.assembly(1) << "movq " << index + 16 << "(%rbp), %rcx" << '\n';
+        w.assembly(1) << "movq %rcx, __brutus_instrument_frame(%rip)" << '\n';
+        w.assembly(1) << "addq %rax, (%rcx)" << '\n';
+        w.assembly(1) << "movq %rsi, %rax" << '\n';
+    }
+    // the epilogue may be duplicated in the middle of the function, whose code after it still runs in the frame
+    w.assembly(1) << ".cfi_remember_state" << '\n';
+    w.assembly(1) << "movq %rbp, %rsp" << '\n';
+    w.assembly(1) << "popq %rbp" << '\n';
+    w.assembly(1) << ".cfi_def_cfa %rsp, 8" << '\n';
+    w.assembly(1) << "ret" << '\n';
+    w.assembly(1) << ".cfi_restore_state" << '\n';
+}
+
+size_t CFG::get_epilogue_size(const Options &options) const
+{
+    // the instructions of an epilogue written aside, as the Writer counts them
+    if (epilogue_size == 0)
+    {
+        std::stringbuf discarded;
+        Writer writer(options, &discarded);
+        gen_asm_epilogue(writer);
+        epilogue_size = writer.get_nb_instructions();
+    }
+    return epilogue_size;
+}
+
+size_t CFG::get_frame_size(const Options &options) const
+{
+    return symbols.get_aligned_size(32) + (options.instrument_functions ? INSTRUMENT_FRAME_SIZE : 0);
 }
 
-void CFG::gen_asm_epilogue(Writer& w){
-    w.assembly(1) << "movq %rbp, %rsp" << std::endl;
-    w.assembly(1) << "popq %rbp" << std::endl;
-    w.assembly(1) << "ret" << std::endl;
+int CFG::get_instrument_frame_index() const
+{
+    return -static_cast<int>(symbols.get_aligned_size(32)) - INSTRUMENT_FRAME_SIZE;
 }
 
 
@@ -943,6 +1616,116 @@ SymbolProperties& CFG::get_symbol_properties(const std::string &symbol_name)
     return symbols.get_symbol(symbol_name);
 }
 
+uint32_t CFG::intern_operand(const std::string &name)
+{
+    const uint32_t name_id = StringPool::intern(name);
+    if (name_id >= operand_ids.size())
+        operand_ids.resize(StringPool::size(), StringPool::NOT_FOUND);
+    if (operand_ids[name_id] != StringPool::NOT_FOUND)
+        return operand_ids[name_id];
+    IROperand operand;
+    operand.name = name;
+    resolve_operand(operand);
+    operands.push_back(operand);
+    operand_ids[name_id] = operands.size() - 1;
+    return operands.size() - 1;
+}
+
+const IROperand& CFG::get_operand(uint32_t id) const
+{
+    return operands[id];
+}
+
+bool CFG::find_cached_value(const CProgASTExpression* expression, std::string &name)
+{
+    auto it = cached_values.find(expression);
+    // a temporary of another block may not be computed on every path
+    if (it == cached_values.end() || it->second.bb != current_bb)
+        return false;
+    name = it->second.name;
+    // the expressions using the value read its variables too
+    read_log.insert(read_log.end(), it->second.reads.begin(), it->second.reads.end());
+    return true;
+}
+
+void CFG::cache_value(const CProgASTExpression* expression, const std::string &name, size_t first_read)
+{
+    std::vector<uint32_t> reads(read_log.begin() + first_read, read_log.end());
+    cached_values[expression] = {current_bb, name, reads};
+}
+
+void CFG::log_read(const std::string &name)
+{
+    read_log.push_back(StringPool::intern(name));
+}
+
+size_t CFG::get_nb_reads() const
+{
+    return read_log.size();
+}
+
+void CFG::invalidate_cached_values(const std::string &name)
+{
+    uint32_t id = StringPool::intern(name);
+    for (auto it = cached_values.begin(); it != cached_values.end();)
+    {
+        const std::vector<uint32_t> &reads = it->second.reads;
+        if (it->second.name == name || std::find(reads.begin(), reads.end(), id) != reads.end())
+            it = cached_values.erase(it);
+        else
+            ++it;
+    }
+}
+
+void CFG::invalidate_cached_values()
+{
+    cached_values.clear();
+    read_log.clear();
+}
+
+void CFG::resolve_operand(IROperand &operand) const
+{
+    operand.kind = IROperand::SYMBOL;
+    operand.type = Type::INT_64;
+    operand.index = 0;
+    operand.value = 0;
+    if (symbols.is_declared(operand.name))
+    {
+        const SymbolProperties &symbol = symbols.get_symbol(operand.name);
+        if (!symbol.callable)
+        {
+            operand.kind = IROperand::VARIABLE;
+            operand.type = symbol.type;
+            operand.index = symbol.index;
+        }
+        return;
+    }
+    // integers, and the percents of the cmp_null weighted by a profile
+    if (operand.name.empty())
+        return;
+    char* end;
+    const long long value = std::strtoll(operand.name.c_str(), &end, 10);
+    if (*end == '\0')
+    {
+        operand.kind = IROperand::IMMEDIATE;
+        operand.value = value;
+        return;
+    }
+    const double real = std::strtod(operand.name.c_str(), &end);
+    if (*end == '\0')
+    {
+        operand.kind = IROperand::IMMEDIATE;
+        operand.value = static_cast<int64_t>(real);
+    }
+}
+
+void CFG::update_operand(const std::string &name)
+{
+    const uint32_t name_id = StringPool::find(name);
+    if (name_id < operand_ids.size() && operand_ids[name_id] != StringPool::NOT_FOUND)
+        resolve_operand(operands[operand_ids[name_id]]);
+}
+
 std::string CFG::new_BB_name()
 {
     return "." + function_name + "_block" + std::to_string(nextBBnumber++);
@@ -953,19 +1736,94 @@ BasicBlock* CFG::get_last_bb()
     return bbs.back();
 }
 
+BasicBlock* CFG::get_entry_bb()
+{
+    return bbs.front();
+}
+
+const std::vector<BasicBlock*>& CFG::get_bbs() const
+{
+    return bbs;
+}
+
 void CFG::add_bb(BasicBlock* bb)
 {
     bbs.insert(bbs.end()-1, bb);
+    invalidate_analyses();
+}
+
+BasicBlock* CFG::create_bb()
+{
+    return bb_arena.create<BasicBlock>(this, new_BB_name());
+}
+
+IRInstr* CFG::create_IRInstr(BasicBlock* bb, IRInstr::Operation op, Type t, const std::vector<std::string> &params)
+{
+    return instr_arena.create<IRInstr>(bb, op, t, params);
+}
+
+IRInstr* CFG::create_IRInstr(BasicBlock* bb, const IRInstr& src)
+{
+    return instr_arena.create<IRInstr>(bb, src);
 }
 
-void CFG::add_to_symbol_table(const std::string &name, Type type)
+size_t CFG::get_allocated_bytes() const
 {
-    symbols.add_symbol(name, type);
+    return bb_arena.get_allocated_bytes() + instr_arena.get_allocated_bytes();
+}
+
+BasicBlock* CFG::clone_bb(const BasicBlock* bb)
+{
+    BasicBlock* clone = create_bb();
+    clone->exit_true = bb->exit_true;
+    clone->exit_false = bb->exit_false;
+    for (const IRInstr* instr : bb->instrs)
+    {
+        clone->instrs.push_back(create_IRInstr(clone, *instr));
+    }
+    return clone;
+}
+
+void CFG::insert_bb_after(const BasicBlock* position, BasicBlock* bb)
+{
+    auto it = std::find(bbs.begin(), bbs.end(), position);
+    bbs.insert(it == bbs.end() ? bbs.end()-1 : it+1, bb);
+    invalidate_analyses();
+}
+
+void CFG::insert_bb_before(const BasicBlock* position, BasicBlock* bb)
+{
+    auto it = std::find(bbs.begin(), bbs.end(), position);
+    bbs.insert(it == bbs.end() ? bbs.end()-1 : it, bb);
+    invalidate_analyses();
+}
+
+void CFG::replace_bb(const BasicBlock* old_bb, BasicBlock* new_bb)
+{
+    auto it = std::find(bbs.begin(), bbs.end(), old_bb);
+    if (it != bbs.end())
+        *it = new_bb;
+    invalidate_analyses();
+}
+
+void CFG::remove_bb(BasicBlock* bb)
+{
+    auto it = std::find(bbs.begin(), bbs.end(), bb);
+    if (it != bbs.end())
+        bbs.erase(it);
+    invalidate_analyses();
+}
+
+std::string CFG::add_to_symbol_table(const std::string &identifier, Type type)
+{
+    std::string name = symbols.add_symbol(identifier, type);
+    update_operand(name);
+    return name;
 }
 
 void CFG::add_arg_to_symbol_table(const std::string &name, Type type)
 {
-    symbols.add_arg(name, type);
+    update_operand(symbols.add_arg(name, type));
 }
 
 std::string CFG::create_new_tempvar(Type type)
@@ -978,6 +1836,28 @@ bool CFG::is_declared(const std::string &name) const
     return symbols.is_declared(name);
 }
 
+void CFG::enter_scope()
+{
+    invalidate_cached_values();
+    symbols.enter_scope();
+}
+
+void CFG::exit_scope()
+{
+    invalidate_cached_values();
+    symbols.exit_scope();
+}
+
+std::string CFG::lookup(const std::string &identifier) const
+{
+    return symbols.lookup(identifier);
+}
+
+bool CFG::is_declared_in_scope(const std::string &identifier) const
+{
+    return symbols.is_declared_in_scope(identifier);
+}
+
 Type CFG::get_max_type(const std::string &lhs, const std::string &rhs) const
 {
     return TypeProperties::max(get_var_type(lhs), get_var_type(rhs));
@@ -993,8 +1873,14 @@ int CFG::get_nb_parameters() const
     return symbols.get_nb_parameters();
 }
 
+int CFG::get_nb_temporaries() const
+{
+    return symbols.get_nb_tmp_vars();
+}
+
 void CFG::print_debug_infos() const
 {
+    print_debug_infos_variables();
     for (BasicBlock* bb : bbs)
     {
         bb->print_debug_infos();
@@ -1006,6 +1892,78 @@ void CFG::print_debug_infos_variables() const
     symbols.print_debug_infos();
 }
 
+double CFG::get_block_frequency(const BasicBlock* bb)
+{
+    if (!block_frequency)
+        block_frequency = new BlockFrequency(this);
+    return block_frequency->get_frequency(bb);
+}
+
+double CFG::get_edge_probability(const BasicBlock* from, const BasicBlock* to)
+{
+    if (!block_frequency)
+        block_frequency = new BlockFrequency(this);
+    return block_frequency->get_probability(from, to);
+}
+
+double CFG::get_edge_frequency(const BasicBlock* from, const BasicBlock* to)
+{
+    if (!block_frequency)
+        block_frequency = new BlockFrequency(this);
+    return block_frequency->get_edge_frequency(from, to);
+}
+
+void CFG::invalidate_analyses()
+{
+    delete block_frequency;
+    block_frequency = nullptr;
+}
+
+void CFG::layout_unlikely_blocks()
+{
+    // the expected successor becomes the fall through, the unlikely region goes before the exit block
+    LoopInfo loop_info(this);
+    std::set<const BasicBlock*> unlikely_blocks;
+    for (const BasicBlock* bb : bbs)
+    {
+        // only the strongly biased branches, as given by __builtin_expect
+        double probability;
+        if (!bb->is_conditional() || !bb->instrs.back()->get_expected_probability(probability)
+            || std::min(probability, 1 - probability) > (100 - IRInstr::EXPECTED_PERCENT) / 100.0)
+            continue;
+        const BasicBlock* unlikely = probability < 0.5 ? bb->exit_true : bb->exit_false;
+        if (unlikely == bbs.front() || unlikely == bbs.back() || unlikely_blocks.count(unlikely) || loop_info.get_predecessors(unlikely).size() != 1)
+            continue;
+        for (const BasicBlock* other : bbs)
+        {
+            if (other != bbs.back() && loop_info.dominates(unlikely, other))
+                unlikely_blocks.insert(other);
+        }
+    }
+    if (unlikely_blocks.empty())
+        return;
+
+    std::stable_partition(bbs.begin(), bbs.end()-1, [&](const BasicBlock* bb) -> bool
+        {
+            return !unlikely_blocks.count(bb);
+        }
+    );
+}
+
+void CFG::print_block_frequencies()
+{
+    Writer::info() << "Fréquence des blocs de " << function_name << " : " << std::endl;
+    for (const BasicBlock* bb : bbs)
+    {
+        std::ostream& os = Writer::info() << std::fixed << std::setprecision(3) << "  " << bb->label << " : " << get_block_frequency(bb);
+        for (const BasicBlock* successor : bb->get_successors())
+        {
+            os << ", -> " << successor->label << " (" << std::setprecision(0) << 100 * get_edge_probability(bb, successor) << "%)" << std::setprecision(3);
+        }
+        os << std::endl;
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class IR                                                                   //
 ////////////////////////////////////////////////////////////////////////////////
@@ -1028,13 +1986,119 @@ void IR::add_cfg(CFG* cfg)
     cfgs.push_back(cfg);
 }
 
+const std::vector<CFG*>& IR::get_cfgs() const
+{
+    return cfgs;
+}
+
 void IR::gen_asm(){
-    writer.assembly(1) << ".file\t\""+filename+"\"" << std::endl;
-    writer.assembly(1) << ".text" << std::endl;
+    writer.assembly(1) << ".file\t\""+filename+"\"" << '\n';
+    writer.assembly(1) << ".file 1 \""+filename+"\"" << '\n';
+    writer.assembly(1) << ".text" << '\n';
     for (CFG* cfg : cfgs){
+        PhaseTimer timer("codegen", cfg->get_name());
+        size_t nb_instructions = writer.get_nb_instructions();
         cfg->gen_asm_prologue(writer);
         cfg->gen_asm(writer);
         cfg->gen_asm_epilogue(writer);
+        cfg->gen_asm_function_end(writer);
+        cfg->gen_asm_cold_blocks(writer);
+        Statistics::add(cfg->get_name(), "asm-instructions", writer.get_nb_instructions() - nb_instructions);
+    }
+    if (writer.get_options().instrument_functions)
+        gen_asm_instrument_functions_runtime();
+}
+
+void IR::gen_asm_instrument_functions_runtime()
+{
+    // records {calls, inclusive cycles, exclusive cycles, name}, sorted by exclusive cycles at exit
+    writer.assembly(1) << ".data" << '\n';
+    writer.assembly(1) << ".align 8" << '\n';
+    writer.assembly(0) << "__brutus_instrument_frame:" << '\n';
+    writer.assembly(1) << ".quad __brutus_instrument_outside" << '\n';
+    writer.assembly(0) << "__brutus_instrument_outside:" << '\n';
+    writer.assembly(1) << ".quad 0" << '\n';
+    writer.assembly(0) << "__brutus_instrument_records:" << '\n';
+    for (size_t i=0; i<cfgs.size(); ++i)
+    {
+        writer.assembly(0) << ".Lbrutus_instrument_" << cfgs[i]->get_name() << ":" << '\n';
+        writer.assembly(1) << ".quad 0, 0, 0, .Lbrutus_instrument_name" << i << '\n';
+    }
+    writer.assembly(1) << ".section\t.rodata" << '\n';
+    for (size_t i=0; i<cfgs.size(); ++i)
+    {
+        writer.assembly(0) << ".Lbrutus_instrument_name" << i << ":" << '\n';
+        writer.assembly(1) << ".string \"" << cfgs[i]->get_name() << "\"" << '\n';
+    }
+    writer.assembly(0) << ".Lbrutus_instrument_header:" << '\n';
+    writer.assembly(1) << ".string \"function                    calls  inclusive cycles  exclusive cycles\\n\"" << '\n';
+    writer.assembly(0) << ".Lbrutus_instrument_format:" << '\n';
+    writer.assembly(1) << ".string \"%-20s %12lu %17lu %17lu\\n\"" << '\n';
+
+    // int __brutus_instrument_compare(const void*, const void*), decreasing exclusive cycles
+    writer.assembly(1) << ".text" << '\n';
+    writer.assembly(0) << "__brutus_instrument_compare:" << '\n';
+    writer.assembly(1) << "xorl %eax, %eax" << '\n';
+    writer.assembly(1) << "movq 16(%rdi), %rdx" << '\n';
+    writer.assembly(1) << "cmpq %rdx, 16(%rsi)" << '\n';
+    writer.assembly(1) << "seta %al" << '\n';
+    writer.assembly(1) << "sbbl $0, %eax" << '\n';
+    writer.assembly(1) << "ret" << '\n';
+
+    // void __brutus_instrument_report(void), flat profile on stderr
+    writer.assembly(0) << "__brutus_instrument_report:" << '\n';
+    writer.assembly(1) << "pushq %rbp" << '\n';
+    writer.assembly(1) << "movq %rsp, %rbp" << '\n';
+    writer.assembly(1) << "pushq %rbx" << '\n';
+    writer.assembly(1) << "pushq %r12" << '\n';
+    writer.assembly(1) << "leaq __brutus_instrument_compare(%rip), %rcx" << '\n';
+    writer.assembly(1) << "movq $32, %rdx" << '\n';
+    writer.assembly(1) << "movq $" << cfgs.size() << ", %rsi" << '\n';
+    writer.assembly(1) << "leaq __brutus_instrument_records(%rip), %rdi" << '\n';
+    writer.assembly(1) << "call qsort" << '\n';
+    writer.assembly(1) << "movq stderr@GOTPCREL(%rip), %rax" << '\n';
+    writer.assembly(1) << "movq (%rax), %rsi" << '\n';
+    writer.assembly(1) << "leaq .Lbrutus_instrument_header(%rip), %rdi" << '\n';
+    writer.assembly(1) << "call fputs" << '\n';
+    writer.assembly(1) << "leaq __brutus_instrument_records(%rip), %rbx" << '\n';
+    writer.assembly(1) << "leaq __brutus_instrument_records+" << 32 * cfgs.size() << "(%rip), %r12" << '\n';
+    writer.assembly(0) << ".Lbrutus_instrument_loop:" << '\n';
+    writer.assembly(1) << "movq stderr@GOTPCREL(%rip), %rax" << '\n';
+    writer.assembly(1) << "movq (%rax), %rdi" << '\n';
+    writer.assembly(1) << "leaq .Lbrutus_instrument_format(%rip), %rsi" << '\n';
+    writer.assembly(1) << "movq 24(%rbx), %rdx" << '\n';
+    writer.assembly(1) << "movq (%rbx), %rcx" << '\n';
+    writer.assembly(1) << "movq 8(%rbx), %r8" << '\n';
+    writer.assembly(1) << "movq 16(%rbx), %r9" << '\n';
+    writer.assembly(1) << "movl $0, %eax" << '\n';
+    writer.assembly(1) << "call fprintf" << '\n';
+    writer.assembly(1) << "addq $32, %rbx" << '\n';
+    writer.assembly(1) << "cmpq %r12, %rbx" << '\n';
+    writer.assembly(1) << "jb .Lbrutus_instrument_loop" << '\n';
+    writer.assembly(1) << "popq %r12" << '\n';
+    writer.assembly(1) << "popq %rbx" << '\n';
+    writer.assembly(1) << "popq %rbp" << '\n';
+    writer.assembly(1) << "ret" << '\n';
+
+    // constructor registering the report at exit
+    writer.assembly(0) << "__brutus_instrument_init:" << '\n';
+    writer.assembly(1) << "pushq %rbp" << '\n';
+    writer.assembly(1) << "movq %rsp, %rbp" << '\n';
+    writer.assembly(1) << "leaq __brutus_instrument_report(%rip), %rdi" << '\n';
+    writer.assembly(1) << "call atexit" << '\n';
+    writer.assembly(1) << "popq %rbp" << '\n';
+    writer.assembly(1) << "ret" << '\n';
+    writer.assembly(1) << ".section\t.init_array,\"aw\"" << '\n';
+    writer.assembly(1) << ".align 8" << '\n';
+    writer.assembly(1) << ".quad __brutus_instrument_init" << '\n';
+    writer.assembly(1) << ".text" << '\n';
+}
+
+void IR::print_block_frequencies() const
+{
+    for (CFG* cfg : cfgs)
+    {
+        cfg->print_block_frequencies();
     }
 }
 
@@ -1043,7 +2107,7 @@ void IR::print_debug_infos() const
     Writer::info() << "Affichage de l'IR : " << std::endl;
     for (size_t i=0; i<cfgs.size(); ++i)
     {
-        Writer::info() << "CFG " << i << " : " << std::endl;
+        Writer::info() << "CFG " << i << " : " << cfgs[i]->get_name() << std::endl;
         cfgs[i]->print_debug_infos();
     }
 }
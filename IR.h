@@ -1,20 +1,29 @@
 #pragma once
 
 // ---------------------------------------------------------- C++ System Headers
+#include <cstdint>
+#include <deque>
 #include <iostream>
 #include <map>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 
+// ------------------------------------------------------------- Project Headers
+#include "Arena.h"
+
 ////////////////////////////////////////////////////////////////////////////////
 // Forward Declarations                                                       //
 ////////////////////////////////////////////////////////////////////////////////
 
+class CProgASTExpression;
 class CProgASTFuncdef;
 class BasicBlock;
+class BlockFrequency;
 class CFG;
 class Writer;
+struct Options;
 
 ////////////////////////////////////////////////////////////////////////////////
 // enum Type                                                                  //
@@ -37,6 +46,47 @@ struct TypeProperties {
 
 extern std::map<Type, const TypeProperties> types;
 
+////////////////////////////////////////////////////////////////////////////////
+// struct SourcePosition                                                      //
+////////////////////////////////////////////////////////////////////////////////
+
+/** Position in the compiled file, emitted as .loc directives for the debuggers and profilers */
+struct SourcePosition {
+    // ------------------------------------------------------------- Constructor
+    SourcePosition(size_t line = 0, size_t column = 0);
+
+    // ------------------------------------------------------- Public Properties
+    size_t line;   /**< from 1, 0 if unknown */
+    size_t column; /**< from 1 */
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// class StringPool                                                           //
+////////////////////////////////////////////////////////////////////////////////
+
+/* Interned names: each distinct string gets a small id, in the order the
+     strings are first interned, so that the tables keyed by names can be
+     dense vectors indexed by these ids. The ids are found through a flat hash
+     table with open addressing and linear probing, kept at most half full.
+*/
+class StringPool {
+public:
+    // ------------------------------------------------- Public Member Functions
+    static uint32_t intern(const std::string &str); /**< id of str, added to the pool if needed */
+    static uint32_t find(const std::string &str);   /**< id of str, NOT_FOUND if it was never interned */
+    static const std::string& get(uint32_t id);
+    static size_t size();
+
+    static const uint32_t NOT_FOUND = UINT32_MAX;
+private:
+    static size_t find_slot(const std::string &str, size_t hash); /**< slot of str, or the empty slot where it belongs */
+    static void grow();
+
+    static std::deque<std::string> strings; /**< indexed by id, never moved */
+    static std::vector<size_t> hashes;      /**< of the strings, indexed by id */
+    static std::vector<uint32_t> slots;     /**< ids, NOT_FOUND in the empty slots, a power of two of them */
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 // class TableOfSymbols                                                       //
 ////////////////////////////////////////////////////////////////////////////////
@@ -54,8 +104,25 @@ struct SymbolProperties {
     bool callable;
     int arg_index;
     std::vector<Type> arg_types;
+    std::string identifier; /**< in the source, the name in the IR differs if it was already taken in the function */
 };
 
+/* The symbols of a function, or the global ones for the table without parent.
+     Each symbol is found in O(1) by its name in the IR, the key of the dense
+     vector indexed by StringPool ids. The identifiers of the source are
+     resolved through the scopes opened by enter_scope(), each block hiding
+     the declarations of the enclosing ones until exit_scope():
+         int x;        // x
+         {
+             int x;    // x.1, hides x
+             x = 1;    // lookup("x") gives x.1
+         }
+         {
+             int x;    // x.2
+         }
+     The symbols of the closed scopes stay in the table, for the code
+     generation, and keep their own slot in the frame.
+*/
 class TableOfSymbols {
 public:
     // ------------------------------------------------------------- Constructor
@@ -63,31 +130,106 @@ public:
 
     // ------------------------------------------------- Public Member Functions
     std::string add_tmp_var(Type type);
-    void add_symbol(std::string identifier, Type type);
-    void add_arg(std::string identifier, Type type);
-    bool is_declared(std::string identifier) const;
-    const SymbolProperties& get_symbol(std::string identifier) const;
-    SymbolProperties& get_symbol(std::string identifier);
+    std::string add_symbol(const std::string &identifier, Type type); /**< returns the name of the symbol in the IR */
+    std::string add_arg(const std::string &identifier, Type type);
+    void enter_scope();
+    void exit_scope(); /**< the declarations of the scope are no longer visible */
+    std::string lookup(const std::string &identifier) const; /**< name in the IR of the visible declaration of identifier, empty if none */
+    bool is_declared_in_scope(const std::string &identifier) const; /**< in the innermost scope, where it cannot be declared again */
+    bool is_declared(const std::string &name) const; /**< name in the IR, in this table or its parent */
+    const SymbolProperties& get_symbol(const std::string &name) const;
+    SymbolProperties& get_symbol(const std::string &name);
     const SymbolProperties& get_arg(int index) const;
     size_t get_aligned_size(size_t alignment_size) const;
     const std::string get_last_symbol_name() const;
     int get_nb_parameters() const;
-    void initialize(const std::string &identifier);
-    void set_used(const std::string &identifier);
+    int get_nb_tmp_vars() const;
+    void initialize(const std::string &name);
+    void set_used(const std::string &name);
     void check_for_unused();
 
     void print_debug_infos() const;
 protected:
     int get_next_free_symbol_index() const;
+    SymbolProperties& add(const std::string &identifier, const SymbolProperties &properties, std::string &name); /**< declares identifier in the innermost scope */
+    int find(const std::string &name) const; /**< index in symbols, -1 if not in this table */
 
     TableOfSymbols* parent;
-    std::map<std::string, SymbolProperties> symbols;
+    std::deque<SymbolProperties> symbols; /**< in the order of declaration, never moved */
+    std::vector<std::string> names;       /**< in the IR, indexed like symbols */
+    std::vector<int> symbol_ids;          /**< index in symbols, indexed by the StringPool id of the name in the IR, -1 if none */
+    std::vector<int> visible_ids;         /**< index in symbols of the visible declaration, indexed by the StringPool id of the identifier */
+    std::vector<int> nb_declarations;     /**< in the function, indexed by the StringPool id of the identifier */
+    std::vector<int> args;                /**< index in symbols, indexed by arg_index */
+    std::vector<std::vector<std::pair<uint32_t, int>>> scopes; /**< for each open scope, the identifiers it declared and the declarations they hid */
     size_t size;
     int next_arg_index;         // index of the next argument in the args list
     int next_arg_offset;     // offset of the next argument in the stack, from %rbp
     int next_tmp_var_id;
 };
 
+////////////////////////////////////////////////////////////////////////////////
+// struct IROperand                                                           //
+////////////////////////////////////////////////////////////////////////////////
+
+/* An operand of the IR instructions. The operands are interned by their CFG
+     and the instructions only keep their ids: the kind, the type and the stack
+     slot of an operand are resolved once, when it is interned or when its
+     variable is declared, instead of at each use by the code generation.
+         !tmp3     VARIABLE   int64_t at -24(%rbp)
+         42        IMMEDIATE  42
+         putchar   SYMBOL     function or global label
+*/
+struct IROperand {
+    enum Kind { VARIABLE, IMMEDIATE, SYMBOL };
+
+    // ------------------------------------------------------- Public Properties
+    std::string name;
+    Kind kind;
+    Type type;     /**< of a variable */
+    int index;     /**< stack slot of a variable, from %rbp */
+    int64_t value; /**< of an immediate */
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// x86 assembly                                                               //
+////////////////////////////////////////////////////////////////////////////////
+
+enum class Register { A, B, C, D }; /**< of the code generation, %al to %rdx depending on the Type */
+
+/* Parts of an x86 instruction, written straight into the assembly stream by
+     their operator<<. The code generation helpers of IRInstr and CFG return
+     them instead of strings, so that emitting an instruction allocates
+     nothing: the names come from constant tables indexed by Type and Register.
+         w.assembly(1) << x86_mov_var_reg(var, Register::A, Type::INT_64) << '\n';
+*/
+struct X86Mnemonic {
+    const char* name;
+    Type type;          /**< of the operands, gives the suffix, none for VOID */
+    Type extended_type; /**< second suffix of movs and movz, none for VOID */
+};
+
+struct X86Operand {
+    const char* reg; /**< nullptr for a variable of the frame */
+    int index;       /**< of the variable, from %rbp */
+};
+
+struct X86Instruction {
+    X86Mnemonic mnemonic;
+    size_t nb_operands; /**< 0 to 2 */
+    X86Operand source;
+    X86Operand destination;
+};
+
+struct X86LocalLabel {
+    unsigned int number;
+};
+
+std::ostream& operator<<(std::ostream& os, const X86Mnemonic& mnemonic);
+std::ostream& operator<<(std::ostream& os, const X86Operand& operand);
+std::ostream& operator<<(std::ostream& os, const X86Instruction& instruction);
+std::ostream& operator<<(std::ostream& os, const X86LocalLabel& label);
+
 ////////////////////////////////////////////////////////////////////////////////
 // class IRInstr                                                              //
 ////////////////////////////////////////////////////////////////////////////////
@@ -123,37 +265,65 @@ public:
         bor,
         bxor,
         bnot,
+        shl,
+        sar,
+        abs,
+        min,
+        max,
+        popcnt,
+        lzcnt,
+        tzcnt,
+        select,
         land,
         lor,
         lnot,
+        counter_inc, /**< {symbol, index}: increments the 64 bits counter symbol[index], see EdgeProfile */
         ret
     } Operation;
 
 
     /**  constructor */
     IRInstr(BasicBlock* bb, Operation op, Type t, const std::vector<std::string> &params);
+    IRInstr(BasicBlock* bb, const IRInstr& src); /**< copy of src, belonging to bb */
 
     /** Actual code generation */
     void gen_asm(Writer& writer); /**< x86 assembly code generation for this IR instruction */
-    static std::string IR_reg_to_asm(const std::string &reg, Type type); /**< helper method: inputs a, IR reg , returns e.g. "eax" for for the Type::INT_32 reg "a" */
-    static std::string x86_instr(const std::string &instr, Type type);
+    static const char* IR_reg_to_asm(Register reg, Type type); /**< helper method: inputs a register, returns e.g. "%eax" for the Type::INT_32 register A */
+    static X86Mnemonic x86_instr(const char* instr, Type type);
+    static X86Mnemonic x86_instr(X86Mnemonic instr, Type type); /**< with a second suffix, as movsbq */
 
     void print_debug_infos() const;
 
     Operation get_operation() const;
+    Type get_type() const;
+    size_t get_nb_params() const;
+    const std::string& get_param(size_t index) const;
+    const IROperand& get_operand(size_t index) const; /**< the param resolved by the CFG */
+    const SourcePosition& get_position() const;
+    std::vector<std::string> get_written_vars() const; /**< variables assigned by this instruction */
+    std::vector<std::string> get_read_vars() const; /**< variables whose value is used by this instruction */
+    bool has_side_effects() const; /**< true for calls, returns and counters, which cannot be moved or removed */
+    bool leaves_result_in_reg_a(const std::string &var) const; /**< true if the asm of this instruction ends with var's value in %rax */
+    bool get_expected_probability(double &probability) const; /**< of a non zero value, for a cmp_null {var, percent} weighted by __builtin_expect or a profile */
+    void set_expected_probability(double probability); /**< weights a cmp_null */
+
+    static const unsigned int EXPECTED_PERCENT = 90; /**< probability of the value expected by __builtin_expect */
 
 private:
-    std::string x86_instr_reg(const std::string &instr, Type type, const std::string &reg) const;
-    std::string x86_instr_reg_reg(const std::string &instr, Type type, const std::string &reg1, const std::string &reg2) const;
-    std::string x86_mov_var_reg(const std::string &var, const std::string &reg, Type reg_type, bool signed_fill = true) const;
-    std::string x86_mov_reg_var(const std::string &reg, Type reg_type, const std::string &var) const;
-    static std::string x86_extend_reg_a(Type from);
-    static std::string x86_convert_reg_a(Type from, Type to);
+    static X86Instruction x86_instr_reg(const char* instr, Type type, Register reg);
+    static X86Instruction x86_instr_reg_reg(const char* instr, Type type, Register reg1, Register reg2);
+    X86Instruction x86_mov_var_reg(const IROperand &var, Register reg, Type reg_type, bool signed_fill = true) const;
+    X86Instruction x86_mov_reg_var(Register reg, Type reg_type, const IROperand &var) const;
+    static const char* x86_extend_reg_a(Type from);
+    static X86Instruction x86_convert_reg_a(Type from, Type to);
+    X86Instruction x86_mov_var_reg_zero_extended(const IROperand &var) const; /**< var in %rax, its upper bits cleared */
+    static X86LocalLabel new_local_label();
 
     BasicBlock* bb; /**< The BB this instruction belongs to, which provides a pointer to the CFG this instruction belong to */
     Operation op;
     Type t;
-    std::vector<std::string> params; /**< For 3-op instrs: d, x, y; for ldconst: d, c;  For call: label, d, params;  for wmem and rmem: choose yourself */
+    SourcePosition position; /**< of the statement this instruction comes from */
+    std::vector<uint32_t> params; /**< ids of the operands in the CFG. For 3-op instrs: d, x, y; for ldconst: d, c;  For call: label, d, params;  for wmem and rmem: choose yourself */
     // if you subclass IRInstr, each IRInstr subclass has its parameters and the previous (very important) comment becomes useless: it would be a better design.
 };
 
@@ -179,11 +349,15 @@ std::ostream& operator<<(std::ostream& os, const IRInstr::Operation& op);
 
 class BasicBlock {
 public:
-    BasicBlock(CFG* cfg, const std::string &entry_label);
-    virtual ~BasicBlock();
-    void gen_asm(Writer& writer); /**< x86 assembly code generation for this basic block (very simple) */
+    BasicBlock(CFG* cfg, const std::string &entry_label); /**< blocks are created by CFG::create_bb() */
+    void gen_asm(Writer& writer, const BasicBlock* next = nullptr); /**< x86 assembly code generation for this basic block, jumps to next are omitted */
 
     void add_IRInstr(IRInstr::Operation op, Type t, std::vector<std::string> params);
+    const IRInstr* get_previous_IRInstr(const IRInstr* instr) const;
+
+    std::vector<BasicBlock*> get_successors() const;
+    bool is_conditional() const; /**< true if the block ends with a cmp_null choosing between exit_true and exit_false */
+    void replace_successor(const BasicBlock* old_successor, BasicBlock* new_successor);
 
     void print_debug_infos() const;
 
@@ -192,7 +366,7 @@ public:
     BasicBlock* exit_false; /**< pointer to the next basic block, false branch. If null_ptr, the basic block ends with an unconditional jump */
     std::string label; /**< label of the BB, also will be the label in the generated code */
     CFG* cfg; /** < the CFG where this block belongs */
-    std::vector<IRInstr*> instrs; /** < the instructions themselves. */
+    std::vector<IRInstr*> instrs; /** < the instructions themselves, allocated by the CFG. */
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -211,25 +385,45 @@ public:
 class CFG {
 public:
     CFG(const CProgASTFuncdef* funcdef, const std::string &name, TableOfSymbols* global_symbols);
+    virtual ~CFG();
 
     void add_bb(BasicBlock* bb);
+    BasicBlock* create_bb(); /**< new empty block, not yet part of the layout */
+    IRInstr* create_IRInstr(BasicBlock* bb, IRInstr::Operation op, Type t, const std::vector<std::string> &params); /**< not yet added to bb */
+    IRInstr* create_IRInstr(BasicBlock* bb, const IRInstr& src); /**< copy of src, not yet added to bb */
+    size_t get_allocated_bytes() const; /**< by the blocks and the instructions */
 
     // x86 code generation: could be encapsulated in a processor class in a retargetable compiler
     void gen_asm(Writer& writer);
-    std::string IR_var_to_asm(const std::string &var); /**< helper method: inputs a IR input variable, returns e.g. "-24(%rbp)" for the proper value of -24 */
+    X86Operand IR_var_to_asm(const std::string &var); /**< helper method: inputs a IR input variable, returns e.g. "-24(%rbp)" for the proper value of -24 */
+    X86Operand IR_var_to_asm(const IROperand &var) const;
     void gen_asm_prologue(Writer& writer);
-    void gen_asm_epilogue(Writer& writer);
+    void gen_asm_epilogue(Writer& writer) const;
+    void gen_asm_cold_blocks(Writer& writer); /**< the blocks gen_asm() left out, in .text.unlikely */
+    void gen_asm_function_end(Writer& writer); /**< closes the frame information and the symbol opened by gen_asm_prologue() */
+    void gen_asm_source_position(Writer& writer, const SourcePosition &position); /**< .loc directive, if the line changed since the last one */
+    size_t get_epilogue_size(const Options &options) const; /**< number of instructions emitted by gen_asm_epilogue(), measured once */
+    size_t get_frame_size(const Options &options) const; /**< bytes reserved below %rbp by gen_asm_prologue() */
+
+    static const size_t MAX_DUPLICATED_EPILOGUE_SIZE = 4; /**< larger epilogues are reached by a jump to the exit block instead of being copied at each return */
+    static const int INSTRUMENT_FRAME_SIZE = 32; /**< with -finstrument-functions, start cycle, cycles of the callees and frame of the caller, below the variables */
+    static constexpr double COLD_FREQUENCY = 0.125; /**< with -freorder-blocks-and-partition, blocks running less often per call are moved out of .text */
 
     // symbol table methods
-    void add_to_symbol_table(const std::string &name, Type type);
+    std::string add_to_symbol_table(const std::string &identifier, Type type); /**< returns the name of the variable in the IR */
     void add_arg_to_symbol_table(const std::string &name, Type type);
     std::string create_new_tempvar(Type type);
     int get_var_index(const std::string &name) const;
     Type get_var_type(const std::string &name) const;
     bool is_declared(const std::string &name) const;
+    void enter_scope(); /**< of a compound statement */
+    void exit_scope();
+    std::string lookup(const std::string &identifier) const; /**< name in the IR of the variable or function identifier in scope, empty if undeclared */
+    bool is_declared_in_scope(const std::string &identifier) const;
     Type get_max_type(const std::string &lhs, const std::string &rhs) const;
     std::string get_last_var_name() const;
     int get_nb_parameters() const;
+    int get_nb_temporaries() const; /**< created by create_new_tempvar() */
     bool is_initialized(const std::string &symbol_name) const;
     void initialize(const std::string &symbol_name);
     void set_used(const std::string &symbol_name);
@@ -237,24 +431,73 @@ public:
     const SymbolProperties& get_symbol_properties(const std::string &symbol_name) const;
     SymbolProperties& get_symbol_properties(const std::string &symbol_name);
 
+    // operands of the instructions
+    uint32_t intern_operand(const std::string &name); /**< id of the operand called name, added on its first use */
+    const IROperand& get_operand(uint32_t id) const;
+
+    // values of the expressions shared by several parents, see -fhash-cons
+    bool find_cached_value(const CProgASTExpression* expression, std::string &name); /**< temporary computed by expression in the current block, if none of the variables it read was written since */
+    void cache_value(const CProgASTExpression* expression, const std::string &name, size_t first_read); /**< the variables read by expression are those logged from first_read */
+    void log_read(const std::string &name); /**< of a variable by an identifier */
+    size_t get_nb_reads() const; /**< logged so far */
+    void invalidate_cached_values(const std::string &name); /**< once the variable name is written */
+    void invalidate_cached_values(); /**< all of them, once the scope changes the meaning of the identifiers */
+
     void print_debug_infos() const;
     void print_debug_infos_variables() const;
 
-    const CProgASTFuncdef* ast; /**< The AST this CFG comes from */
+    // static profile, computed on demand
+    double get_block_frequency(const BasicBlock* bb); /**< estimated executions of bb for one call of the function */
+    double get_edge_probability(const BasicBlock* from, const BasicBlock* to); /**< probability of going to the successor to once in from */
+    double get_edge_frequency(const BasicBlock* from, const BasicBlock* to);
+    void invalidate_analyses(); /**< must be called once blocks or edges have been modified outside of the methods of the CFG */
+    void print_block_frequencies();
+    void layout_unlikely_blocks(); /**< moves the blocks only reached through a branch weighted by __builtin_expect after the others */
+
+    const CProgASTFuncdef* ast; /**< The AST this CFG comes from, freed once the IR is built */
 
     std::string get_name();
 
     // basic block management
     std::string new_BB_name();
     BasicBlock* get_last_bb();
+    BasicBlock* get_entry_bb();
+    const std::vector<BasicBlock*>& get_bbs() const;
+    BasicBlock* clone_bb(const BasicBlock* bb); /**< copy of bb with a new label, not yet part of the layout */
+    void insert_bb_after(const BasicBlock* position, BasicBlock* bb);
+    void replace_bb(const BasicBlock* old_bb, BasicBlock* new_bb); /**< new_bb takes the place of old_bb in the layout */
+    void insert_bb_before(const BasicBlock* position, BasicBlock* bb);
+    void remove_bb(BasicBlock* bb); /**< removes bb from the layout */
     BasicBlock* current_bb;
+    SourcePosition current_position; /**< of the statement being lowered, given to the new instructions */
+    SourcePosition definition_position; /**< of the function definition */
 
 protected:
+    int get_instrument_frame_index() const; /**< of the slots used by -finstrument-functions */
+    void resolve_operand(IROperand &operand) const; /**< kind, type and slot of the operand from its name */
+    void update_operand(const std::string &name); /**< resolves the operand again once name is declared */
+
     int nextBBnumber; /**< just for naming */
     std::string function_name;
     TableOfSymbols symbols;
 
+    Arena bb_arena;     /**< of the blocks, freed with the CFG */
+    Arena instr_arena;  /**< of the instructions, packed together, freed with the CFG */
     std::vector <BasicBlock*> bbs; /**< all the basic blocks of this CFG*/
+    std::vector <BasicBlock*> cold_bbs; /**< blocks of bbs that gen_asm() leaves to gen_asm_cold_blocks() */
+    BlockFrequency* block_frequency; /**< nullptr until requested */
+    SourcePosition emitted_position; /**< of the last .loc directive */
+    mutable size_t epilogue_size; /**< cached by get_epilogue_size(), 0 until then */
+    std::deque<IROperand> operands; /**< indexed by the ids kept by the instructions, never moved */
+    std::vector<uint32_t> operand_ids; /**< indexed by the StringPool id of the name, StringPool::NOT_FOUND if not interned */
+
+    struct CachedValue {
+        const BasicBlock* bb; /**< where the temporary was computed */
+        std::string name;
+        std::vector<uint32_t> reads; /**< StringPool ids of the variables the expression read */
+    };
+    std::unordered_map<const CProgASTExpression*, CachedValue> cached_values;
+    std::vector<uint32_t> read_log; /**< StringPool ids of the variables read since the last invalidation of all the values */
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -266,11 +509,15 @@ public :
     IR(Writer &writer, const std::string &filename);
     ~IR();
     void add_cfg(CFG* cfg);
+    const std::vector<CFG*>& get_cfgs() const;
     void gen_asm();
     void print_debug_infos() const;
+    void print_block_frequencies() const;
 
     TableOfSymbols global_symbols;
 private :
+    void gen_asm_instrument_functions_runtime(); /**< records of the functions and flat profile printed at exit */
+
     Writer &writer;
     std::string filename;
     std::vector<CFG*> cfgs;
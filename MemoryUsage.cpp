@@ -0,0 +1,135 @@
+// ------------------------------------------------------------- Project Headers
+#include "MemoryUsage.h"
+
+// ---------------------------------------------------------- C++ System Headers
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+#include <sys/resource.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// class MemoryUsage                                                          //
+////////////////////////////////////////////////////////////////////////////////
+
+bool MemoryUsage::enabled = false;
+size_t MemoryUsage::nb_allocations = 0;
+size_t MemoryUsage::allocated_bytes = 0;
+size_t MemoryUsage::live_bytes = 0;
+size_t MemoryUsage::peak_bytes = 0;
+
+// ----------------------------------------------------- Public Member Functions
+void MemoryUsage::enable()
+{
+    enabled = true;
+}
+
+bool MemoryUsage::is_enabled()
+{
+    return enabled;
+}
+
+size_t MemoryUsage::get_nb_allocations()
+{
+    return nb_allocations;
+}
+
+size_t MemoryUsage::get_allocated_bytes()
+{
+    return allocated_bytes;
+}
+
+size_t MemoryUsage::get_live_bytes()
+{
+    return live_bytes;
+}
+
+size_t MemoryUsage::get_peak_bytes()
+{
+    return peak_bytes;
+}
+
+void MemoryUsage::set_peak_bytes(size_t bytes)
+{
+    peak_bytes = bytes;
+}
+
+size_t MemoryUsage::get_peak_resident_bytes()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return static_cast<size_t>(usage.ru_maxrss) * 1024; // kilobytes on Linux
+}
+
+void MemoryUsage::count_allocation(void* pointer)
+{
+    if (!enabled || !pointer)
+        return;
+    // the usable size is known again when the block is freed, without a header
+    size_t bytes = malloc_usable_size(pointer);
+    ++nb_allocations;
+    allocated_bytes += bytes;
+    live_bytes += bytes;
+    if (live_bytes > peak_bytes)
+        peak_bytes = live_bytes;
+}
+
+void MemoryUsage::count_deallocation(void* pointer)
+{
+    if (!enabled || !pointer)
+        return;
+    // blocks allocated before enable() were not counted
+    size_t bytes = malloc_usable_size(pointer);
+    live_bytes = bytes < live_bytes ? live_bytes - bytes : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Replaced global allocation functions                                       //
+////////////////////////////////////////////////////////////////////////////////
+
+void* operator new(size_t size)
+{
+    void* pointer = std::malloc(size ? size : 1);
+    if (!pointer)
+        throw std::bad_alloc();
+    MemoryUsage::count_allocation(pointer);
+    return pointer;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    void* pointer = std::malloc(size ? size : 1);
+    MemoryUsage::count_allocation(pointer);
+    return pointer;
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    MemoryUsage::count_deallocation(pointer);
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+    operator delete(pointer);
+}
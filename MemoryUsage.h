@@ -0,0 +1,36 @@
+#pragma once
+
+// ---------------------------------------------------------- C++ System Headers
+#include <cstddef>
+
+////////////////////////////////////////////////////////////////////////////////
+// class MemoryUsage                                                          //
+////////////////////////////////////////////////////////////////////////////////
+
+/* Heap allocations of the compiler, for -fmem-report. The global operator
+     new and operator delete are replaced to count the allocations and the
+     bytes allocated, freed and still in use, once enable() has been called.
+     TimeReport reads these counters at the start and at the end of each
+     phase, along with the peak resident memory of the process.
+*/
+class MemoryUsage {
+public:
+    // ------------------------------------------------- Public Member Functions
+    static void enable();
+    static bool is_enabled();
+    static size_t get_nb_allocations();
+    static size_t get_allocated_bytes(); /**< since enable(), freed or not */
+    static size_t get_live_bytes();      /**< allocated since enable() and not freed yet */
+    static size_t get_peak_bytes();      /**< highest live bytes since the last set_peak_bytes() */
+    static void set_peak_bytes(size_t bytes);
+    static size_t get_peak_resident_bytes(); /**< of the process since it started, 0 if unknown */
+
+    static void count_allocation(void* pointer); /**< for the replaced operator new */
+    static void count_deallocation(void* pointer); /**< for the replaced operator delete */
+private:
+    static bool enabled;
+    static size_t nb_allocations;
+    static size_t allocated_bytes;
+    static size_t live_bytes;
+    static size_t peak_bytes;
+};
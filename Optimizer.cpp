@@ -0,0 +1,1251 @@
+// ------------------------------------------------------------- Project Headers
+#include "Optimizer.h"
+#include "Analysis.h"
+#include "IR.h"
+#include "Options.h"
+#include "Statistics.h"
+#include "TimeReport.h"
+
+// ---------------------------------------------------------- C++ System Headers
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// class CFGPass                                                              //
+////////////////////////////////////////////////////////////////////////////////
+
+// -------------------------------------------------- Protected Member Functions
+std::map<BasicBlock*, BasicBlock*> CFGPass::clone_blocks(CFG* cfg, const std::vector<BasicBlock*> &blocks)
+{
+    std::map<BasicBlock*, BasicBlock*> clones;
+    for (BasicBlock* bb : blocks)
+    {
+        clones[bb] = cfg->clone_bb(bb);
+    }
+    for (auto &clone : clones)
+    {
+        BasicBlock* bb = clone.second;
+        if (clones.count(bb->exit_true))
+            bb->exit_true = clones[bb->exit_true];
+        if (clones.count(bb->exit_false))
+            bb->exit_false = clones[bb->exit_false];
+    }
+    return clones;
+}
+
+size_t CFGPass::count_instrs(const std::vector<BasicBlock*> &blocks)
+{
+    size_t count = 0;
+    for (const BasicBlock* bb : blocks)
+    {
+        count += bb->instrs.size();
+    }
+    return count;
+}
+
+bool CFGPass::remove_unreachable_blocks(CFG* cfg)
+{
+    LoopInfo loop_info(cfg);
+    std::vector<BasicBlock*> unreachable;
+    for (BasicBlock* bb : cfg->get_bbs())
+    {
+        // the exit block holds the epilogue, it stays even if every path returns
+        if (!loop_info.is_reachable(bb) && bb != cfg->get_last_bb())
+            unreachable.push_back(bb);
+    }
+    for (BasicBlock* bb : unreachable)
+    {
+        cfg->remove_bb(bb);
+    }
+    Statistics::add(cfg->get_name(), "removed-blocks", unreachable.size());
+    return !unreachable.empty();
+}
+
+bool CFGPass::get_branch_arms(CFG* cfg, BasicBlock* bb, std::vector<BasicBlock*> &arms, BasicBlock* &join)
+{
+    if (!bb->is_conditional())
+        return false;
+
+    // a triangle, with one arm going to the join block, or a diamond with two
+    BasicBlock* on_true = bb->exit_true;
+    BasicBlock* on_false = bb->exit_false;
+    if (on_true->exit_false == nullptr && on_true->exit_true == on_false)
+    {
+        join = on_false;
+        arms = {on_true};
+    }
+    else if (on_false->exit_false == nullptr && on_false->exit_true == on_true)
+    {
+        join = on_true;
+        arms = {on_false};
+    }
+    else if (on_true != on_false && on_true->exit_false == nullptr && on_false->exit_false == nullptr
+             && on_true->exit_true != nullptr && on_true->exit_true == on_false->exit_true)
+    {
+        join = on_true->exit_true;
+        arms = {on_true, on_false};
+    }
+    else
+        return false;
+    for (BasicBlock* other : cfg->get_bbs())
+    {
+        for (BasicBlock* arm : arms)
+        {
+            if (arm == bb || arm == join || (other != bb && (other->exit_true == arm || other->exit_false == arm)))
+                return false;
+        }
+    }
+    return true;
+}
+
+std::string CFGPass::gen_constant(BasicBlock* bb, int64_t value)
+{
+    std::string tmp_name = bb->cfg->create_new_tempvar(Type::INT_64);
+    bb->add_IRInstr(IRInstr::ldconst, Type::INT_64, {tmp_name, std::to_string(value)});
+    return tmp_name;
+}
+
+std::string CFGPass::gen_operation(BasicBlock* bb, IRInstr::Operation op, Type type, const std::vector<std::string> &operands)
+{
+    std::string tmp_name = bb->cfg->create_new_tempvar(type);
+    std::vector<std::string> params{tmp_name};
+    params.insert(params.end(), operands.begin(), operands.end());
+    bb->add_IRInstr(op, type, params);
+    return tmp_name;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class Optimizer                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+// ---------------------------------------------------- Constructor / Destructor
+Optimizer::Optimizer(const Options &options)
+{
+    if (options.optimisation)
+    {
+        passes.push_back(new LoopRotation());
+        passes.push_back(new IdiomRecognition());
+        passes.push_back(new LoopUnswitching());
+        passes.push_back(new LoopDeletion());
+        passes.push_back(new IfConversion());
+    }
+}
+
+Optimizer::~Optimizer()
+{
+    for (CFGPass* pass : passes)
+    {
+        delete pass;
+    }
+}
+
+// ----------------------------------------------------- Public Member Functions
+void Optimizer::run(IR& ir)
+{
+    for (CFG* cfg : ir.get_cfgs())
+    {
+        PhaseTimer timer("optimization", cfg->get_name());
+        for (CFGPass* pass : passes)
+        {
+            PhaseTimer pass_timer(pass->get_name(), cfg->get_name());
+            if (pass->run(cfg))
+                cfg->invalidate_analyses();
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class LoopRotation : public CFGPass                                        //
+////////////////////////////////////////////////////////////////////////////////
+
+// ----------------------------------------------------- Public Member Functions
+std::string LoopRotation::get_name() const
+{
+    return "loop-rotation";
+}
+
+bool LoopRotation::run(CFG* cfg)
+{
+    bool changed = false;
+    bool rotated = true;
+    // a rotation invalidates the analysis: it is computed again after each one
+    while (rotated)
+    {
+        rotated = false;
+        LoopInfo loop_info(cfg);
+        for (const Loop &loop : loop_info.get_loops())
+        {
+            if (rotate(cfg, loop))
+            {
+                Statistics::add(cfg->get_name(), "loop-rotation.rotated-loops");
+                rotated = changed = true;
+                break;
+            }
+        }
+    }
+    return changed;
+}
+
+// ---------------------------------------------------- Private Member Functions
+bool LoopRotation::rotate(CFG* cfg, const Loop &loop)
+{
+    BasicBlock* header = loop.header;
+    if (loop.latches.size() != 1)
+        return false;
+    BasicBlock* latch = loop.latches.front();
+    if (latch->exit_false != nullptr || latch->exit_true != header)
+        return false;
+
+    // the header region computes the condition: it goes from the header to the only exiting block
+    std::set<BasicBlock*> region{header};
+    std::vector<BasicBlock*> worklist{header};
+    BasicBlock* exiting = nullptr;
+    while (!worklist.empty())
+    {
+        BasicBlock* bb = worklist.back();
+        worklist.pop_back();
+        if (bb->is_conditional() && loop.contains(bb->exit_true) != loop.contains(bb->exit_false))
+        {
+            if (exiting)
+                return false;
+            exiting = bb;
+            continue;
+        }
+        for (BasicBlock* successor : bb->get_successors())
+        {
+            if (!loop.contains(successor) || successor == header || successor == latch)
+                return false;
+            if (region.insert(successor).second)
+                worklist.push_back(successor);
+        }
+    }
+    if (!exiting)
+        return false;
+    BasicBlock* body = loop.contains(exiting->exit_true) ? exiting->exit_true : exiting->exit_false;
+    if (region.count(body))
+        return false;
+
+    // the region is only entered through its header, from the outside or from the latch
+    std::vector<BasicBlock*> region_blocks;
+    for (BasicBlock* bb : loop.blocks)
+    {
+        if (region.count(bb))
+            region_blocks.push_back(bb);
+    }
+    if (count_instrs(region_blocks) > MAX_HEADER_SIZE)
+        return false;
+    // unreachable blocks are checked too, they must not keep pointers to the deleted blocks
+    std::vector<BasicBlock*> entering_blocks;
+    for (BasicBlock* bb : cfg->get_bbs())
+    {
+        if (region.count(bb))
+            continue;
+        for (BasicBlock* successor : bb->get_successors())
+        {
+            if (!region.count(successor))
+                continue;
+            if (successor != header || (loop.contains(bb) && bb != latch))
+                return false;
+            if (bb != latch)
+                entering_blocks.push_back(bb);
+        }
+    }
+
+    std::map<BasicBlock*, BasicBlock*> guard = clone_blocks(cfg, region_blocks);
+    std::map<BasicBlock*, BasicBlock*> bottom_test = clone_blocks(cfg, region_blocks);
+    for (BasicBlock* bb : entering_blocks)
+    {
+        bb->replace_successor(header, guard[header]);
+    }
+    latch->replace_successor(header, bottom_test[header]);
+
+    // the bottom test is placed right after the latch, and the guard where the header was
+    const BasicBlock* position = latch;
+    for (BasicBlock* bb : region_blocks)
+    {
+        cfg->insert_bb_after(position, bottom_test[bb]);
+        position = bottom_test[bb];
+    }
+    for (BasicBlock* bb : region_blocks)
+    {
+        cfg->replace_bb(bb, guard[bb]);
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class LoopUnswitching : public CFGPass                                     //
+////////////////////////////////////////////////////////////////////////////////
+
+// ----------------------------------------------------- Public Member Functions
+std::string LoopUnswitching::get_name() const
+{
+    return "loop-unswitching";
+}
+
+bool LoopUnswitching::run(CFG* cfg)
+{
+    bool changed = false;
+    bool unswitched = true;
+    size_t growth = 0;
+    while (unswitched)
+    {
+        unswitched = false;
+        LoopInfo loop_info(cfg);
+        for (const Loop &loop : loop_info.get_loops())
+        {
+            if (unswitch(cfg, loop, growth))
+            {
+                Statistics::add(cfg->get_name(), "loop-unswitching.unswitched-loops");
+                unswitched = changed = true;
+                break;
+            }
+        }
+    }
+    // each copy of the loop keeps the blocks of the branch it no longer takes
+    if (changed)
+        remove_unreachable_blocks(cfg);
+    return changed;
+}
+
+// ---------------------------------------------------- Private Member Functions
+bool LoopUnswitching::unswitch(CFG* cfg, const Loop &loop, size_t &growth)
+{
+    BasicBlock* header = loop.header;
+    const size_t size = count_instrs(loop.blocks);
+    if (size > MAX_LOOP_SIZE || growth + size > MAX_GROWTH || header == cfg->get_entry_bb())
+        return false;
+
+    // the loop is only entered through its header
+    std::vector<BasicBlock*> entering_blocks;
+    for (BasicBlock* bb : cfg->get_bbs())
+    {
+        if (loop.contains(bb))
+            continue;
+        for (BasicBlock* successor : bb->get_successors())
+        {
+            if (!loop.contains(successor))
+                continue;
+            if (successor != header)
+                return false;
+            entering_blocks.push_back(bb);
+        }
+    }
+
+    for (BasicBlock* bb : loop.blocks)
+    {
+        // branches leaving the loop are left to the loop rotation
+        if (!bb->is_conditional() || !loop.contains(bb->exit_true) || !loop.contains(bb->exit_false))
+            continue;
+        std::vector<const IRInstr*> chain;
+        if (!find_invariant_condition(loop, bb, chain))
+            continue;
+
+        BasicBlock* test = cfg->create_bb();
+        for (const IRInstr* instr : chain)
+        {
+            test->instrs.push_back(cfg->create_IRInstr(test, *instr));
+        }
+        test->instrs.push_back(cfg->create_IRInstr(test, *bb->instrs.back()));
+
+        // the copy is the loop running when the condition is true
+        std::map<BasicBlock*, BasicBlock*> copy = clone_blocks(cfg, loop.blocks);
+        for (BasicBlock* entering : entering_blocks)
+        {
+            entering->replace_successor(header, test);
+        }
+        test->exit_true = copy[header];
+        test->exit_false = header;
+        remove_branch(copy[bb], copy[bb]->exit_true);
+        remove_branch(bb, bb->exit_false);
+
+        cfg->insert_bb_before(loop.blocks.front(), test);
+        const BasicBlock* position = loop.blocks.back();
+        for (BasicBlock* original : loop.blocks)
+        {
+            cfg->insert_bb_after(position, copy[original]);
+            position = copy[original];
+        }
+        growth += size + test->instrs.size();
+        return true;
+    }
+    return false;
+}
+
+bool LoopUnswitching::find_invariant_condition(const Loop &loop, const BasicBlock* bb, std::vector<const IRInstr*> &chain)
+{
+    std::map<std::string, size_t> writes;
+    for (const BasicBlock* block : loop.blocks)
+    {
+        for (const IRInstr* instr : block->instrs)
+        {
+            for (const std::string &var : instr->get_written_vars())
+                ++writes[var];
+        }
+    }
+
+    // walks back from the cmp_null, collecting the temporaries computing the condition
+    std::set<std::string> needed{bb->instrs.back()->get_param(0)};
+    for (auto it = bb->instrs.rbegin()+1; it != bb->instrs.rend(); ++it)
+    {
+        const IRInstr* instr = *it;
+        std::vector<std::string> written = instr->get_written_vars();
+        if (written.size() != 1 || !needed.count(written[0]))
+            continue;
+        // the copy before the loop must have no visible effect and must not trap
+        switch (instr->get_operation())
+        {
+            case IRInstr::Operation::ldconst:
+            case IRInstr::Operation::add:
+            case IRInstr::Operation::sub:
+            case IRInstr::Operation::mul:
+            case IRInstr::Operation::neg:
+            case IRInstr::Operation::rmem:
+            case IRInstr::Operation::cmp_eq:
+            case IRInstr::Operation::cmp_lt:
+            case IRInstr::Operation::cmp_le:
+            case IRInstr::Operation::cmp_gt:
+            case IRInstr::Operation::cmp_ge:
+            case IRInstr::Operation::cmp_ne:
+            case IRInstr::Operation::band:
+            case IRInstr::Operation::bor:
+            case IRInstr::Operation::bxor:
+            case IRInstr::Operation::bnot:
+            case IRInstr::Operation::shl:
+            case IRInstr::Operation::lnot:
+                break;
+            default:
+                return false;
+        }
+        if (written[0][0] != '!' || writes[written[0]] != 1)
+            return false;
+        needed.erase(written[0]);
+        for (const std::string &var : instr->get_read_vars())
+            needed.insert(var);
+        chain.insert(chain.begin(), instr);
+    }
+
+    // what remains is read before the block: it must not change in the loop
+    for (const std::string &var : needed)
+    {
+        if (writes.count(var))
+            return false;
+    }
+    return true;
+}
+
+void LoopUnswitching::remove_branch(BasicBlock* bb, BasicBlock* target)
+{
+    bb->instrs.pop_back();
+    bb->exit_true = target;
+    bb->exit_false = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class LoopDeletion : public CFGPass                                        //
+////////////////////////////////////////////////////////////////////////////////
+
+// ----------------------------------------------------- Public Member Functions
+std::string LoopDeletion::get_name() const
+{
+    return "loop-deletion";
+}
+
+bool LoopDeletion::run(CFG* cfg)
+{
+    bool changed = false;
+    bool deleted = true;
+    // once an inner loop is deleted, the outer one may become a candidate
+    while (deleted)
+    {
+        deleted = false;
+        LoopInfo loop_info(cfg);
+        ScalarEvolution scalar_evolution(loop_info);
+        for (const Loop &loop : loop_info.get_loops())
+        {
+            const LoopEvolution* evolution = scalar_evolution.get_evolution(loop);
+            if (evolution && replace(cfg, loop, *evolution))
+            {
+                Statistics::add(cfg->get_name(), "loop-deletion.deleted-loops");
+                deleted = changed = true;
+                break;
+            }
+        }
+    }
+    return changed;
+}
+
+// ---------------------------------------------------- Private Member Functions
+bool LoopDeletion::replace(CFG* cfg, const Loop &loop, const LoopEvolution &evolution)
+{
+    if (!evolution.is_removable() || loop.header == cfg->get_entry_bb() || !fits_in_immediates(evolution))
+        return false;
+
+    // the closed form is attributed to the condition of the loop it replaces
+    cfg->current_position = loop.latches.front()->instrs.back()->get_position();
+    BasicBlock* bb = cfg->create_bb();
+    std::string backedge_count = gen_affine(bb, evolution.distance);
+    if (evolution.clamped)
+    {
+        std::string positive = gen_binary(bb, IRInstr::cmp_gt, backedge_count, gen_constant(bb, 0));
+        if (evolution.stride != 1)
+        {
+            backedge_count = gen_binary(bb, IRInstr::add, backedge_count, gen_constant(bb, evolution.stride - 1));
+            backedge_count = gen_binary(bb, IRInstr::div, backedge_count, gen_constant(bb, evolution.stride));
+        }
+        backedge_count = gen_binary(bb, IRInstr::mul, backedge_count, positive);
+    }
+    std::string iterations = gen_binary(bb, IRInstr::add, backedge_count, gen_constant(bb, 1));
+
+    // n*(n-1)/2 computed as (n/2) * (n-1 + n%2), which does not overflow
+    std::string triangular;
+    for (const auto &recurrence : evolution.recurrences)
+    {
+        if (recurrence.second.step2 == 0 || !triangular.empty())
+            continue;
+        std::string half = gen_binary(bb, IRInstr::div, iterations, gen_constant(bb, 2));
+        std::string odd = gen_binary(bb, IRInstr::band, iterations, gen_constant(bb, 1));
+        std::string even = gen_binary(bb, IRInstr::sub, iterations, gen_constant(bb, 1));
+        triangular = gen_binary(bb, IRInstr::mul, half, gen_binary(bb, IRInstr::add, even, odd));
+    }
+
+    // every final value is computed before the variables are written
+    std::map<std::string, std::string> final_values;
+    for (const auto &recurrence : evolution.recurrences)
+    {
+        final_values[recurrence.first] = gen_recurrence(bb, recurrence.second, iterations, triangular);
+    }
+    for (const auto &final_value : final_values)
+    {
+        bb->add_IRInstr(IRInstr::wmem, cfg->get_var_type(final_value.first), {final_value.first, final_value.second});
+    }
+    cfg->current_position = SourcePosition();
+    bb->exit_true = evolution.exit;
+
+    for (BasicBlock* predecessor : cfg->get_bbs())
+    {
+        if (!loop.contains(predecessor))
+            predecessor->replace_successor(loop.header, bb);
+    }
+    cfg->insert_bb_before(loop.blocks.front(), bb);
+    remove_unreachable_blocks(cfg);
+    return true;
+}
+
+bool LoopDeletion::fits_in_immediates(const LoopEvolution &evolution)
+{
+    auto fits = [](int64_t value) -> bool
+        {
+            return value >= INT32_MIN && value <= INT32_MAX;
+        };
+    auto fits_expr = [&fits](const AffineExpr &expr) -> bool
+        {
+            for (const auto &term : expr.terms)
+            {
+                if (!fits(term.second))
+                    return false;
+            }
+            return fits(expr.constant);
+        };
+
+    if (!fits_expr(evolution.distance) || !fits(evolution.stride))
+        return false;
+    for (const auto &recurrence : evolution.recurrences)
+    {
+        if (!fits_expr(recurrence.second.start) || !fits_expr(recurrence.second.step) || !fits(recurrence.second.step2))
+            return false;
+    }
+    return true;
+}
+
+std::string LoopDeletion::gen_binary(BasicBlock* bb, IRInstr::Operation op, const std::string &lhs, const std::string &rhs)
+{
+    return gen_operation(bb, op, Type::INT_64, {lhs, rhs});
+}
+
+std::string LoopDeletion::gen_affine(BasicBlock* bb, const AffineExpr &expr)
+{
+    std::string result;
+    for (const auto &term : expr.terms)
+    {
+        // the variables are widened first: the closed forms do not fit in their type
+        std::string value = term.first;
+        if (bb->cfg->get_var_type(value) < Type::INT_64)
+        {
+            value = bb->cfg->create_new_tempvar(Type::INT_64);
+            bb->add_IRInstr(IRInstr::rmem, Type::INT_64, {value, term.first});
+        }
+        if (term.second != 1)
+            value = gen_binary(bb, IRInstr::mul, value, gen_constant(bb, term.second));
+        result = result.empty() ? value : gen_binary(bb, IRInstr::add, result, value);
+    }
+    if (result.empty())
+        return gen_constant(bb, expr.constant);
+    if (expr.constant != 0)
+        result = gen_binary(bb, IRInstr::add, result, gen_constant(bb, expr.constant));
+    return result;
+}
+
+std::string LoopDeletion::gen_recurrence(BasicBlock* bb, const Recurrence &recurrence, const std::string &iterations, const std::string &triangular)
+{
+    std::string result = gen_affine(bb, recurrence.start);
+    if (recurrence.kind == Recurrence::MUL)
+    {
+        // x86 masks the shift count: shifting by 64 bits or more gives 0
+        std::string count = gen_binary(bb, IRInstr::mul, iterations, gen_constant(bb, recurrence.shift));
+        std::string in_range = gen_binary(bb, IRInstr::cmp_lt, count, gen_constant(bb, 64));
+        count = gen_binary(bb, IRInstr::band, count, gen_constant(bb, 63));
+        result = gen_binary(bb, IRInstr::shl, result, count);
+        return gen_binary(bb, IRInstr::mul, result, in_range);
+    }
+    if (!recurrence.step.is_constant() || recurrence.step.constant != 0)
+        result = gen_binary(bb, IRInstr::add, result, gen_binary(bb, IRInstr::mul, gen_affine(bb, recurrence.step), iterations));
+    if (recurrence.step2 != 0)
+        result = gen_binary(bb, IRInstr::add, result, gen_binary(bb, IRInstr::mul, gen_constant(bb, recurrence.step2), triangular));
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class IdiomRecognition : public CFGPass                                    //
+////////////////////////////////////////////////////////////////////////////////
+
+// ----------------------------------------------------- Public Member Functions
+std::string IdiomRecognition::get_name() const
+{
+    return "idiom-recognition";
+}
+
+bool IdiomRecognition::run(CFG* cfg)
+{
+    bool changed = false;
+    bool recognized = true;
+    while (recognized)
+    {
+        recognized = false;
+        LoopInfo loop_info(cfg);
+        for (const Loop &loop : loop_info.get_loops())
+        {
+            if (recognize_loop(cfg, loop))
+            {
+                Statistics::add(cfg->get_name(), "idiom-recognition.loops");
+                recognized = changed = true;
+                break;
+            }
+        }
+    }
+    // the bodies of the loops and the arms of the branches are left behind
+    if (changed)
+        remove_unreachable_blocks(cfg);
+
+    bool selected = false;
+    for (BasicBlock* bb : cfg->get_bbs())
+    {
+        if (recognize_select(cfg, bb))
+        {
+            Statistics::add(cfg->get_name(), "idiom-recognition.selects");
+            selected = changed = true;
+        }
+    }
+    if (selected)
+        remove_unreachable_blocks(cfg);
+    return changed;
+}
+
+// ---------------------------------------------------- Private Member Functions
+bool IdiomRecognition::recognize_select(CFG* cfg, BasicBlock* bb)
+{
+    BasicBlock* join;
+    std::vector<BasicBlock*> arms;
+    if (!get_branch_arms(cfg, bb, arms, join))
+        return false;
+    BasicBlock* on_true = bb->exit_true;
+    BasicBlock* on_false = bb->exit_false;
+
+    // the arms assign the same variable, a copy of a variable or its opposite
+    std::string var;
+    std::map<const BasicBlock*, Term> assigned;
+    for (BasicBlock* arm : arms)
+    {
+        std::map<std::string, Term> values;
+        if (!evaluate({arm}, values))
+            return false;
+        for (const auto &value : values)
+        {
+            if (value.first[0] == '!')
+                continue;
+            if (!var.empty() && value.first != var)
+                return false;
+            var = value.first;
+            assigned[arm] = value.second;
+        }
+    }
+    if (var.empty())
+        return false;
+    Term if_true = assigned.count(on_true) ? assigned[on_true] : Term::variable(var);
+    Term if_false = assigned.count(on_false) ? assigned[on_false] : Term::variable(var);
+
+    IRInstr::Operation comparison;
+    Term lhs, rhs;
+    get_condition(bb, comparison, lhs, rhs);
+    if (comparison == IRInstr::Operation::cmp_gt || comparison == IRInstr::Operation::cmp_ge)
+    {
+        comparison = mirror(comparison);
+        std::swap(lhs, rhs);
+    }
+    if ((comparison != IRInstr::Operation::cmp_lt && comparison != IRInstr::Operation::cmp_le)
+        || lhs.kind == Term::OPERATION || lhs.kind == Term::UNKNOWN
+        || rhs.kind == Term::OPERATION || rhs.kind == Term::UNKNOWN)
+        return false;
+
+    // lhs < rhs ? if_true : if_false
+    IRInstr::Operation op;
+    std::vector<std::string> operands;
+    Type type;
+    if (lhs.kind == Term::VARIABLE && rhs.kind == Term::VARIABLE && if_true == lhs && if_false == rhs)
+        op = IRInstr::min;
+    else if (lhs.kind == Term::VARIABLE && rhs.kind == Term::VARIABLE && if_true == rhs && if_false == lhs)
+        op = IRInstr::max;
+    else if (lhs.kind == Term::VARIABLE && rhs == Term::constant(0) && if_false == lhs && if_true == Term::operation(IRInstr::neg, {lhs}))
+        op = IRInstr::abs;
+    else if (rhs.kind == Term::VARIABLE && lhs == Term::constant(0) && if_true == rhs && if_false == Term::operation(IRInstr::neg, {rhs}))
+        op = IRInstr::abs;
+    else
+        return false;
+    if (op == IRInstr::abs)
+    {
+        const std::string &operand = lhs.kind == Term::VARIABLE ? lhs.name : rhs.name;
+        operands = {operand};
+        type = cfg->get_var_type(operand);
+    }
+    else
+    {
+        operands = {lhs.name, rhs.name};
+        type = cfg->get_max_type(lhs.name, rhs.name);
+    }
+
+    // the comparison is only used by the branch, which the operation replaces
+    const std::string condition = bb->instrs.back()->get_param(0);
+    cfg->current_position = bb->instrs.back()->get_position();
+    bb->instrs.pop_back();
+    if (!bb->instrs.empty() && condition[0] == '!' && bb->instrs.back()->get_written_vars() == std::vector<std::string>{condition})
+    {
+        bb->instrs.pop_back();
+    }
+    std::string result = gen_operation(bb, op, type, operands);
+    bb->add_IRInstr(IRInstr::wmem, cfg->get_var_type(var), {var, result});
+    cfg->current_position = SourcePosition();
+    bb->exit_true = join;
+    bb->exit_false = nullptr;
+    return true;
+}
+
+bool IdiomRecognition::recognize_loop(CFG* cfg, const Loop &loop)
+{
+    std::vector<BasicBlock*> path = loop.get_path();
+    if (path.empty() || !path.back()->is_conditional() || loop.header == cfg->get_entry_bb())
+        return false;
+    BasicBlock* latch = path.back();
+    const bool continue_if_true = latch->exit_true == loop.header;
+    BasicBlock* exit = continue_if_true ? latch->exit_false : latch->exit_true;
+    if (loop.contains(exit))
+        return false;
+
+    // the latch only tests the condition, on the values left by the body
+    std::map<std::string, Term> values;
+    if (!evaluate({latch}, values))
+        return false;
+    for (const auto &value : values)
+    {
+        if (value.first[0] != '!')
+            return false;
+    }
+    IRInstr::Operation comparison;
+    Term lhs, rhs;
+    get_condition(latch, comparison, lhs, rhs);
+    if (!continue_if_true)
+        comparison = negate(comparison);
+    if (rhs != Term::constant(0))
+        return false;
+
+    // the loop is entered when the condition holds, it is a while loop
+    std::vector<BasicBlock*> entering_blocks;
+    for (BasicBlock* bb : cfg->get_bbs())
+    {
+        if (loop.contains(bb) || (bb->exit_true != loop.header && bb->exit_false != loop.header))
+            continue;
+        if (!bb->is_conditional() || (bb->exit_true == loop.header) != continue_if_true || bb->exit_true == bb->exit_false)
+            return false;
+        IRInstr::Operation guard_comparison;
+        Term guard_lhs, guard_rhs;
+        get_condition(bb, guard_comparison, guard_lhs, guard_rhs);
+        if (!continue_if_true)
+            guard_comparison = negate(guard_comparison);
+        if (guard_comparison != comparison || guard_lhs != lhs || guard_rhs != rhs)
+            return false;
+        entering_blocks.push_back(bb);
+    }
+
+    // the body updates a counter and the variable x tested by the condition
+    values.clear();
+    if (!evaluate(path, values))
+        return false;
+    std::vector<std::string> vars;
+    for (const auto &value : values)
+    {
+        if (value.first[0] != '!')
+            vars.push_back(value.first);
+    }
+    if (vars.size() != 2)
+        return false;
+    const Term one = Term::constant(1);
+    const Term two = Term::constant(2);
+    const Term zero = Term::constant(0);
+    for (size_t i=0; i<2; ++i)
+    {
+        const std::string &x = vars[i];
+        const std::string &counter = vars[1-i];
+        const Term x_term = Term::variable(x);
+        const Term counter_term = Term::variable(counter);
+        const Term &x_update = values[x];
+        const Term &counter_update = values[counter];
+
+        const bool halves = x_update == Term::operation(IRInstr::div, {x_term, two});
+        const bool doubles = is_commutative(x_update, IRInstr::mul, x_term, two) || x_update == Term::operation(IRInstr::add, {x_term, x_term});
+        const bool counts = is_commutative(counter_update, IRInstr::add, counter_term, one);
+        const bool counts_bits = counter_update.kind == Term::OPERATION && counter_update.op == IRInstr::add
+            && counter_update.operands.size() == 2
+            && ((counter_update.operands[0] == counter_term && is_commutative(counter_update.operands[1], IRInstr::band, x_term, one))
+                || (counter_update.operands[1] == counter_term && is_commutative(counter_update.operands[0], IRInstr::band, x_term, one)));
+        const bool while_not_zero = comparison == IRInstr::cmp_ne && lhs == x_term;
+        const bool while_positive = comparison == IRInstr::cmp_gt && lhs == x_term;
+        const bool while_even = comparison == IRInstr::cmp_eq
+            && (lhs == Term::operation(IRInstr::mod, {x_term, two}) || is_commutative(lhs, IRInstr::band, x_term, one));
+
+        cfg->current_position = latch->instrs.back()->get_position();
+        BasicBlock* bb = cfg->create_bb();
+        Type x_type = cfg->get_var_type(x);
+        std::string count;
+        std::string final_x;
+        if (while_not_zero && halves && counts_bits)
+        {
+            count = gen_operation(bb, IRInstr::popcnt, Type::INT_64, {gen_operation(bb, IRInstr::abs, x_type, {x})});
+            final_x = gen_constant(bb, 0);
+        }
+        else if (while_not_zero && halves && counts)
+        {
+            std::string leading_zeros = gen_operation(bb, IRInstr::lzcnt, Type::INT_64, {gen_operation(bb, IRInstr::abs, x_type, {x})});
+            count = gen_operation(bb, IRInstr::sub, Type::INT_64, {gen_constant(bb, types.at(x_type).size*8), leading_zeros});
+            final_x = gen_constant(bb, 0);
+        }
+        else if (while_positive && doubles && counts)
+        {
+            count = gen_operation(bb, IRInstr::lzcnt, Type::INT_64, {x});
+            final_x = gen_operation(bb, IRInstr::shl, x_type, {x, count});
+        }
+        else if (while_even && halves && counts)
+        {
+            count = gen_operation(bb, IRInstr::tzcnt, Type::INT_64, {x});
+            final_x = gen_operation(bb, IRInstr::sar, x_type, {x, count});
+        }
+        else
+        {
+            cfg->current_position = SourcePosition();
+            continue;
+        }
+        std::string final_counter = gen_operation(bb, IRInstr::add, Type::INT_64, {counter, count});
+        bb->add_IRInstr(IRInstr::wmem, cfg->get_var_type(counter), {counter, final_counter});
+        bb->add_IRInstr(IRInstr::wmem, x_type, {x, final_x});
+        cfg->current_position = SourcePosition();
+        bb->exit_true = exit;
+        for (BasicBlock* entering : entering_blocks)
+        {
+            entering->replace_successor(loop.header, bb);
+        }
+        cfg->insert_bb_before(loop.blocks.front(), bb);
+        return true;
+    }
+    return false;
+}
+
+bool IdiomRecognition::evaluate(const std::vector<BasicBlock*> &blocks, std::map<std::string, Term> &values)
+{
+    bool pure = true;
+    for (const BasicBlock* bb : blocks)
+    {
+        for (const IRInstr* instr : bb->instrs)
+        {
+            Term term;
+            switch (instr->get_operation())
+            {
+                case IRInstr::Operation::ldconst:
+                    term = Term::constant(instr->get_operand(1).value);
+                break;
+                case IRInstr::Operation::rmem:
+                case IRInstr::Operation::wmem:
+                    term = get_term(values, instr->get_param(1));
+                break;
+                case IRInstr::Operation::pre_pp:
+                    term = Term::operation(IRInstr::add, {get_term(values, instr->get_param(0)), Term::constant(1)});
+                break;
+                case IRInstr::Operation::pre_mm:
+                    term = Term::operation(IRInstr::sub, {get_term(values, instr->get_param(0)), Term::constant(1)});
+                break;
+                case IRInstr::Operation::neg:
+                case IRInstr::Operation::bnot:
+                case IRInstr::Operation::lnot:
+                case IRInstr::Operation::abs:
+                case IRInstr::Operation::popcnt:
+                case IRInstr::Operation::lzcnt:
+                case IRInstr::Operation::tzcnt:
+                    term = Term::operation(instr->get_operation(), {get_term(values, instr->get_param(1))});
+                break;
+                case IRInstr::Operation::add:
+                case IRInstr::Operation::sub:
+                case IRInstr::Operation::mul:
+                case IRInstr::Operation::div:
+                case IRInstr::Operation::mod:
+                case IRInstr::Operation::band:
+                case IRInstr::Operation::bor:
+                case IRInstr::Operation::bxor:
+                case IRInstr::Operation::shl:
+                case IRInstr::Operation::sar:
+                case IRInstr::Operation::min:
+                case IRInstr::Operation::max:
+                case IRInstr::Operation::cmp_eq:
+                case IRInstr::Operation::cmp_lt:
+                case IRInstr::Operation::cmp_le:
+                case IRInstr::Operation::cmp_gt:
+                case IRInstr::Operation::cmp_ge:
+                case IRInstr::Operation::cmp_ne:
+                    term = Term::operation(instr->get_operation(), {get_term(values, instr->get_param(1)), get_term(values, instr->get_param(2))});
+                break;
+                case IRInstr::Operation::cmp_null:
+                break;
+                default:
+                    pure = false;
+                break;
+            }
+            for (const std::string &var : instr->get_written_vars())
+            {
+                values[var] = term;
+            }
+        }
+    }
+    return pure;
+}
+
+IdiomRecognition::Term IdiomRecognition::get_term(const std::map<std::string, Term> &values, const std::string &var)
+{
+    auto it = values.find(var);
+    if (it != values.end())
+        return it->second;
+    // a temporary read before being written comes from another statement
+    if (var[0] == '!')
+        return Term();
+    return Term::variable(var);
+}
+
+void IdiomRecognition::get_condition(BasicBlock* bb, IRInstr::Operation &comparison, Term &lhs, Term &rhs)
+{
+    std::map<std::string, Term> values;
+    evaluate({bb}, values);
+    Term condition = get_term(values, bb->instrs.back()->get_param(0));
+    switch (condition.kind == Term::OPERATION ? condition.op : IRInstr::cmp_null)
+    {
+        case IRInstr::Operation::cmp_eq:
+        case IRInstr::Operation::cmp_lt:
+        case IRInstr::Operation::cmp_le:
+        case IRInstr::Operation::cmp_gt:
+        case IRInstr::Operation::cmp_ge:
+        case IRInstr::Operation::cmp_ne:
+            comparison = condition.op;
+            lhs = condition.operands[0];
+            rhs = condition.operands[1];
+        break;
+        case IRInstr::Operation::lnot:
+            comparison = IRInstr::cmp_eq;
+            lhs = condition.operands[0];
+            rhs = Term::constant(0);
+        break;
+        default:
+            comparison = IRInstr::cmp_ne;
+            lhs = condition;
+            rhs = Term::constant(0);
+        break;
+    }
+    if (lhs.kind == Term::CONSTANT && rhs.kind != Term::CONSTANT)
+    {
+        comparison = mirror(comparison);
+        std::swap(lhs, rhs);
+    }
+
+    // the variables are designated by their values at the end of bb
+    for (Term* operand : {&lhs, &rhs})
+    {
+        if (operand->kind == Term::VARIABLE && values.count(operand->name) && values[operand->name] != *operand)
+            *operand = Term();
+        for (const auto &value : values)
+        {
+            if (value.first[0] != '!' && value.second == *operand)
+                *operand = Term::variable(value.first);
+        }
+    }
+}
+
+IRInstr::Operation IdiomRecognition::negate(IRInstr::Operation comparison)
+{
+    switch (comparison)
+    {
+        case IRInstr::Operation::cmp_eq: return IRInstr::cmp_ne;
+        case IRInstr::Operation::cmp_ne: return IRInstr::cmp_eq;
+        case IRInstr::Operation::cmp_lt: return IRInstr::cmp_ge;
+        case IRInstr::Operation::cmp_le: return IRInstr::cmp_gt;
+        case IRInstr::Operation::cmp_gt: return IRInstr::cmp_le;
+        case IRInstr::Operation::cmp_ge: return IRInstr::cmp_lt;
+        default: return comparison;
+    }
+}
+
+IRInstr::Operation IdiomRecognition::mirror(IRInstr::Operation comparison)
+{
+    switch (comparison)
+    {
+        case IRInstr::Operation::cmp_lt: return IRInstr::cmp_gt;
+        case IRInstr::Operation::cmp_le: return IRInstr::cmp_ge;
+        case IRInstr::Operation::cmp_gt: return IRInstr::cmp_lt;
+        case IRInstr::Operation::cmp_ge: return IRInstr::cmp_le;
+        default: return comparison;
+    }
+}
+
+bool IdiomRecognition::is_commutative(const Term &term, IRInstr::Operation op, const Term &a, const Term &b)
+{
+    return term == Term::operation(op, {a, b}) || term == Term::operation(op, {b, a});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// struct IdiomRecognition::Term                                              //
+////////////////////////////////////////////////////////////////////////////////
+
+// ----------------------------------------------------------------- Constructor
+IdiomRecognition::Term::Term() :
+    kind(UNKNOWN), value(0), op(IRInstr::ldconst)
+{}
+
+// ----------------------------------------------------- Public Member Functions
+IdiomRecognition::Term IdiomRecognition::Term::variable(const std::string &name)
+{
+    Term term;
+    term.kind = VARIABLE;
+    term.name = name;
+    return term;
+}
+
+IdiomRecognition::Term IdiomRecognition::Term::constant(int64_t value)
+{
+    Term term;
+    term.kind = CONSTANT;
+    term.value = value;
+    return term;
+}
+
+IdiomRecognition::Term IdiomRecognition::Term::operation(IRInstr::Operation op, const std::vector<Term> &operands)
+{
+    Term term;
+    term.kind = OPERATION;
+    term.op = op;
+    term.operands = operands;
+    return term;
+}
+
+// -------------------------------------------------------- Overloaded Operators
+bool IdiomRecognition::Term::operator==(const Term &other) const
+{
+    if (kind != other.kind || kind == UNKNOWN)
+        return false;
+    switch (kind)
+    {
+        case VARIABLE:
+            return name == other.name;
+        case CONSTANT:
+            return value == other.value;
+        default:
+            return op == other.op && operands == other.operands;
+    }
+}
+
+bool IdiomRecognition::Term::operator!=(const Term &other) const
+{
+    return !(*this == other);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class IfConversion : public CFGPass                                        //
+////////////////////////////////////////////////////////////////////////////////
+
+// ----------------------------------------------------- Public Member Functions
+std::string IfConversion::get_name() const
+{
+    return "if-conversion";
+}
+
+bool IfConversion::run(CFG* cfg)
+{
+    bool changed = false;
+    for (BasicBlock* bb : cfg->get_bbs())
+    {
+        if (convert(cfg, bb))
+        {
+            Statistics::add(cfg->get_name(), "if-conversion.converted-branches");
+            changed = true;
+        }
+    }
+    if (changed)
+        remove_unreachable_blocks(cfg);
+    return changed;
+}
+
+// ---------------------------------------------------- Private Member Functions
+bool IfConversion::convert(CFG* cfg, BasicBlock* bb)
+{
+    BasicBlock* join;
+    std::vector<BasicBlock*> arms;
+    if (!get_branch_arms(cfg, bb, arms, join))
+        return false;
+
+    // the arms only compute the value of the same variable
+    std::string var;
+    std::map<const BasicBlock*, std::string> values;
+    for (BasicBlock* arm : arms)
+    {
+        std::string arm_var;
+        if (!get_assignment(arm, arm_var, values[arm]) || (!var.empty() && arm_var != var))
+            return false;
+        var = arm_var;
+    }
+
+    // executing both arms costs all their instructions, a branch costs half of them and the mispredictions
+    // a branch weighted by __builtin_expect is mispredicted only when the unexpected arm runs
+    size_t misprediction_percent = MISPREDICTION_PERCENT;
+    double expected;
+    if (bb->instrs.back()->get_expected_probability(expected))
+        misprediction_percent = static_cast<size_t>(100 * std::min(expected, 1 - expected) + 0.5);
+    const size_t size = count_instrs(arms);
+    if (INSTR_COST * size > INSTR_COST * size / 2 + MISPREDICTION_PENALTY * misprediction_percent / 100)
+        return false;
+
+    const std::string condition = bb->instrs.back()->get_param(0);
+    const IRInstr* comparison = bb->get_previous_IRInstr(bb->instrs.back());
+    cfg->current_position = bb->instrs.back()->get_position();
+    bb->instrs.pop_back();
+
+    // the arms are moved before the select, except their assignments
+    for (BasicBlock* arm : arms)
+    {
+        for (size_t i=0; i+1<arm->instrs.size(); ++i)
+        {
+            bb->instrs.push_back(cfg->create_IRInstr(bb, *arm->instrs[i]));
+        }
+        const IRInstr* assignment = arm->instrs.back();
+        if (assignment->get_operation() == IRInstr::pre_pp || assignment->get_operation() == IRInstr::pre_mm)
+        {
+            IRInstr::Operation op = assignment->get_operation() == IRInstr::pre_pp ? IRInstr::add : IRInstr::sub;
+            values[arm] = gen_operation(bb, op, cfg->get_var_type(var), {var, gen_constant(bb, 1)});
+        }
+    }
+    std::string if_true = values.count(bb->exit_true) ? values[bb->exit_true] : var;
+    std::string if_false = values.count(bb->exit_false) ? values[bb->exit_false] : var;
+
+    // a comparison already is 1 or 0
+    auto is_constant = [&](const std::string &value, const std::string &constant) -> bool
+        {
+            for (const BasicBlock* arm : arms)
+            {
+                for (const IRInstr* instr : arm->instrs)
+                {
+                    if (instr->get_operation() == IRInstr::ldconst && instr->get_param(0) == value)
+                        return instr->get_param(1) == constant;
+                }
+            }
+            return false;
+        };
+    const bool is_comparison = comparison && comparison->get_param(0) == condition
+        && comparison->get_operation() >= IRInstr::cmp_eq && comparison->get_operation() <= IRInstr::cmp_ne;
+    std::string result;
+    if (is_comparison && is_constant(if_true, "1") && is_constant(if_false, "0"))
+        result = condition;
+    else if (is_comparison && is_constant(if_true, "0") && is_constant(if_false, "1"))
+        result = gen_operation(bb, IRInstr::lnot, Type::INT_64, {condition});
+    else
+        result = gen_operation(bb, IRInstr::select, cfg->get_max_type(if_true, if_false), {condition, if_true, if_false});
+    bb->add_IRInstr(IRInstr::wmem, cfg->get_var_type(var), {var, result});
+    cfg->current_position = SourcePosition();
+    bb->exit_true = join;
+    bb->exit_false = nullptr;
+    return true;
+}
+
+bool IfConversion::get_assignment(const BasicBlock* arm, std::string &var, std::string &value)
+{
+    if (arm->instrs.empty())
+        return false;
+    const IRInstr* assignment = arm->instrs.back();
+    switch (assignment->get_operation())
+    {
+        case IRInstr::Operation::wmem:
+            var = assignment->get_param(0);
+            value = assignment->get_param(1);
+        break;
+        case IRInstr::Operation::pre_pp:
+        case IRInstr::Operation::pre_mm:
+            var = assignment->get_param(0);
+            value = "";
+        break;
+        default:
+            return false;
+    }
+    if (var[0] == '!')
+        return false;
+
+    // the computations are executed speculatively: only temporaries, and nothing that may trap
+    for (size_t i=0; i+1<arm->instrs.size(); ++i)
+    {
+        const IRInstr* instr = arm->instrs[i];
+        switch (instr->get_operation())
+        {
+            case IRInstr::Operation::ldconst:
+            case IRInstr::Operation::add:
+            case IRInstr::Operation::sub:
+            case IRInstr::Operation::mul:
+            case IRInstr::Operation::neg:
+            case IRInstr::Operation::rmem:
+            case IRInstr::Operation::cmp_eq:
+            case IRInstr::Operation::cmp_lt:
+            case IRInstr::Operation::cmp_le:
+            case IRInstr::Operation::cmp_gt:
+            case IRInstr::Operation::cmp_ge:
+            case IRInstr::Operation::cmp_ne:
+            case IRInstr::Operation::band:
+            case IRInstr::Operation::bor:
+            case IRInstr::Operation::bxor:
+            case IRInstr::Operation::bnot:
+            case IRInstr::Operation::shl:
+            case IRInstr::Operation::sar:
+            case IRInstr::Operation::abs:
+            case IRInstr::Operation::min:
+            case IRInstr::Operation::max:
+            case IRInstr::Operation::select:
+            case IRInstr::Operation::lnot:
+                break;
+            default:
+                return false;
+        }
+        if (instr->get_param(0)[0] != '!')
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+// ---------------------------------------------------------- C++ System Headers
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------- Project Headers
+#include "IR.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Forward Declarations                                                       //
+////////////////////////////////////////////////////////////////////////////////
+
+struct AffineExpr;
+struct Loop;
+struct LoopEvolution;
+struct Options;
+struct Recurrence;
+
+////////////////////////////////////////////////////////////////////////////////
+// class CFGPass                                                              //
+////////////////////////////////////////////////////////////////////////////////
+
+/** An optimization pass, run on each function independently */
+class CFGPass {
+public:
+    // ------------------------------------------------ Constructor / Destructor
+    CFGPass() = default;
+    CFGPass(const CFGPass& src) = delete;
+    virtual ~CFGPass() = default;
+
+    // ------------------------------------------------- Public Member Functions
+    virtual std::string get_name() const = 0;
+    virtual bool run(CFG* cfg) = 0; /**< returns true if the CFG was modified */
+
+    // ---------------------------------------------------- Overloaded Operators
+    CFGPass& operator=(const CFGPass& src) = delete;
+protected:
+    static std::map<BasicBlock*, BasicBlock*> clone_blocks(CFG* cfg, const std::vector<BasicBlock*> &blocks); /**< copies blocks, edges between them are redirected to the copies */
+    static size_t count_instrs(const std::vector<BasicBlock*> &blocks);
+    static bool remove_unreachable_blocks(CFG* cfg);
+    static bool get_branch_arms(CFG* cfg, BasicBlock* bb, std::vector<BasicBlock*> &arms, BasicBlock* &join); /**< arms of the triangle or diamond starting with bb, only reachable from bb */
+    static std::string gen_constant(BasicBlock* bb, int64_t value); /**< returns the temporary holding value */
+    static std::string gen_operation(BasicBlock* bb, IRInstr::Operation op, Type type, const std::vector<std::string> &operands); /**< returns the temporary holding the result */
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// class Optimizer                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+class Optimizer {
+public:
+    // ------------------------------------------------ Constructor / Destructor
+    Optimizer(const Options &options);
+    Optimizer(const Optimizer& src) = delete;
+    virtual ~Optimizer();
+
+    // ------------------------------------------------- Public Member Functions
+    void run(IR& ir);
+
+    // ---------------------------------------------------- Overloaded Operators
+    Optimizer& operator=(const Optimizer& src) = delete;
+private:
+    std::vector<CFGPass*> passes;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// class LoopRotation : public CFGPass                                        //
+////////////////////////////////////////////////////////////////////////////////
+
+/* Turns the while/for loops, which test their condition at the top, into
+     loops testing it at the bottom :
+         guard:  condition ; exit if false          guard:  condition ; exit if false
+         header: condition ; exit if false    =>    body:   ...
+         body:   ... ; jmp header                   latch:  condition ; jump to body if true
+     the condition is evaluated once before the first iteration, and each
+     iteration then ends with a single backward conditional branch.
+*/
+class LoopRotation : public CFGPass {
+public:
+    // ------------------------------------------------- Public Member Functions
+    virtual std::string get_name() const override;
+    virtual bool run(CFG* cfg) override;
+
+    static const size_t MAX_HEADER_SIZE = 32; /**< conditions with more instructions are not duplicated */
+private:
+    bool rotate(CFG* cfg, const Loop &loop);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// class LoopUnswitching : public CFGPass                                     //
+////////////////////////////////////////////////////////////////////////////////
+
+/* Moves out of a loop the branches whose condition does not change between
+     iterations :
+         while (c) { if (flag) A; else B; }
+     becomes
+         if (flag) while (c) A; else while (c) B;
+     the loop is copied, so the pass only unswitches small loops and stops once
+     the function has grown by MAX_GROWTH instructions.
+*/
+class LoopUnswitching : public CFGPass {
+public:
+    // ------------------------------------------------- Public Member Functions
+    virtual std::string get_name() const override;
+    virtual bool run(CFG* cfg) override;
+
+    static const size_t MAX_LOOP_SIZE = 64; /**< loops with more instructions are not copied */
+    static const size_t MAX_GROWTH = 256;   /**< instructions that may be added to a function */
+private:
+    bool unswitch(CFG* cfg, const Loop &loop, size_t &growth);
+    static bool find_invariant_condition(const Loop &loop, const BasicBlock* bb, std::vector<const IRInstr*> &chain); /**< instructions to copy before the loop to evaluate the condition of bb */
+    static void remove_branch(BasicBlock* bb, BasicBlock* target);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// class LoopDeletion : public CFGPass                                        //
+////////////////////////////////////////////////////////////////////////////////
+
+/* Replaces the loops whose only effect is the final value of their variables by
+     the closed form of these values, given by the scalar evolution :
+         for (i=0; i<n; ++i) s = s + i;   =>   N = max(n - i, 1); s = s + N*i + N*(N-1)/2; i = i + N;
+         while (--p + 1) n = n * 2;       =>   N = p + 1; n = n << N; p = p - N;
+*/
+class LoopDeletion : public CFGPass {
+public:
+    // ------------------------------------------------- Public Member Functions
+    virtual std::string get_name() const override;
+    virtual bool run(CFG* cfg) override;
+private:
+    bool replace(CFG* cfg, const Loop &loop, const LoopEvolution &evolution);
+    static bool fits_in_immediates(const LoopEvolution &evolution); /**< constants of the closed forms must be valid ldconst operands */
+    static std::string gen_binary(BasicBlock* bb, IRInstr::Operation op, const std::string &lhs, const std::string &rhs);
+    static std::string gen_affine(BasicBlock* bb, const AffineExpr &expr);
+    static std::string gen_recurrence(BasicBlock* bb, const Recurrence &recurrence, const std::string &iterations, const std::string &triangular);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// class IdiomRecognition : public CFGPass                                    //
+////////////////////////////////////////////////////////////////////////////////
+
+/* Replaces the branches and loops computing well known functions by the IR
+     operations computing them at once :
+         if (x < 0) x = -x;                            =>  x = abs(x)
+         if (a < b) m = a; else m = b;                 =>  m = min(a, b)
+         while (x) { c = c + (x & 1); x = x / 2; }     =>  c = c + popcnt(abs(x)); x = 0
+         while (x) { x = x / 2; ++c; }                 =>  c = c + bits - lzcnt(abs(x)); x = 0
+         while (x > 0) { x = x * 2; ++c; }             =>  c = c + lzcnt(x); x = x << lzcnt(x)
+         while (x % 2 == 0) { x = x / 2; ++c; }        =>  c = c + tzcnt(x); x = x >> tzcnt(x)
+     the loops must have been rotated, their guard testing the same condition.
+*/
+class IdiomRecognition : public CFGPass {
+public:
+    // ------------------------------------------------- Public Member Functions
+    virtual std::string get_name() const override;
+    virtual bool run(CFG* cfg) override;
+private:
+    /** expression over the values of the variables before a sequence of blocks */
+    struct Term {
+        typedef enum {
+            VARIABLE,
+            CONSTANT,
+            OPERATION,
+            UNKNOWN    /**< result of a call, different from any other term */
+        } Kind;
+
+        Term();
+        bool operator==(const Term &other) const;
+        bool operator!=(const Term &other) const;
+        static Term variable(const std::string &name);
+        static Term constant(int64_t value);
+        static Term operation(IRInstr::Operation op, const std::vector<Term> &operands);
+
+        Kind kind;
+        std::string name;
+        int64_t value;
+        IRInstr::Operation op;
+        std::vector<Term> operands;
+    };
+
+    bool recognize_select(CFG* cfg, BasicBlock* bb);
+    bool recognize_loop(CFG* cfg, const Loop &loop);
+    static bool evaluate(const std::vector<BasicBlock*> &blocks, std::map<std::string, Term> &values); /**< false if the blocks do more than computations */
+    static Term get_term(const std::map<std::string, Term> &values, const std::string &var);
+    static void get_condition(BasicBlock* bb, IRInstr::Operation &comparison, Term &lhs, Term &rhs); /**< bb goes to exit_true if lhs comparison rhs holds */
+    static IRInstr::Operation negate(IRInstr::Operation comparison);
+    static IRInstr::Operation mirror(IRInstr::Operation comparison); /**< a comparison b == b mirror(comparison) a */
+    static bool is_commutative(const Term &term, IRInstr::Operation op, const Term &a, const Term &b); /**< term is a op b or b op a */
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// class IfConversion : public CFGPass                                        //
+////////////////////////////////////////////////////////////////////////////////
+
+/* Replaces the small branches assigning a variable by the computation of both
+     values followed by a select, lowered to a cmov :
+         if (c) y = a + b; else y = a - b;    =>    y = select(c, a + b, a - b)
+     arms assigning 1 and 0 use the comparison itself, computed by a setcc.
+     Both arms are executed: the conversion pays off when they are cheaper than
+     the mispredictions of a branch depending on the data.
+*/
+class IfConversion : public CFGPass {
+public:
+    // ------------------------------------------------- Public Member Functions
+    virtual std::string get_name() const override;
+    virtual bool run(CFG* cfg) override;
+
+    static const size_t INSTR_COST = 2;              /**< cycles of an IR instruction, in the generated code */
+    static const size_t MISPREDICTION_PENALTY = 16;  /**< cycles lost when a branch is mispredicted */
+    static const size_t MISPREDICTION_PERCENT = 50;  /**< of a branch depending on the data, without __builtin_expect */
+private:
+    bool convert(CFG* cfg, BasicBlock* bb);
+    static bool get_assignment(const BasicBlock* arm, std::string &var, std::string &value); /**< false if the arm does more than computing the value of var */
+};
@@ -1,7 +1,10 @@
 #include "Options.h"
 #include "Writer.h"
 
-Options::Options() : input_file(""), output_file("brutus.s"), optimisation(false), generate_assembly(true), help(false)
+static const char* DEFAULT_PROFILE = "brutus.prof";
+static const char* DEFAULT_TIME_TRACE = "brutus.json";
+
+Options::Options() : input_file(""), output_file("brutus.s"), optimisation(false), popcnt(false), lzcnt(false), bmi(false), print_block_freq(false), print_ast(false), print_ir(false), split_cold_blocks(false), instrument_functions(false), hash_consing(false), fast_frontend(false), time_report(false), mem_report(false), generate_assembly(true), help(false)
 {
     
 }
@@ -44,6 +47,74 @@ bool Options::parseOptions(int nb_options, char **option_inputs)
             {
                 optimisation = true;
             }
+            else if (input == "-mpopcnt")
+            {
+                popcnt = true;
+            }
+            else if (input == "-mlzcnt")
+            {
+                lzcnt = true;
+            }
+            else if (input == "-mbmi")
+            {
+                bmi = true;
+            }
+            else if (input == "-fprofile-generate" || input.compare(0, 19, "-fprofile-generate=") == 0)
+            {
+                profile_generate = input.size() > 19 ? input.substr(19) : DEFAULT_PROFILE;
+            }
+            else if (input == "-fprofile-use" || input.compare(0, 14, "-fprofile-use=") == 0)
+            {
+                profile_use = input.size() > 14 ? input.substr(14) : DEFAULT_PROFILE;
+            }
+            else if (input == "-finstrument-functions")
+            {
+                instrument_functions = true;
+            }
+            else if (input == "-fhash-cons")
+            {
+                hash_consing = true;
+            }
+            else if (input == "-fparse=sll" || input == "-fparse=ll")
+            {
+                parse_mode = input.substr(8);
+            }
+            else if (input == "--frontend=fast" || input == "--frontend=antlr")
+            {
+                fast_frontend = input == "--frontend=fast";
+            }
+            else if (input == "-ftime-report")
+            {
+                time_report = true;
+            }
+            else if (input == "-fmem-report")
+            {
+                mem_report = true;
+            }
+            else if (input == "-ftime-trace" || input.compare(0, 13, "-ftime-trace=") == 0)
+            {
+                time_trace = input.size() > 13 ? input.substr(13) : DEFAULT_TIME_TRACE;
+            }
+            else if (input == "-stats" || input == "-stats=text" || input == "-stats=json")
+            {
+                stats = input.size() > 7 ? input.substr(7) : "text";
+            }
+            else if (input == "-freorder-blocks-and-partition")
+            {
+                split_cold_blocks = true;
+            }
+            else if (input == "-print-block-freq")
+            {
+                print_block_freq = true;
+            }
+            else if (input == "-print-ast")
+            {
+                print_ast = true;
+            }
+            else if (input == "-print-ir")
+            {
+                print_ir = true;
+            }
             else if (input == "-a")
             {
                 generate_assembly = false;
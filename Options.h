@@ -8,6 +8,23 @@ struct Options
     std::string input_file;
     std::string output_file;
     bool optimisation;
+    bool popcnt; /**< x86 extensions the generated code may use, older instruction sequences replace them otherwise */
+    bool lzcnt;
+    bool bmi;
+    bool print_block_freq;
+    bool print_ast; /**< -print-ast, the AST built by the front end */
+    bool print_ir; /**< -print-ir, the IR built from the AST, before the optimizations */
+    bool split_cold_blocks; /**< -freorder-blocks-and-partition */
+    bool instrument_functions; /**< -finstrument-functions */
+    bool hash_consing; /**< -fhash-cons, identical expressions without side effects share their node and their value */
+    std::string parse_mode; /**< "sll" or "ll" with -fparse, empty to parse with SLL then again with LL if SLL fails */
+    bool fast_frontend; /**< --frontend=fast, CProgFastParser instead of the ANTLR parser */
+    bool time_report; /**< -ftime-report */
+    std::string time_trace; /**< Chrome trace events of the phases, empty without -ftime-trace */
+    bool mem_report; /**< -fmem-report, allocations of each phase in the time report */
+    std::string stats; /**< "text" or "json", empty without -stats */
+    std::string profile_generate; /**< profile written by the instrumented program, empty without -fprofile-generate */
+    std::string profile_use;      /**< profile read, empty without -fprofile-use */
     bool generate_assembly;
     bool help;
     bool parseOptions(int nb_options, char **option_inputs);
@@ -0,0 +1,385 @@
+// ------------------------------------------------------------- Project Headers
+#include "Profile.h"
+#include "Analysis.h"
+#include "IR.h"
+#include "Options.h"
+#include "Writer.h"
+
+// ---------------------------------------------------------- C++ System Headers
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// class EdgeProfile                                                          //
+////////////////////////////////////////////////////////////////////////////////
+
+const std::string EdgeProfile::COUNTERS_SYMBOL = "__brutus_profile_counters";
+
+// ----------------------------------------------------------------- Constructor
+EdgeProfile::EdgeProfile(const Options &options) :
+    options(options), nb_counters(0)
+{}
+
+// ----------------------------------------------------- Public Member Functions
+void EdgeProfile::instrument(IR& ir)
+{
+    for (CFG* cfg : ir.get_cfgs())
+    {
+        Record record = {cfg->get_name(), hash(cfg), nb_counters, 0};
+        LoopInfo loop_info(cfg);
+        for (const Edge &edge : get_edges(cfg))
+        {
+            if (!edge.on_tree)
+                insert_counter(cfg, loop_info, edge, nb_counters++);
+        }
+        record.nb_counters = nb_counters - record.first_counter;
+        records.push_back(record);
+        cfg->invalidate_analyses();
+    }
+}
+
+bool EdgeProfile::annotate(IR& ir)
+{
+    std::ifstream file(options.profile_use);
+    if (!file)
+    {
+        Writer::warning() << "cannot open the profile " << options.profile_use << std::endl;
+        return false;
+    }
+
+    // the runs of the instrumented program appended their records to the file
+    std::map<std::pair<std::string, uint64_t>, std::vector<int64_t>> counts;
+    std::string name;
+    uint64_t function_hash;
+    size_t size;
+    while (file >> name >> function_hash >> size)
+    {
+        std::vector<int64_t> &function_counts = counts[std::make_pair(name, function_hash)];
+        if (function_counts.empty())
+            function_counts.assign(size, 0);
+        for (size_t i=0; i<size; ++i)
+        {
+            int64_t count;
+            if (function_counts.size() != size || !(file >> count))
+            {
+                Writer::warning() << "the profile " << options.profile_use << " is corrupted" << std::endl;
+                return false;
+            }
+            function_counts[i] += count;
+        }
+    }
+
+    for (CFG* cfg : ir.get_cfgs())
+    {
+        auto it = counts.find(std::make_pair(cfg->get_name(), hash(cfg)));
+        if (it == counts.end())
+        {
+            Writer::warning() << "no profile for " << cfg->get_name() << ", or its source has changed" << std::endl;
+            continue;
+        }
+
+        // the counted edges come in the order of their counters
+        std::vector<Edge> edges = get_edges(cfg);
+        std::vector<int64_t> edge_counts(edges.size(), 0);
+        std::vector<bool> known(edges.size(), false);
+        size_t counter = 0;
+        for (size_t i=0; i<edges.size() && counter < it->second.size(); ++i)
+        {
+            if (!edges[i].on_tree)
+            {
+                edge_counts[i] = it->second[counter++];
+                known[i] = true;
+            }
+        }
+
+        // flow conservation: the tree edges are solved from the leaves of the spanning tree
+        std::map<const BasicBlock*, std::vector<size_t>> in_edges, out_edges; // nullptr: the return of the function
+        for (size_t i=0; i<edges.size(); ++i)
+        {
+            out_edges[edges[i].from].push_back(i);
+            in_edges[edges[i].to].push_back(i);
+        }
+        bool solved = true;
+        while (solved)
+        {
+            solved = false;
+            for (auto &node : out_edges)
+            {
+                const std::vector<size_t> &ins = in_edges[node.first];
+                const std::vector<size_t> &outs = node.second;
+                int64_t balance = 0;
+                size_t unknown = edges.size();
+                size_t nb_unknown = 0;
+                bool unknown_is_in = false;
+                for (size_t i : ins)
+                {
+                    if (known[i])
+                        balance += edge_counts[i];
+                    else
+                    {
+                        unknown = i;
+                        unknown_is_in = true;
+                        ++nb_unknown;
+                    }
+                }
+                for (size_t i : outs)
+                {
+                    if (known[i])
+                        balance -= edge_counts[i];
+                    else
+                    {
+                        unknown = i;
+                        unknown_is_in = false;
+                        ++nb_unknown;
+                    }
+                }
+                if (nb_unknown != 1)
+                    continue;
+                edge_counts[unknown] = unknown_is_in ? -balance : balance;
+                known[unknown] = true;
+                solved = true;
+            }
+        }
+
+        std::map<std::pair<const BasicBlock*, const BasicBlock*>, int64_t> edge_count_by_blocks;
+        for (size_t i=0; i<edges.size(); ++i)
+        {
+            edge_count_by_blocks[std::make_pair(edges[i].from, edges[i].to)] = edge_counts[i];
+        }
+        for (BasicBlock* bb : cfg->get_bbs())
+        {
+            if (!bb->is_conditional() || bb->exit_true == bb->exit_false)
+                continue;
+            auto taken = edge_count_by_blocks.find(std::make_pair(bb, bb->exit_true));
+            auto not_taken = edge_count_by_blocks.find(std::make_pair(bb, bb->exit_false));
+            if (taken == edge_count_by_blocks.end() || not_taken == edge_count_by_blocks.end())
+                continue;
+            if (taken->second + not_taken->second > 0)
+                bb->instrs.back()->set_expected_probability(static_cast<double>(taken->second) / (taken->second + not_taken->second));
+        }
+        cfg->invalidate_analyses();
+    }
+    return true;
+}
+
+void EdgeProfile::gen_asm(Writer& w) const
+{
+    w.assembly(1) << ".bss" << '\n';
+    w.assembly(1) << ".align 8" << '\n';
+    w.assembly(0) << COUNTERS_SYMBOL << ":" << '\n';
+    w.assembly(1) << ".zero " << 8 * std::max<size_t>(nb_counters, 1) << '\n';
+
+    w.assembly(1) << ".section\t.rodata" << '\n';
+    w.assembly(0) << ".Lbrutus_profile_file:" << '\n';
+    w.assembly(1) << ".string \"" << options.profile_generate << "\"" << '\n';
+    w.assembly(0) << ".Lbrutus_profile_mode:" << '\n';
+    w.assembly(1) << ".string \"a\"" << '\n';
+    w.assembly(0) << ".Lbrutus_profile_format:" << '\n';
+    w.assembly(1) << ".string \"%ld\\n\"" << '\n';
+    for (size_t i=0; i<records.size(); ++i)
+    {
+        w.assembly(0) << ".Lbrutus_profile_record" << i << ":" << '\n';
+        w.assembly(1) << ".string \"" << records[i].name << " " << records[i].hash << " " << records[i].nb_counters << "\\n\"" << '\n';
+    }
+
+    // void __brutus_profile_dump(void), appends the records to the profile
+    w.assembly(1) << ".text" << '\n';
+    w.assembly(0) << "__brutus_profile_dump:" << '\n';
+    w.assembly(1) << "pushq %rbp" << '\n';
+    w.assembly(1) << "movq %rsp, %rbp" << '\n';
+    w.assembly(1) << "pushq %rbx" << '\n';
+    w.assembly(1) << "pushq %r12" << '\n';
+    w.assembly(1) << "leaq .Lbrutus_profile_mode(%rip), %rsi" << '\n';
+    w.assembly(1) << "leaq .Lbrutus_profile_file(%rip), %rdi" << '\n';
+    w.assembly(1) << "call fopen" << '\n';
+    w.assembly(1) << "testq %rax, %rax" << '\n';
+    w.assembly(1) << "je .Lbrutus_profile_end" << '\n';
+    w.assembly(1) << "movq %rax, %r12" << '\n';
+    for (size_t i=0; i<records.size(); ++i)
+    {
+        w.assembly(1) << "movq %r12, %rsi" << '\n';
+        w.assembly(1) << "leaq .Lbrutus_profile_record" << i << "(%rip), %rdi" << '\n';
+        w.assembly(1) << "call fputs" << '\n';
+        if (records[i].nb_counters == 0)
+            continue;
+        w.assembly(1) << "movq $" << records[i].first_counter << ", %rbx" << '\n';
+        w.assembly(0) << ".Lbrutus_profile_loop" << i << ":" << '\n';
+        w.assembly(1) << "leaq " << COUNTERS_SYMBOL << "(%rip), %rax" << '\n';
+        w.assembly(1) << "movq (%rax,%rbx,8), %rdx" << '\n';
+        w.assembly(1) << "leaq .Lbrutus_profile_format(%rip), %rsi" << '\n';
+        w.assembly(1) << "movq %r12, %rdi" << '\n';
+        w.assembly(1) << "movl $0, %eax" << '\n';
+        w.assembly(1) << "call fprintf" << '\n';
+        w.assembly(1) << "incq %rbx" << '\n';
+        w.assembly(1) << "cmpq $" << records[i].first_counter + records[i].nb_counters << ", %rbx" << '\n';
+        w.assembly(1) << "jl .Lbrutus_profile_loop" << i << '\n';
+    }
+    w.assembly(1) << "movq %r12, %rdi" << '\n';
+    w.assembly(1) << "call fclose" << '\n';
+    w.assembly(0) << ".Lbrutus_profile_end:" << '\n';
+    w.assembly(1) << "popq %r12" << '\n';
+    w.assembly(1) << "popq %rbx" << '\n';
+    w.assembly(1) << "popq %rbp" << '\n';
+    w.assembly(1) << "ret" << '\n';
+
+    // constructor registering the dump at exit
+    w.assembly(0) << "__brutus_profile_init:" << '\n';
+    w.assembly(1) << "pushq %rbp" << '\n';
+    w.assembly(1) << "movq %rsp, %rbp" << '\n';
+    w.assembly(1) << "leaq __brutus_profile_dump(%rip), %rdi" << '\n';
+    w.assembly(1) << "call atexit" << '\n';
+    w.assembly(1) << "popq %rbp" << '\n';
+    w.assembly(1) << "ret" << '\n';
+    w.assembly(1) << ".section\t.init_array,\"aw\"" << '\n';
+    w.assembly(1) << ".align 8" << '\n';
+    w.assembly(1) << ".quad __brutus_profile_init" << '\n';
+}
+
+// ---------------------------------------------------- Private Member Functions
+std::vector<EdgeProfile::Edge> EdgeProfile::get_edges(CFG* cfg)
+{
+    LoopInfo loop_info(cfg);
+    BlockFrequency block_frequency(cfg);
+
+    // the edge from the return of the function back to its entry turns the flow into a circulation
+    const double always = std::numeric_limits<double>::max();
+    std::vector<Edge> edges = {{nullptr, cfg->get_entry_bb(), false}};
+    std::vector<double> weights = {always};
+    for (BasicBlock* bb : cfg->get_bbs())
+    {
+        if (!loop_info.is_reachable(bb))
+            continue;
+        bool returns = false;
+        for (const IRInstr* instr : bb->instrs)
+        {
+            if (instr->get_operation() == IRInstr::ret)
+                returns = true;
+        }
+        if (returns || bb->get_successors().empty())
+        {
+            edges.push_back({bb, nullptr, false});
+            // the exit block cannot hold instructions
+            weights.push_back(returns ? block_frequency.get_frequency(bb) : always);
+            continue;
+        }
+        for (BasicBlock* successor : bb->get_successors())
+        {
+            edges.push_back({bb, successor, false});
+            weights.push_back(block_frequency.get_edge_frequency(bb, successor));
+        }
+    }
+
+    // maximum spanning tree (Kruskal): the hottest edges are not counted
+    std::vector<size_t> order(edges.size());
+    for (size_t i=0; i<order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) -> bool
+        {
+            return weights[a] > weights[b];
+        }
+    );
+    std::map<const BasicBlock*, const BasicBlock*> parent; // union-find, nullptr being the return of the function
+    auto find = [&](const BasicBlock* bb) -> const BasicBlock*
+        {
+            while (parent.count(bb) && parent[bb] != bb)
+                bb = parent[bb];
+            return bb;
+        };
+    for (size_t i : order)
+    {
+        const BasicBlock* from = find(edges[i].from);
+        const BasicBlock* to = find(edges[i].to);
+        if (from == to)
+            continue;
+        parent[from] = to;
+        parent[to] = to;
+        edges[i].on_tree = true;
+    }
+    return edges;
+}
+
+uint64_t EdgeProfile::hash(const CFG* cfg)
+{
+    // FNV-1a of the blocks, their instructions and their edges
+    uint64_t h = 14695981039346656037ULL;
+    auto mix = [&h](const std::string &text)
+        {
+            for (char c : text)
+            {
+                h ^= static_cast<unsigned char>(c);
+                h *= 1099511628211ULL;
+            }
+            h ^= 0xff;
+            h *= 1099511628211ULL;
+        };
+    std::map<const BasicBlock*, size_t> indexes;
+    for (const BasicBlock* bb : cfg->get_bbs())
+    {
+        indexes.insert(std::make_pair(bb, indexes.size()));
+    }
+    for (const BasicBlock* bb : cfg->get_bbs())
+    {
+        mix(bb->exit_true ? std::to_string(indexes[bb->exit_true]) : "-");
+        mix(bb->exit_false ? std::to_string(indexes[bb->exit_false]) : "-");
+        for (const IRInstr* instr : bb->instrs)
+        {
+            mix(std::to_string(instr->get_operation()));
+            for (size_t i=0; i<instr->get_nb_params(); ++i)
+                mix(instr->get_param(i));
+        }
+    }
+    return h;
+}
+
+void EdgeProfile::insert_counter(CFG* cfg, const LoopInfo &loop_info, const Edge &edge, size_t index)
+{
+    const std::vector<std::string> params = {COUNTERS_SYMBOL, std::to_string(index)};
+    BasicBlock* bb = edge.from;
+    auto position = bb->instrs.end();
+    if (!edge.to)
+    {
+        // before the return
+        position = std::find_if(bb->instrs.begin(), bb->instrs.end(), [](const IRInstr* instr) -> bool
+            {
+                return instr->get_operation() == IRInstr::ret;
+            }
+        );
+    }
+    else if (!bb->exit_false)
+    {
+        // at the end of a block with a single successor
+    }
+    else if (edge.to != cfg->get_entry_bb() && loop_info.get_predecessors(edge.to).size() == 1)
+    {
+        // at the start of a block with a single predecessor
+        bb = edge.to;
+        position = bb->instrs.begin();
+    }
+    else
+    {
+        // in a new block on the edge
+        BasicBlock* split = cfg->create_bb();
+        split->exit_true = edge.to;
+        split->exit_false = nullptr;
+        edge.from->replace_successor(edge.to, split);
+        cfg->insert_bb_before(edge.to, split);
+        bb = split;
+        position = bb->instrs.end();
+    }
+    // the counter is attributed to the branch or the jump leaving edge.from,
+    // else to the instruction after it, else to the function
+    if (!edge.from->instrs.empty())
+        cfg->current_position = edge.from->instrs.back()->get_position();
+    else if (position != bb->instrs.end())
+        cfg->current_position = (*position)->get_position();
+    else
+        cfg->current_position = cfg->definition_position;
+    bb->instrs.insert(position, cfg->create_IRInstr(bb, IRInstr::counter_inc, Type::INT_64, params));
+    cfg->current_position = SourcePosition();
+}
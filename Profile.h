@@ -0,0 +1,69 @@
+#pragma once
+
+// ---------------------------------------------------------- C++ System Headers
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------- Project Headers
+#include "IR.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Forward Declarations                                                       //
+////////////////////////////////////////////////////////////////////////////////
+
+class LoopInfo;
+struct Options;
+
+////////////////////////////////////////////////////////////////////////////////
+// class EdgeProfile                                                          //
+////////////////////////////////////////////////////////////////////////////////
+
+/* Profile guided optimization, on the CFGs built from the AST.
+     -fprofile-generate=file counts the executions of the edges which are not on
+     a maximum spanning tree of the CFG (the tree edges, likely the hottest ones,
+     are deduced from the flow conservation). The counters live in .bss and are
+     appended to the file at exit, each function as a record:
+         <name> <hash of the CFG> <number of counters>
+         <count>
+         ...
+     -fprofile-use=file sums the records whose hash matches the CFG built from
+     the same source, computes the count of each edge and weights the cmp_null
+     of the branches with the measured probabilities. The block frequencies, the
+     layout and the passes then follow the profile.
+*/
+class EdgeProfile {
+public:
+    // ------------------------------------------------------------- Constructor
+    EdgeProfile(const Options &options);
+
+    // ------------------------------------------------- Public Member Functions
+    void instrument(IR& ir); /**< -fprofile-generate, before the optimizations */
+    bool annotate(IR& ir);   /**< -fprofile-use, before the optimizations, false if the file cannot be read */
+    void gen_asm(Writer& writer) const; /**< counters, and the routine dumping them at exit */
+
+    static const std::string COUNTERS_SYMBOL;
+private:
+    /** edge of the CFG, to is nullptr for the return from the function */
+    struct Edge {
+        BasicBlock* from;
+        BasicBlock* to;
+        bool on_tree;
+    };
+
+    /** counters of a function */
+    struct Record {
+        std::string name;
+        uint64_t hash;
+        size_t first_counter;
+        size_t nb_counters;
+    };
+
+    static std::vector<Edge> get_edges(CFG* cfg); /**< from the same CFG, always the same edges with the same spanning tree */
+    static uint64_t hash(const CFG* cfg);
+    static void insert_counter(CFG* cfg, const LoopInfo &loop_info, const Edge &edge, size_t index); /**< on the edge, splitting it if needed */
+
+    const Options &options;
+    std::vector<Record> records;
+    size_t nb_counters;
+};
@@ -0,0 +1,108 @@
+// ------------------------------------------------------------- Project Headers
+#include "Statistics.h"
+#include "IR.h"
+#include "Writer.h"
+
+// ---------------------------------------------------------- C++ System Headers
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// class Statistics                                                           //
+////////////////////////////////////////////////////////////////////////////////
+
+bool Statistics::enabled = false;
+std::vector<std::string> Statistics::functions;
+std::map<std::string, std::map<std::string, int64_t>> Statistics::counters;
+
+// ----------------------------------------------------- Public Member Functions
+void Statistics::enable()
+{
+    enabled = true;
+}
+
+bool Statistics::is_enabled()
+{
+    return enabled;
+}
+
+void Statistics::add(const std::string &function, const std::string &counter, int64_t value)
+{
+    if (!enabled)
+        return;
+    if (!counters.count(function))
+        functions.push_back(function);
+    counters[function][counter] += value;
+}
+
+void Statistics::add_cfg(CFG* cfg, const Options &options)
+{
+    if (!enabled)
+        return;
+    const std::string function = cfg->get_name();
+    add(function, "basic-blocks", cfg->get_bbs().size());
+    for (const BasicBlock* bb : cfg->get_bbs())
+    {
+        add(function, "ir-instructions", bb->instrs.size());
+        for (const IRInstr* instr : bb->instrs)
+        {
+            std::ostringstream operation;
+            operation << instr->get_operation();
+            add(function, "ir-instructions." + operation.str());
+        }
+    }
+    add(function, "temporaries", cfg->get_nb_temporaries());
+    add(function, "frame-size", cfg->get_frame_size(options));
+    add(function, "ir-bytes", cfg->get_allocated_bytes());
+}
+
+void Statistics::print(bool json)
+{
+    std::map<std::string, int64_t> total;
+    for (const std::string &function : functions)
+    {
+        for (const auto &counter : counters[function])
+            total[counter.first] += counter.second;
+    }
+
+    if (json)
+    {
+        std::cout << "{\"functions\": {";
+        for (size_t i=0; i<functions.size(); ++i)
+        {
+            std::cout << (i ? ", " : "") << "\"" << functions[i] << "\": ";
+            print_json_counters(counters[functions[i]]);
+        }
+        std::cout << "}, \"total\": ";
+        print_json_counters(total);
+        std::cout << "}" << std::endl;
+        return;
+    }
+
+    for (const std::string &function : functions)
+    {
+        Writer::info() << "function " << function << " :" << std::endl;
+        for (const auto &counter : counters[function])
+            Writer::info() << "  " << counter.first << " : " << counter.second << std::endl;
+    }
+    Writer::info() << "total :" << std::endl;
+    for (const auto &counter : total)
+        Writer::info() << "  " << counter.first << " : " << counter.second << std::endl;
+}
+
+// ---------------------------------------------------- Private Member Functions
+void Statistics::print_json_counters(const std::map<std::string, int64_t> &counters)
+{
+    std::cout << "{";
+    bool first = true;
+    for (const auto &counter : counters)
+    {
+        std::cout << (first ? "" : ", ") << "\"" << counter.first << "\": " << counter.second;
+        first = false;
+    }
+    std::cout << "}";
+}
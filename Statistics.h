@@ -0,0 +1,43 @@
+#pragma once
+
+// ---------------------------------------------------------- C++ System Headers
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Forward Declarations                                                       //
+////////////////////////////////////////////////////////////////////////////////
+
+class CFG;
+struct Options;
+
+////////////////////////////////////////////////////////////////////////////////
+// class Statistics                                                           //
+////////////////////////////////////////////////////////////////////////////////
+
+/* Counters of the compilation of each function, for -stats. The phases add to
+     named counters, the passes prefixing them with their name:
+         ast-nodes, basic-blocks, ir-instructions, ir-instructions.<operation>,
+         temporaries, frame-size, asm-instructions, removed-blocks,
+         codegen.eliminated-loads, loop-rotation.rotated-loops, ...
+     print() shows them for each function and in total, as text or as JSON:
+         {"functions": {"main": {"ast-nodes": 12, ...}, ...}, "total": {...}}
+     Nothing is counted until enable() is called.
+*/
+class Statistics {
+public:
+    // ------------------------------------------------- Public Member Functions
+    static void enable();
+    static bool is_enabled();
+    static void add(const std::string &function, const std::string &counter, int64_t value = 1);
+    static void add_cfg(CFG* cfg, const Options &options); /**< blocks, instructions, temporaries and frame of the final IR of cfg */
+    static void print(bool json); /**< text on the error output, JSON on the standard output */
+private:
+    static void print_json_counters(const std::map<std::string, int64_t> &counters);
+
+    static bool enabled;
+    static std::vector<std::string> functions; /**< in the order they were compiled */
+    static std::map<std::string, std::map<std::string, int64_t>> counters;
+};
@@ -0,0 +1,227 @@
+// ------------------------------------------------------------- Project Headers
+#include "TimeReport.h"
+#include "MemoryUsage.h"
+#include "Writer.h"
+
+// ---------------------------------------------------------- C++ System Headers
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// class TimeReport                                                           //
+////////////////////////////////////////////////////////////////////////////////
+
+bool TimeReport::enabled = false;
+TimeReport::Clock::time_point TimeReport::origin;
+std::vector<TimeReport::Event> TimeReport::events;
+std::vector<size_t> TimeReport::open_events;
+
+// ----------------------------------------------------- Public Member Functions
+void TimeReport::enable()
+{
+    enabled = true;
+    origin = Clock::now();
+}
+
+bool TimeReport::is_enabled()
+{
+    return enabled;
+}
+
+void TimeReport::start(const std::string &name, const std::string &function)
+{
+    Event event = {name, function, now(), 0, 0, false, 0, 0, 0, 0, 0};
+    if (MemoryUsage::is_enabled())
+    {
+        // the counters are made relative to the start of the phase by stop()
+        event.nb_allocations = MemoryUsage::get_nb_allocations();
+        event.allocated_bytes = MemoryUsage::get_allocated_bytes();
+        event.outer_peak_bytes = MemoryUsage::get_peak_bytes();
+        MemoryUsage::set_peak_bytes(MemoryUsage::get_live_bytes());
+    }
+    for (size_t index : open_events)
+    {
+        if (events[index].repeated)
+            continue;
+        ++event.depth;
+        if (events[index].name == name)
+            event.repeated = true;
+    }
+    open_events.push_back(events.size());
+    events.push_back(event);
+}
+
+void TimeReport::stop()
+{
+    Event &event = events[open_events.back()];
+    event.duration = now() - event.start;
+    if (MemoryUsage::is_enabled())
+    {
+        event.nb_allocations = MemoryUsage::get_nb_allocations() - event.nb_allocations;
+        event.allocated_bytes = MemoryUsage::get_allocated_bytes() - event.allocated_bytes;
+        event.peak_bytes = MemoryUsage::get_peak_bytes();
+        event.resident_bytes = MemoryUsage::get_peak_resident_bytes();
+        MemoryUsage::set_peak_bytes(std::max(event.outer_peak_bytes, event.peak_bytes));
+    }
+    open_events.pop_back();
+}
+
+void TimeReport::print()
+{
+    // phases in the order they first ran, a phase split by function counted once
+    std::vector<std::string> phases;
+    std::map<std::string, double> phase_times;
+    std::map<std::string, size_t> phase_depths;
+    std::map<std::string, Event> phase_memory;
+    double total = 0;
+    const Event no_memory = {"", "", 0, 0, 0, false, 0, 0, 0, 0, 0};
+    Event total_memory = no_memory;
+    for (const Event &event : events)
+    {
+        if (event.repeated)
+            continue;
+        if (!phase_times.count(event.name))
+        {
+            phases.push_back(event.name);
+            phase_depths[event.name] = event.depth;
+            phase_memory[event.name] = no_memory;
+        }
+        phase_times[event.name] += event.duration;
+        add_memory(phase_memory[event.name], event);
+        if (event.depth == 0)
+        {
+            total += event.duration;
+            add_memory(total_memory, event);
+        }
+    }
+
+    const bool memory = MemoryUsage::is_enabled();
+    Writer::info() << "Temps de compilation : " << std::endl;
+    std::ostream &phase_header = Writer::info() << std::left << std::setw(34) << "  phase" << std::right << std::setw(14) << "temps (ms)" << std::setw(8) << "%";
+    if (memory)
+        phase_header << std::setw(14) << "allocations" << std::setw(14) << "alloc. (Ko)" << std::setw(14) << "pic tas (Ko)" << std::setw(14) << "RSS max (Ko)";
+    phase_header << std::endl;
+    for (const std::string &phase : phases)
+    {
+        std::string label = std::string(2 + 2 * phase_depths[phase], ' ') + phase;
+        std::ostream &os = Writer::info() << std::left << std::setw(34) << label << std::right << std::fixed
+                                          << std::setprecision(3) << std::setw(14) << phase_times[phase] / 1000
+                                          << std::setprecision(1) << std::setw(8) << (total > 0 ? 100 * phase_times[phase] / total : 0);
+        if (memory)
+            print_memory(os, phase_memory[phase]);
+        os << std::endl;
+    }
+    std::ostream &total_line = Writer::info() << std::left << std::setw(34) << "  total" << std::right << std::fixed
+                                              << std::setprecision(3) << std::setw(14) << total / 1000;
+    if (memory)
+        print_memory(total_line << std::setw(8) << "", total_memory);
+    total_line << std::endl;
+
+    // the phases split by function are the columns of the second table
+    std::vector<std::string> functions;
+    std::vector<std::string> columns;
+    std::map<std::string, std::map<std::string, double>> function_times;
+    for (const Event &event : events)
+    {
+        if (!event.repeated || event.function.empty())
+            continue;
+        if (!function_times.count(event.function))
+            functions.push_back(event.function);
+        if (std::find(columns.begin(), columns.end(), event.name) == columns.end())
+            columns.push_back(event.name);
+        function_times[event.function][event.name] += event.duration;
+    }
+    if (functions.empty())
+        return;
+
+    Writer::info() << "Temps par fonction (ms) : " << std::endl;
+    std::ostream &header = Writer::info() << std::left << std::setw(22) << "  fonction" << std::right;
+    for (const std::string &column : columns)
+        header << std::setw(std::max<size_t>(14, column.size() + 2)) << column;
+    header << std::setw(14) << "total" << std::endl;
+    for (const std::string &function : functions)
+    {
+        double function_total = 0;
+        std::ostream &os = Writer::info() << std::left << std::setw(22) << "  " + function << std::right << std::fixed << std::setprecision(3);
+        for (const std::string &column : columns)
+        {
+            os << std::setw(std::max<size_t>(14, column.size() + 2)) << function_times[function][column] / 1000;
+            function_total += function_times[function][column];
+        }
+        os << std::setw(14) << function_total / 1000 << std::endl;
+    }
+}
+
+bool TimeReport::write_trace(const std::string &filename)
+{
+    std::ofstream file(filename);
+    if (!file)
+        return false;
+    file << "{\"traceEvents\":[" << std::fixed << std::setprecision(3);
+    for (size_t i=0; i<events.size(); ++i)
+    {
+        const Event &event = events[i];
+        file << (i ? ",\n" : "\n")
+             << "{\"name\":\"" << event.name << (event.function.empty() ? "" : " (" + event.function + ")") << "\","
+             << "\"cat\":\"" << (event.function.empty() ? "phase" : "function") << "\","
+             << "\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+             << "\"ts\":" << event.start << ",\"dur\":" << event.duration;
+        if (!event.function.empty() || MemoryUsage::is_enabled())
+        {
+            file << ",\"args\":{";
+            if (!event.function.empty())
+                file << "\"function\":\"" << event.function << "\"" << (MemoryUsage::is_enabled() ? "," : "");
+            if (MemoryUsage::is_enabled())
+                file << "\"allocations\":" << event.nb_allocations << ",\"allocated_bytes\":" << event.allocated_bytes
+                     << ",\"peak_heap_bytes\":" << event.peak_bytes << ",\"peak_resident_bytes\":" << event.resident_bytes;
+            file << "}";
+        }
+        file << "}";
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+    return true;
+}
+
+// ---------------------------------------------------- Private Member Functions
+double TimeReport::now()
+{
+    return std::chrono::duration<double, std::micro>(Clock::now() - origin).count();
+}
+
+void TimeReport::add_memory(Event &sum, const Event &event)
+{
+    sum.nb_allocations += event.nb_allocations;
+    sum.allocated_bytes += event.allocated_bytes;
+    sum.peak_bytes = std::max(sum.peak_bytes, event.peak_bytes);
+    sum.resident_bytes = std::max(sum.resident_bytes, event.resident_bytes);
+}
+
+void TimeReport::print_memory(std::ostream &os, const Event &event)
+{
+    os << std::setw(14) << event.nb_allocations
+       << std::setw(14) << event.allocated_bytes / 1024
+       << std::setw(14) << event.peak_bytes / 1024
+       << std::setw(14) << event.resident_bytes / 1024;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class PhaseTimer                                                           //
+////////////////////////////////////////////////////////////////////////////////
+
+// ---------------------------------------------------- Constructor / Destructor
+PhaseTimer::PhaseTimer(const std::string &name, const std::string &function) :
+    running(TimeReport::is_enabled())
+{
+    if (running)
+        TimeReport::start(name, function);
+}
+
+PhaseTimer::~PhaseTimer()
+{
+    if (running)
+        TimeReport::stop();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+// ---------------------------------------------------------- C++ System Headers
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// class TimeReport                                                           //
+////////////////////////////////////////////////////////////////////////////////
+
+/* Wall clock time of the phases of the compiler, for -ftime-report and
+     -ftime-trace. The phases are nested, and the ones working on a single
+     function name it:
+         codegen
+             codegen (main)
+     print() shows the time of each phase, then the time of each function in
+     the phases split by function. write_trace() exports every phase as a
+     Chrome trace event, to be opened in chrome://tracing or Perfetto.
+     With -fmem-report, the allocations of each phase, the peak of the heap
+     during the phase and the peak resident memory at its end are recorded
+     too, from MemoryUsage.
+     Nothing is recorded until enable() is called.
+*/
+class TimeReport {
+public:
+    // ------------------------------------------------- Public Member Functions
+    static void enable();
+    static bool is_enabled();
+    static void start(const std::string &name, const std::string &function = "");
+    static void stop(); /**< of the last started phase */
+    static void print();
+    static bool write_trace(const std::string &filename); /**< false if the file cannot be written */
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    /** a phase, with its times in microseconds from enable() */
+    struct Event {
+        std::string name;
+        std::string function; /**< empty if the phase works on the whole program */
+        double start;
+        double duration;
+        size_t depth;
+        bool repeated;        /**< inside a phase of the same name, already counted by it */
+        size_t nb_allocations;
+        size_t allocated_bytes;
+        size_t peak_bytes;    /**< of the heap during the phase */
+        size_t resident_bytes; /**< peak resident memory at the end of the phase */
+        size_t outer_peak_bytes; /**< peak of the heap before the phase, restored at its end */
+    };
+
+    static double now();
+    static void add_memory(Event &sum, const Event &event); /**< counters of event added to the ones of sum */
+    static void print_memory(std::ostream &os, const Event &event);
+
+    static bool enabled;
+    static Clock::time_point origin;
+    static std::vector<Event> events;
+    static std::vector<size_t> open_events;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// class PhaseTimer                                                           //
+////////////////////////////////////////////////////////////////////////////////
+
+/** Times a phase until the end of the scope, if the report is enabled */
+class PhaseTimer {
+public:
+    // ------------------------------------------------ Constructor / Destructor
+    PhaseTimer(const std::string &name, const std::string &function = "");
+    PhaseTimer(const PhaseTimer& src) = delete;
+    ~PhaseTimer();
+
+    // ---------------------------------------------------- Overloaded Operators
+    PhaseTimer& operator=(const PhaseTimer& src) = delete;
+private:
+    bool running;
+};
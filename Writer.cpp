@@ -1,15 +1,20 @@
 #include "Writer.h"
 #include "Options.h"
+#include <cstring>
 #include <iostream>
+#include <string>
 
 constexpr static auto RESET = "\033[0m";
 constexpr static auto BOLD = "\033[1m";
 constexpr static auto YELLOW = "\033[33m";
 constexpr static auto RED = "\033[31m";
 
+static const std::string INDENTATION(32, ' ');
+
 bool Writer::error_occurred = false;
 
-Writer::Writer(const Options &options) : m_output_file_stream(options.output_file)
+Writer::Writer(const Options &options) :
+    m_output_file_stream(options.output_file), m_buffer(m_output_file_stream.rdbuf(), ASSEMBLY_BUFFER_SIZE), m_assembly_stream(&m_buffer), m_options(options)
 {
     if (!options.output_file.empty() && !m_output_file_stream.is_open())
     {
@@ -17,28 +22,142 @@ Writer::Writer(const Options &options) : m_output_file_stream(options.output_fil
     }
 }
 
+Writer::Writer(const Options &options, std::streambuf* destination) :
+    m_buffer(destination, DESTINATION_BUFFER_SIZE), m_assembly_stream(&m_buffer), m_options(options)
+{}
+
+Writer::~Writer()
+{
+    flush();
+}
+
 std::ostream& Writer::assembly(unsigned int indent)
 {
-    for (unsigned int i=0; i < indent*4; i++)
-    {
-        m_output_file_stream << " ";
-    }
-    return m_output_file_stream;
+    size_t width = indent * 4;
+    for (; width > INDENTATION.size(); width -= INDENTATION.size())
+        m_assembly_stream.write(INDENTATION.data(), INDENTATION.size());
+    m_assembly_stream.write(INDENTATION.data(), width);
+    // labels are not indented
+    if (indent > 0)
+        m_buffer.start_line();
+    return m_assembly_stream;
+}
+
+void Writer::flush()
+{
+    m_buffer.flush();
+}
+
+const Options& Writer::get_options() const
+{
+    return m_options;
+}
+
+size_t Writer::get_nb_instructions() const
+{
+    return m_buffer.get_nb_instructions();
 }
 
 std::ostream& Writer::info()
 {
-    return std::cerr << BOLD << "info: " << RESET;
+    return diagnostics() << BOLD << "info: " << RESET;
 }
 
 std::ostream& Writer::warning()
 {
-    return std::cerr << BOLD << YELLOW << "warning: " << RESET;
+    return diagnostics() << BOLD << YELLOW << "warning: " << RESET;
 }
 
 std::ostream& Writer::error()
 {
     error_occurred = true;
-    return std::cerr << BOLD << RED << "error: " << RESET;
+    return diagnostics() << BOLD << RED << "error: " << RESET;
+}
+
+std::ostream& Writer::diagnostics()
+{
+    // written at each std::endl, so that they are not lost if the program aborts
+    static OutputBuffer buffer(std::cerr.rdbuf(), DIAGNOSTICS_BUFFER_SIZE);
+    static std::ostream stream(&buffer);
+    return stream;
+}
+
+Writer::OutputBuffer::OutputBuffer(std::streambuf* destination, size_t size) :
+    buffer(size), destination(destination), nb_instructions(0), line_start(nullptr)
+{
+    setp(buffer.data(), buffer.data() + buffer.size());
 }
 
+Writer::OutputBuffer::~OutputBuffer()
+{
+    flush();
+}
+
+void Writer::OutputBuffer::start_line()
+{
+    if (line_start && line_start < pptr())
+        count_line(*line_start);
+    line_start = pptr();
+}
+
+void Writer::OutputBuffer::flush()
+{
+    if (line_start && line_start < pptr())
+        count_line(*line_start);
+    destination->sputn(pbase(), pptr() - pbase());
+    destination->pubsync();
+    setp(buffer.data(), buffer.data() + buffer.size());
+    // the line started just before the flush begins the emptied buffer
+    if (line_start)
+        line_start = pbase();
+}
+
+size_t Writer::OutputBuffer::get_nb_instructions() const
+{
+    size_t nb_pending = line_start && line_start < pptr() && *line_start != '.' && *line_start != '\n';
+    return nb_instructions + nb_pending;
+}
+
+int Writer::OutputBuffer::overflow(int c)
+{
+    if (c == traits_type::eof())
+        return traits_type::not_eof(c);
+    flush();
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+    return c;
+}
+
+std::streamsize Writer::OutputBuffer::xsputn(const char* s, std::streamsize n)
+{
+    if (n > epptr() - pptr())
+    {
+        flush();
+        // too large for the buffer: written at once
+        if (n > epptr() - pptr())
+        {
+            if (line_start && n > 0)
+                count_line(s[0]);
+            return destination->sputn(s, n);
+        }
+    }
+    std::memcpy(pptr(), s, n);
+    pbump(static_cast<int>(n));
+    return n;
+}
+
+int Writer::OutputBuffer::sync()
+{
+    // std::endl and std::flush, used by the diagnostics only: the assembly
+    // lines end with '\n'
+    flush();
+    return 0;
+}
+
+void Writer::OutputBuffer::count_line(char first)
+{
+    // directives start with a dot
+    if (first != '.' && first != '\n')
+        ++nb_instructions;
+    line_start = nullptr;
+}
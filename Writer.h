@@ -1,6 +1,8 @@
 #pragma once
 
 #include <fstream>
+#include <streambuf>
+#include <vector>
 
 struct Options;
 
@@ -8,14 +10,54 @@ class Writer
 {
 public:
     Writer(const Options &options);
+    Writer(const Options &options, std::streambuf* destination); /**< writes the assembly into destination instead of the output file */
+    ~Writer(); /**< writes what remains of the assembly */
     std::ostream& assembly(unsigned int indent);
+    void flush(); /**< writes the buffered assembly into the file */
+    const Options& get_options() const; /**< target features of the generated code */
+    size_t get_nb_instructions() const; /**< indented lines written so far which are not directives */
     static std::ostream& info();
     static std::ostream& warning();
     static std::ostream& error();
     static bool error_occurred;
 
 private:
+    /* Keeps the text in memory and forwards it to the destination in large
+         batches, once the buffer is full or on flush(), std::flush and
+         std::endl: the assembly ends its lines with '\n' to stay buffered.
+         It also counts the indented lines of the assembly which are
+         instructions, from their first character.
+    */
+    class OutputBuffer : public std::streambuf
+    {
+    public:
+        OutputBuffer(std::streambuf* destination, size_t size);
+        ~OutputBuffer();
+        void start_line(); /**< the next character starts an indented line */
+        void flush();
+        size_t get_nb_instructions() const;
+    protected:
+        virtual int overflow(int c) override;
+        virtual std::streamsize xsputn(const char* s, std::streamsize n) override;
+        virtual int sync() override;
+    private:
+        void count_line(char first); /**< of the line started by start_line() */
+
+        std::vector<char> buffer;
+        std::streambuf* destination;
+        size_t nb_instructions;
+        char* line_start; /**< in the buffer, where the line started by start_line() begins, nullptr if none */
+    };
+
+    static const size_t ASSEMBLY_BUFFER_SIZE = 1 << 20;
+    static const size_t DIAGNOSTICS_BUFFER_SIZE = 1 << 16;
+    static const size_t DESTINATION_BUFFER_SIZE = 1 << 12;
+
+    static std::ostream& diagnostics(); /**< standard error, written at each std::endl */
+
     std::ofstream m_output_file_stream;
-    
-};
+    OutputBuffer m_buffer;
+    std::ostream m_assembly_stream;
+    const Options &m_options;
 
+};
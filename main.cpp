@@ -1,34 +1,170 @@
 #include "antlr4-runtime.h"
 #include "CProgCSTVisitor.h"
+#include "CProgFastParser.h"
 #include "CProgLexer.h"
 #include "CProgParser.h"
 #include "Options.h"
 #include "Writer.h"
 #include "IR.h"
+#include "Optimizer.h"
+#include "MemoryUsage.h"
+#include "Profile.h"
+#include "Statistics.h"
+#include "TimeReport.h"
 #include "CProgAST.h"
 #include <istream>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <vector>
 
 using namespace std;
 using namespace antlr4;
 
+/* Reports the errors of the ANTLR lexer and parser as the other diagnostics,
+     through Writer::error(), and counts them.
+*/
+class SyntaxErrorListener : public BaseErrorListener
+{
+public:
+    virtual void syntaxError(Recognizer*, Token*, size_t line, size_t charPositionInLine, const std::string &msg, std::exception_ptr) override
+    {
+        Writer::error() << "line " << line << ":" << charPositionInLine << " " << msg << std::endl;
+        ++nb_errors;
+    }
+
+    size_t nb_errors = 0;
+};
+
+/* SLL prediction is much faster than full LL, and enough for almost every
+     valid program: it is tried first with an error strategy that gives up at
+     the first syntax error without reporting it, then the tokens are parsed
+     again with full LL and the default error recovery, which reports the
+     errors. -fparse=sll or -fparse=ll forces a single pass in one mode.
+     The DFA of the predictions is shared by every parser of the process, the
+     LL pass reuses the one built by the SLL pass.
+*/
+static tree::ParseTree* parse_program(CProgParser &parser, SyntaxErrorListener &errors, const Options &options)
+{
+    atn::ParserATNSimulator *interpreter = parser.getInterpreter<atn::ParserATNSimulator>();
+    if (!options.parse_mode.empty())
+    {
+        parser.removeErrorListeners();
+        parser.addErrorListener(&errors);
+        interpreter->setPredictionMode(options.parse_mode == "sll" ? atn::PredictionMode::SLL : atn::PredictionMode::LL);
+        return parser.program();
+    }
+
+    interpreter->setPredictionMode(atn::PredictionMode::SLL);
+    parser.removeErrorListeners();
+    parser.setErrorHandler(std::make_shared<BailErrorStrategy>());
+    try
+    {
+        PhaseTimer timer("parsing-sll");
+        return parser.program();
+    }
+    catch (ParseCancellationException&)
+    {
+    }
+
+    PhaseTimer timer("parsing-ll");
+    parser.reset(); // back to the first token
+    parser.addErrorListener(&errors);
+    parser.setErrorHandler(std::make_shared<DefaultErrorStrategy>());
+    interpreter->setPredictionMode(atn::PredictionMode::LL);
+    return parser.program();
+}
+
+static CProgASTProgram* build_ast_antlr(istream &file, const Options &options)
+{
+    ANTLRInputStream input(file);
+    SyntaxErrorListener errors;
+    CProgLexer lexer(&input);
+    lexer.removeErrorListeners();
+    lexer.addErrorListener(&errors);
+    CommonTokenStream tokens(&lexer);
+    {
+        PhaseTimer timer("lexing");
+        tokens.fill();
+    }
+    CProgParser parser(&tokens);
+    tree::ParseTree *tree;
+    {
+        PhaseTimer timer("parsing");
+        tree = parse_program(parser, errors, options);
+    }
+    // the parse tree of a program with errors is not visited, as the fast
+    // front end keeps no AST
+    if (errors.nb_errors > 0)
+        return nullptr;
+
+    CProgCSTVisitor visitor(options);
+    PhaseTimer timer("cst-to-ast");
+    return visitor.visit(tree).as<CProgASTProgram*>();
+}
+
+/* --frontend=fast builds the same AST without ANTLR: CProgFastParser reads
+     the tokens of CProgFastLexer and creates the nodes directly, there is no
+     parse tree to build and then to visit.
+*/
+static CProgASTProgram* build_ast_fast(istream &file, const Options &options)
+{
+    stringstream source;
+    source << file.rdbuf();
+    string text = source.str();
+    CProgFastLexer lexer(text);
+    vector<CProgToken> tokens;
+    {
+        PhaseTimer timer("lexing");
+        tokens = lexer.tokenize();
+    }
+    CProgFastParser parser(tokens, options);
+    CProgASTProgram *ast;
+    {
+        PhaseTimer timer("parsing");
+        ast = parser.parse_program();
+    }
+    // like ANTLR, the parser goes on after the lexer errors, but no AST is kept
+    if (lexer.get_nb_errors() > 0)
+    {
+        delete ast;
+        return nullptr;
+    }
+    return ast;
+}
+
 int main(int argc, char **argv)
 {
     Options options;
     if (!options.parseOptions(argc, argv))
     {
         cout << "usage : " << argv[0] << " [options] <input_file>" << endl
-             << "[options] : -o <output_file> | -O | -a | --help" << endl;
+             << "[options] : -o <output_file> | -O | -mpopcnt | -mlzcnt | -mbmi | -fprofile-generate[=<file>] | -fprofile-use[=<file>] | -finstrument-functions | -fhash-cons | -fparse=sll|ll | --frontend=antlr|fast | -ftime-report | -fmem-report | -ftime-trace[=<file>] | -stats[=json] | -freorder-blocks-and-partition | -print-block-freq | -print-ast | -print-ir | -a | --help" << endl;
         return 1;
     }
 
     if (options.help)
     {
         cout << argv[0] << " [options] <input_file>" << endl
-        << "[options] : -o <output_file> | -O | -a | --help" << endl << endl
+        << "[options] : -o <output_file> | -O | -mpopcnt | -mlzcnt | -mbmi | -fprofile-generate[=<file>] | -fprofile-use[=<file>] | -finstrument-functions | -fhash-cons | -fparse=sll|ll | --frontend=antlr|fast | -ftime-report | -fmem-report | -ftime-trace[=<file>] | -stats[=json] | -freorder-blocks-and-partition | -print-block-freq | -print-ast | -print-ir | -a | --help" << endl << endl
         << "-o <output_file> : définit le nom du fichier de sortie" << endl
-        << "-O : optimise la représentation en mémoire du programme" << endl
+        << "-O : active les passes d'optimisation (rotation des boucles, ...)" << endl
+        << "-mpopcnt, -mlzcnt, -mbmi : autorise les instructions popcnt, lzcnt et tzcnt" << endl
+        << "-fprofile-generate[=<file>] : instrumente le programme pour qu'il écrive son profil dans <file> (brutus.prof)" << endl
+        << "-fprofile-use[=<file>] : optimise selon le profil lu dans <file> (brutus.prof)" << endl
+        << "-finstrument-functions : affiche à la sortie du programme le nombre d'appels et les cycles de chaque fonction" << endl
+        << "-fhash-cons : partage les expressions identiques sans effet de bord et ne calcule leur valeur qu'une fois par bloc" << endl
+        << "-fparse=sll|ll : impose la prédiction SLL ou LL de l'analyseur syntaxique, par défaut SLL puis LL si SLL échoue" << endl
+        << "--frontend=antlr|fast : analyse le fichier avec ANTLR (par défaut) ou avec l'analyseur écrit à la main, plus rapide" << endl
+        << "-ftime-report : affiche le temps passé dans chaque phase de la compilation et pour chaque fonction" << endl
+        << "-fmem-report : ajoute au temps de chaque phase ses allocations, le pic du tas et le pic de mémoire résidente" << endl
+        << "-ftime-trace[=<file>] : écrit les phases de la compilation dans <file> (brutus.json), au format Chrome trace" << endl
+        << "-stats[=json] : affiche les compteurs de la compilation de chaque fonction, en JSON sur la sortie standard avec =json" << endl
+        << "-freorder-blocks-and-partition : place les blocs rarement exécutés dans la section .text.unlikely" << endl
+        << "-print-block-freq : affiche la fréquence estimée de chaque bloc de base" << endl
+        << "-print-ast : affiche l'AST construit par l'analyseur syntaxique" << endl
+        << "-print-ir : affiche l'IR construite à partir de l'AST, avant les optimisations" << endl
         << "-a : s'arrête avant la génération du fichier assembleur" << endl
         << "--help : affiche l'utilisation du programme" << endl << endl
         << "Comportement par défaut :" << endl
@@ -44,23 +180,60 @@ int main(int argc, char **argv)
         Writer::error() << "cannot open " << options.input_file << std::endl;
         return 1;
     }
-    ANTLRInputStream input(file);
-    CProgLexer lexer(&input);
-    CommonTokenStream tokens(&lexer);
-    CProgParser parser(&tokens);
-    tree::ParseTree *tree = parser.program();
+    if (options.mem_report)
+        MemoryUsage::enable();
+    if (options.time_report || options.mem_report || !options.time_trace.empty())
+        TimeReport::enable();
+    if (!options.stats.empty())
+        Statistics::enable();
 
     Writer writer(options);
-    CProgCSTVisitor visitor;
-    CProgASTProgram *ast = visitor.visit(tree).as<CProgASTProgram*>();
+    CProgASTProgram *ast = options.fast_frontend ? build_ast_fast(file, options) : build_ast_antlr(file, options);
     if(!ast)
         return 1;
+    if (options.print_ast)
+        ast->print_debug_infos();
 
     IR ir(writer, options.input_file);
-    ast->build_ir(ir);
-    // ir.print_debug_infos();
+    {
+        PhaseTimer timer("ast-to-ir");
+        ast->build_ir(ir);
+    }
+    // the IR no longer needs the AST, all its nodes are freed at once
+    delete ast;
+    if (options.print_ir)
+        ir.print_debug_infos();
+    EdgeProfile profile(options);
+    {
+        PhaseTimer timer("profile");
+        if (!options.profile_generate.empty())
+            profile.instrument(ir);
+        if (!options.profile_use.empty())
+            profile.annotate(ir);
+    }
+    {
+        PhaseTimer timer("optimization");
+        Optimizer optimizer(options);
+        optimizer.run(ir);
+    }
+    for (CFG* cfg : ir.get_cfgs())
+        Statistics::add_cfg(cfg, options);
+    if (options.print_block_freq)
+        ir.print_block_frequencies();
     if(!writer.error_occurred && options.generate_assembly)
+    {
+        PhaseTimer timer("codegen");
         ir.gen_asm();
+        if (!options.profile_generate.empty())
+            profile.gen_asm(writer);
+        writer.flush();
+    }
 
+    if (options.time_report || options.mem_report)
+        TimeReport::print();
+    if (!options.stats.empty())
+        Statistics::print(options.stats == "json");
+    if (!options.time_trace.empty() && !TimeReport::write_trace(options.time_trace))
+        Writer::error() << "could not write into " << options.time_trace << std::endl;
     return writer.error_occurred;
 }
@@ -0,0 +1,18 @@
+int check(int x)
+{
+  if (__builtin_expect(x < 0, 0)) {
+    putchar('!');
+    return -1;
+  }
+  return x * 2;
+}
+
+int main()
+{
+  int s = 0;
+  int i;
+  for (i = 0; i < 10; ++i)
+    s = s + check(i - 1);
+  putchar('\n');
+  return s;
+}
@@ -0,0 +1,35 @@
+int64_t sum(int from, int to)
+{
+  int64_t s = 0;
+  int i;
+  for (i = from; i < to; ++i)
+    s = s + i;
+  return s;
+}
+
+int64_t squares(int n)
+{
+  int64_t s = 1;
+  int i;
+  int last = 0;
+  for (i = n; i >= 0; i = i - 2) {
+    s = s + 3 * i + 1;
+    last = i * 5;
+  }
+  return s + last;
+}
+
+int64_t lshift(int64_t n, int p)
+{
+  while (--p + 1)
+    n = n * 2;
+  return n;
+}
+
+int main()
+{
+  int64_t r = sum(0, 10) + sum(-5, 5) + sum(7, 3) + squares(11) + squares(-3);
+  if (lshift(3, 4) != 48 || lshift(1, 62) <= 0 || lshift(-1, 63) >= 0 || lshift(-1, 62) * 2 != lshift(-1, 63))
+    return 1;
+  return r & 127;
+}
@@ -0,0 +1,18 @@
+int main()
+{
+  int i = 0;
+  int s = 0;
+  for (; i < 4;)
+  {
+    s = s + i;
+    i = i + 1;
+  }
+  for (i = 10; i > 7;)
+    s = s + --i;
+  for (;; ++i)
+  {
+    if (i > 12)
+      return s * 2 + i;
+  }
+  return 0;
+}
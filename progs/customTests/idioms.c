@@ -0,0 +1,84 @@
+int absolute(int x)
+{
+  if (x < 0)
+    x = -x;
+  return x;
+}
+
+int64_t distance(int64_t a, int64_t b)
+{
+  int64_t d;
+  d = a - b;
+  if (0 <= d) {} else d = -d;
+  return d;
+}
+
+int minimum(int a, int b)
+{
+  int m;
+  if (a < b)
+    m = a;
+  else
+    m = b;
+  return m;
+}
+
+char maximum(char a, char b)
+{
+  if (a <= b)
+    a = b;
+  return a;
+}
+
+int popcount(int x)
+{
+  int c = 0;
+  while (x) {
+    c = c + (x & 1);
+    x = x / 2;
+  }
+  return c;
+}
+
+int bit_length(int64_t x)
+{
+  int c = 0;
+  while (x != 0) {
+    x = x / 2;
+    ++c;
+  }
+  return c;
+}
+
+int leading_zeros(int x)
+{
+  int c = 0;
+  while (x > 0) {
+    x = x * 2;
+    c = c + 1;
+  }
+  return c;
+}
+
+int trailing_zeros(int64_t x)
+{
+  int c = 0;
+  while (x % 2 == 0) {
+    x = x / 2;
+    ++c;
+  }
+  return c + x;
+}
+
+int main()
+{
+  int s = 0;
+  int i;
+  for (i = -40; i < 40; ++i)
+    s = s + absolute(i * 37) + distance(i, 3) + minimum(i, 5 - i) + maximum(i, 'a' - i);
+  for (i = -300; i < 300; i = i + 7)
+    s = s + popcount(i * 1001) + bit_length(i * 12345) + leading_zeros(i * 99) + trailing_zeros(i * 64 + 1 - (i == 0));
+  putchar(s % 26 + 'a');
+  putchar('\n');
+  return s % 100;
+}
@@ -0,0 +1,50 @@
+int clamp(int x, int lo, int hi)
+{
+  if (x < lo)
+    x = lo;
+  if (x > hi)
+    x = hi;
+  return x;
+}
+
+int64_t blend(int64_t a, int64_t b, int c)
+{
+  int64_t y;
+  if (c)
+    y = a + b;
+  else
+    y = a - 2 * b;
+  return y;
+}
+
+int main()
+{
+  int s = 0;
+  int count = 0;
+  int flag;
+  int other;
+  char c;
+  int i;
+  for (i = -50; i < 50; ++i) {
+    if (i % 3 == 1)
+      ++count;
+    if (i % 5 < 2)
+      --count;
+    if (i * i > 300)
+      flag = 1;
+    else
+      flag = 0;
+    if (i & 4)
+      other = 0;
+    else
+      other = 1;
+    c = 'a';
+    if (i > 10)
+      c = 'z';
+    s = s + clamp(i * 7, -100, 120) + blend(i, 3, i & 1) + flag * 3 + other + c;
+  }
+  putchar(s % 26 + 'a');
+  putchar(count % 26 + 'a');
+  putchar('\n');
+  return (s + count) % 100;
+}
@@ -0,0 +1,29 @@
+#define likely(x) __builtin_expect((x), 1)
+#define unlikely(x) __builtin_expect((x), 0)
+
+int check(int x)
+{
+  if (unlikely(x < 0)) {
+    putchar('!');
+    if (x < -10)
+      return -2;
+    return -1;
+  }
+  if (__builtin_expect(x == 7, 0))
+    putchar('7');
+  return x * 2;
+}
+
+int main()
+{
+  int s = 0;
+  int i = 0;
+  while (likely(i < 20)) {
+    s = s + check(i - 3);
+    ++i;
+  }
+  for (i = 0; unlikely(i < 3); ++i)
+    s = s + i;
+  putchar('\n');
+  return s % 100;
+}
@@ -0,0 +1,11 @@
+#define likely(x) __builtin_expect((x), 1)
+#define unlikely(x) __builtin_expect((x), 0)
+
+int main()
+{
+  int likely = 3;
+  int unlikely = 4;
+  if (likely(likely < unlikely))
+    return likely + unlikely;
+  return 0;
+}
@@ -0,0 +1,13 @@
+int likely(int x)
+{
+  putchar('L');
+  return x + 1;
+}
+
+int main()
+{
+  int a = likely(1);
+  if (likely(a) == 3)
+    putchar('y');
+  return a * 3;
+}
@@ -0,0 +1,13 @@
+#define likely(x) __builtin_expect(!!(x), 1)
+#define unlikely(x) __builtin_expect(!!(x), 0)
+
+int main()
+{
+  int a = 5;
+  int b = likely(a) + unlikely(a - 5) * 2;
+  if (likely(a))
+    b = b + 4 * likely(a * 7);
+  if (unlikely(a - 5))
+    b = 0;
+  return b * 10 + __builtin_expect(a, 1);
+}
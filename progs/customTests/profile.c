@@ -0,0 +1,15 @@
+int classify(int x)
+{
+  if (x % 4 == 0)
+    return 1;
+  return 0;
+}
+
+int main()
+{
+  int n = 0;
+  int i;
+  for (i = 0; i < 100; ++i)
+    n = n + classify(i);
+  return n;
+}
@@ -0,0 +1,18 @@
+char small(int a) { if (a > 3) return 'y'; return a + 200; }
+int16_t mid(int a) { return a * 1000; }
+int32_t m32(int a) { int32_t r = a; return r = a * 100000; }
+int many(int a) {
+  if (a == 0) return 10;
+  if (a == 1) return -a;
+  if (a == 2) return !a;
+  if (a == 3) return ~a;
+  if (a == 4) return a % 3;
+  if (a == 5) return a && 1;
+  return a / 2;
+}
+int main() {
+  int i;
+  for (i = 0; i < 8; ++i) { putchar('0' + many(i) % 10 + 5); putchar('\n'); }
+  putchar(small(1)); putchar(small(9));
+  return mid(7) + m32(3) % 256 + 3;
+}
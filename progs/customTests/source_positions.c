@@ -0,0 +1,23 @@
+int clamp(int x)
+{
+  int r = x;
+  if (x > 10)
+    r = 10;
+  return r;
+}
+
+int sum(int n)
+{
+  int s = 0;
+  int i = 0;
+  while (i < n) {
+    s = s + i;
+    i = i + 1;
+  }
+  return s;
+}
+
+int main()
+{
+  return clamp(42) + sum(10);
+}
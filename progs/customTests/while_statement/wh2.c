@@ -0,0 +1,27 @@
+int count(int n)
+{
+  int i = 0;
+  int k = 0;
+  while (i < n && k < 1000) {
+    int j = 0;
+    while (j < i) {
+      if (j == 7)
+        return k;
+      ++j;
+      ++k;
+    }
+    ++i;
+  }
+  return k;
+}
+
+int main()
+{
+  int s = 0;
+  int i;
+  for (i = 0; i < 10 || s < 3; ++i)
+    s = s + count(i);
+  while (s > 200)
+    s = s - 7;
+  return s;
+}
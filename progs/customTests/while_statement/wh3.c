@@ -0,0 +1,21 @@
+int scale(int n, int mode, int step)
+{
+  int i = 0;
+  int s = 0;
+  while (i < n) {
+    if (mode == 2)
+      s = s + i * step;
+    else
+      s = s - i;
+    if (step)
+      ++s;
+    ++i;
+  }
+  return s;
+}
+
+int main()
+{
+  int r = scale(10, 2, 3) + scale(10, 1, 0);
+  return r & 127;
+}
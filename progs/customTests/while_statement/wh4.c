@@ -0,0 +1,10 @@
+int main()
+{
+  char c = 0;
+  int k = 0;
+  while (c < 120) {
+    c = c + 50;
+    k = k + 1;
+  }
+  return k;
+}
@@ -0,0 +1,15 @@
+int count(int n)
+{
+  char c = n;
+  int k = 0;
+  while (c != 0) {
+    c = c + 1;
+    ++k;
+  }
+  return k;
+}
+
+int main()
+{
+  return count(5) / 2;
+}
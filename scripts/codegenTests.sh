@@ -0,0 +1,169 @@
+#!/bin/bash
+
+# Compiles programs of progs/ with some options, checks the generated
+# assembly, and checks that the programs print and return the same as when
+# they are compiled by gcc.
+
+if [ -z "$BRUTUS" ]; then
+    BRUTUS=./Brutus
+fi
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+let "testsOk = 0"
+let "nbTests = 0"
+
+# brutus <source> [options] : compiles into $tmp/brutus.s, then $tmp/brutus
+brutus()
+{
+    local source=$1
+    shift
+    $BRUTUS "$@" -o $tmp/brutus.s $source > $tmp/brutus.log 2>&1 && gcc -no-pie $tmp/brutus.s -o $tmp/brutus >> $tmp/brutus.log 2>&1
+}
+
+# same_result <source> [options] : the program compiled by Brutus with the
+# options has the standard output and the return code of the one of gcc
+same_result()
+{
+    gcc -w -Wno-error=implicit-function-declaration -include stdint.h $1 -o $tmp/gcc || return 1
+    brutus "$@" || return 1
+    $tmp/gcc > $tmp/gcc.out 2> /dev/null
+    echo "return $?" >> $tmp/gcc.out
+    $tmp/brutus > $tmp/brutus.out 2> /dev/null
+    echo "return $?" >> $tmp/brutus.out
+    cmp -s $tmp/gcc.out $tmp/brutus.out
+}
+
+# check <description> <function> : one test, passed if the function succeeds
+check()
+{
+    echo "Testing" $1 :
+    let "nbTests = nbTests + 1"
+    if $2
+    then echo "OK" && let "testsOk = testsOk + 1"
+    else echo "Error" && cat $tmp/brutus.log 2> /dev/null
+    fi
+    echo ""
+}
+
+# ------------------------------------------------------------------ epilogues
+
+# a small epilogue is copied at each return, there is no jump to the exit block
+duplicated_epilogue()
+{
+    same_result progs/customTests/returns.c && ! grep -q "jmp .many_block1$" $tmp/brutus.s
+}
+check "duplicated epilogues" duplicated_epilogue
+
+# -finstrument-functions makes the epilogue too large to be copied
+jump_to_epilogue()
+{
+    same_result progs/customTests/returns.c -finstrument-functions && grep -q "jmp .many_block1$" $tmp/brutus.s
+}
+check "jumps to the epilogue" jump_to_epilogue
+
+# ---------------------------------------------------------- debug information
+
+# each function opens and closes its frame information once, and starts at
+# the line of its definition
+frame_information()
+{
+    brutus progs/customTests/source_positions.c -O || return 1
+    for function in clamp:1 sum:9 main:20
+    do
+        local name=${function%:*}
+        sed -n "/^$name:/,/\.size.*$name,/p" $tmp/brutus.s > $tmp/function.s
+        grep -q "\.type.*$name, @function" $tmp/brutus.s || return 1
+        [[ $(grep -c "\.cfi_startproc" $tmp/function.s) == 1 && $(grep -c "\.cfi_endproc" $tmp/function.s) == 1 ]] || return 1
+        [[ $(grep -c "\.cfi_remember_state" $tmp/function.s) == $(grep -c "\.cfi_restore_state" $tmp/function.s) ]] || return 1
+        [[ $(grep -m 1 "\.loc" $tmp/function.s) == *".loc 1 ${function#*:} 1" ]] || return 1
+    done
+}
+check ".cfi and .loc directives" frame_information
+
+# the select created by the if-conversion is at the line of the if it replaces
+optimized_source_positions()
+{
+    same_result progs/customTests/source_positions.c -O &&
+    [[ $(awk '/\.loc/ { loc = $0 } /cmov/ { print loc; exit }' $tmp/brutus.s) == *".loc 1 4 7" ]]
+}
+check "source positions of the optimized code" optimized_source_positions
+
+# ------------------------------------------------------------------ profiles
+
+# the block weighted as unlikely by __builtin_expect is moved into .text.unlikely
+cold_partition()
+{
+    same_result progs/customTests/cold_blocks.c -freorder-blocks-and-partition &&
+    grep -q "section.*\.text\.unlikely" $tmp/brutus.s &&
+    sed -n "/^check\.cold:/,/size.*check\.cold/p" $tmp/brutus.s | grep -q "^\.check_block2:"
+}
+check "-freorder-blocks-and-partition" cold_partition
+
+# the static frequencies, relative to one call of the function
+block_frequencies()
+{
+    brutus progs/customTests/cold_blocks.c -print-block-freq &&
+    grep -q -F ".check_block0 : 1.000, -> .check_block2 (10%), -> .check_block3 (90%)" $tmp/brutus.log &&
+    grep -q -F ".check_block2 : 0.100" $tmp/brutus.log &&
+    grep -q -F ".main_block4 : 11.286, -> .main_block2 (91%), -> .main_block6 (9%)" $tmp/brutus.log
+}
+check "-print-block-freq" block_frequencies
+
+# the counts of a run of the program compiled with -fprofile-generate replace
+# the static estimation with -fprofile-use: x % 4 == 0 is true 25% of the time
+profile_round_trip()
+{
+    rm -f $tmp/brutus.prof
+    same_result progs/customTests/profile.c -fprofile-generate=$tmp/brutus.prof &&
+    grep -q "^classify [0-9]* 2$" $tmp/brutus.prof &&
+    brutus progs/customTests/profile.c -fprofile-use=$tmp/brutus.prof -print-block-freq &&
+    grep -q -F ".classify_block0 : 1.000, -> .classify_block2 (25%), -> .classify_block3 (75%)" $tmp/brutus.log &&
+    grep -q -F ".main_block4 : 101.000, -> .main_block2 (99%), -> .main_block6 (1%)" $tmp/brutus.log &&
+    same_result progs/customTests/profile.c -O -fprofile-use=$tmp/brutus.prof
+}
+check "-fprofile-generate then -fprofile-use" profile_round_trip
+
+# --------------------------------------------------------------- branch hints
+
+# likely and unlikely are identifiers, their calls of one argument are hints
+# worth 0 or 1, unless the program defines functions with these names
+hint_identifiers()
+{
+    same_result progs/customTests/if_condition/if12.c && same_result progs/customTests/if_condition/if11.c &&
+    same_result progs/customTests/if_condition/if13.c && same_result progs/customTests/if_condition/if14.c
+}
+check "likely and unlikely" hint_identifiers
+
+# ---------------------------------------------------------------- expressions
+
+# a chain of 100k operands is a single flat expression, built by both front
+# ends and lowered without recursing once per operand
+deep_expression()
+{
+    { echo "int main() { int x = 3; return x"; printf ' + x * 2 - 1 + (x - 2)%.0s' $(seq 25000); echo "; }"; } > $tmp/deep.c
+    same_result $tmp/deep.c --frontend=antlr && same_result $tmp/deep.c --frontend=fast
+}
+check "expression of 100k operands" deep_expression
+
+# ---------------------------------------------------------------------- loops
+
+# the loops replaced by their closed form with -O, narrow counters included,
+# and the for statements without some of their expressions
+optimized_loop()
+{
+    same_result $source -O
+}
+for source in $(find progs/customTests/while_statement progs/customTests/for_statement -name "*.c")
+do
+    check "$source -O" optimized_loop
+done
+
+echo "Number of tests : $nbTests"
+echo "Number of tests passed : $testsOk"
+
+if [[ $testsOk == $nbTests ]]
+then exit 0
+else exit $(($nbTests - $testsOk))
+fi
@@ -0,0 +1,88 @@
+#!/bin/bash
+
+# Compiles every program with --frontend=antlr and --frontend=fast and checks
+# that both front ends build the same AST, printed by -print-ast, and the same
+# IR, printed by -print-ir before the optimizations, and give the same
+# assembly, output, diagnostics and return code. The whole standard error is compared, but for the known differences
+# between the front ends:
+#  - ANTLR recovers from a syntax error and reports the next ones, the fast
+#    parser stops at the first: the ANTLR errors after the first syntax error
+#    are dropped before the comparison.
+# The other ones are not met by the programs of progs/:
+#  - CProg.g4 does not end the program with EOF, ANTLR stops without an error
+#    at a token after the functions which starts none, the fast parser reports
+#    it;
+#  - ANTLR reports a missing token when the next one may follow it in the exact
+#    rule context, the fast parser when it may follow it in some context;
+#  - before an expression of for which may be left out, ANTLR also expects the
+#    ';' or ')' after it;
+#  - before a syntax error, the fast parser reports the declarations of a void
+#    or unknown type it has parsed, ANTLR only the syntax errors.
+
+if [ -z "$BRUTUS" ]; then
+    BRUTUS=./Brutus
+fi
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+let "progsOk = 0"
+let "nbProgs = 0"
+for progs in $(find progs -name "*.c")
+do
+    for options in "" "-O -fhash-cons -stats"
+    do
+        echo "Testing" $progs $options :
+        let "nbProgs = nbProgs + 1"
+        for frontend in antlr fast
+        do
+            rm -f $tmp/$frontend.s
+            $BRUTUS --frontend=$frontend -print-ast -print-ir $options -o $tmp/$frontend.s $progs > $tmp/$frontend.out 2> $tmp/$frontend.err
+            echo $? > $tmp/$frontend.code
+        done
+
+        # the errors of the lexer come before the syntax errors
+        awk '/error: .*line [0-9]+:[0-9]+ / && !/token recognition error/ { if (syntaxErrors++) next } { print }' $tmp/antlr.err > $tmp/antlr.first.err
+
+        if ! cmp -s $tmp/antlr.code $tmp/fast.code
+        then echo "Error: different return codes"
+        elif ! cmp -s $tmp/antlr.first.err $tmp/fast.err
+        then echo "Error: different AST, IR or diagnostics" && diff $tmp/antlr.first.err $tmp/fast.err | head -20
+        elif ! cmp -s $tmp/antlr.out $tmp/fast.out
+        then echo "Error: different outputs" && diff $tmp/antlr.out $tmp/fast.out | head -20
+        elif [[ -f $tmp/antlr.s ]] && ! cmp -s $tmp/antlr.s $tmp/fast.s
+        then echo "Error: different assembly" && diff $tmp/antlr.s $tmp/fast.s | head -20
+        else echo "OK" && let "progsOk = progsOk + 1"
+        fi
+        echo ""
+    done
+done
+
+# the fast front end stops at a nesting limit with a syntax error instead of
+# overflowing the stack, the ANTLR one has no such limit
+repeat()
+{
+    printf -- "$1%.0s" $(seq $2)
+}
+for deep in "return $(repeat '(' 30000)1$(repeat ')' 30000);" "return $(repeat '-~' 20000)1;" "$(repeat '{' 30000)return 1;$(repeat '}' 30000)"
+do
+    echo "Testing" "${deep:0:16}..." --frontend=fast :
+    let "nbProgs = nbProgs + 1"
+    echo "int main(){ $deep }" > $tmp/deep.c
+    $BRUTUS --frontend=fast -o $tmp/deep.s $tmp/deep.c > /dev/null 2> $tmp/fast.err
+    if [[ $? == 1 ]] && grep -q "line 1:[0-9]* nested more than" $tmp/fast.err
+    then echo "OK" && let "progsOk = progsOk + 1"
+    else echo "Error: no syntax error for the nesting" && cat $tmp/fast.err
+    fi
+    echo ""
+done
+
+let "ratio = progsOk*100/nbProgs"
+echo "Number of programs : $nbProgs"
+echo "Number of tests passed : $progsOk"
+echo "ratio : $ratio % "
+
+if [[ $progsOk == $nbProgs ]]
+then exit 0
+else exit $(($nbProgs - $progsOk))
+fi